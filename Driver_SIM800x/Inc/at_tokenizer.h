@@ -0,0 +1,132 @@
+/**
+ * @file 	at_tokenizer.h
+ * @brief	Streaming tokenizer of the SIM responses: it splits the received bytes into <CR><LF> lines and
+ * 			recognizes the final result codes of the AT commands in a single pass.
+ * @note	This module does not depend on the HAL, so it can be compiled and tested on a host
+ * 			by feeding it with recorded SIM responses.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#ifndef SIM800X_INC_AT_TOKENIZER_H_
+#define SIM800X_INC_AT_TOKENIZER_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "at_matcher.h"
+
+/**
+ * @typedef	bool_t
+ * @brief	A type definition for bool
+ * */
+typedef bool bool_t;
+
+/**
+ * @def		AT_LINE_SIZE
+ * @brief	Defines the number of characters of each line kept to recognize the result code.
+ * 			Longer lines are stored in the response buffer but can only match a prefix result code.
+ * */
+#define AT_LINE_SIZE								32U
+
+/**
+ * @enum	atResult_t
+ * @brief	Type of enumeration for the final result codes returned by the SIM.
+ * @note	AT_RESULT_NONE means that no final result code has been received yet.
+ * 			AT_RESULT_PROMPT is the "> " prompt that requests the data of AT+CMGS and AT+CIPSEND.
+ * 			AT_RESULT_IP_ADDRESS is a line with the dotted local IP address, the only response of AT+CIFSR.
+ * 			AT_RESULT_STATE is the line "STATE: <state>" that AT+CIPSTATUS sends after its OK.
+ * 			AT_RESULT_CONNECT is the line that starts the data mode of a transparent connection.
+ * 			AT_RESULT_DATA_ACCEPT is the line "DATA ACCEPT:<length>" that ends AT+CIPSEND in quick send mode.
+ * 			The masks of results of the commands are 32 bits wide, so there can be at most 32 results.
+ * */
+typedef enum
+{
+	AT_RESULT_NONE = 0,
+	AT_RESULT_OK,
+	AT_RESULT_ERROR,
+	AT_RESULT_CME_ERROR,
+	AT_RESULT_CMS_ERROR,
+	AT_RESULT_SEND_OK,
+	AT_RESULT_SEND_FAIL,
+	AT_RESULT_CONNECT_OK,
+	AT_RESULT_CONNECT_FAIL,
+	AT_RESULT_ALREADY_CONNECT,
+	AT_RESULT_SHUT_OK,
+	AT_RESULT_CLOSE_OK,
+	AT_RESULT_PROMPT,
+	AT_RESULT_IP_ADDRESS,
+	AT_RESULT_STATE,
+	AT_RESULT_CONNECT,
+	AT_RESULT_DATA_ACCEPT
+}atResult_t;
+
+/**
+ * @struct	atView_t
+ * @brief	Text of a response, or part of it, seen in place: pointer and length, without copy and without '\0'.
+ * @note	pData is NULL in an empty view. A view is only valid while the buffer it points to is not reused.
+ * */
+typedef struct
+{
+	const uint8_t	*pData;
+	uint16_t		length;
+}atView_t;
+
+/**
+ * @typedef	atLineFilter_t
+ * @brief	Function called with each completed line before it is compared with the result codes.
+ * @note	If it returns true the line has been consumed, for example as an unsolicited result code, and it is
+ * 			removed from the response buffer.
+ * */
+typedef bool_t (*atLineFilter_t)(const uint8_t *pLine, uint8_t length, void *pContext);
+
+/**
+ * @struct	atTokenizer_t
+ * @brief	Tokenizer state.
+ * @note	The whole response, including the <CR><LF> of each line, is copied to the buffer passed to
+ * 			at_Tokenizer_Init(), which always remains terminated with '\0'. When the buffer is full the
+ * 			copy stops and overflow is set, but the lines are still recognized, so the final result code is
+ * 			never lost. lineStart is the position in the buffer of the line being received.
+ * 			If a matcher is set, every byte of the lines is also passed to it: hits has the keywords found
+ * 			in the completed lines, the lines consumed by the line filter do not count.
+ * 			stop is set with at_Tokenizer_Stop() by the line filter to end the feed after the line.
+ * 			The "> " prompt is only recognized while promptExpected is set with at_Tokenizer_Expect_Prompt(),
+ * 			so any other line that starts with '>', for example the text of an SMS, is a normal line.
+ * */
+typedef struct
+{
+	uint8_t			*pBuffer;
+	uint16_t		size;
+	uint16_t		length;
+	uint16_t		lineStart;
+	bool_t			overflow;
+	uint8_t			line[AT_LINE_SIZE];
+	uint8_t			lineLength;
+	bool_t			lineTruncated;
+	atResult_t		result;
+	atLineFilter_t	lineFilter;
+	void			*pFilterContext;
+	const atMatcher_t *pMatcher;
+	uint8_t			matchState;
+	uint32_t		lineHits;
+	uint32_t		hits;
+	bool_t			stop;
+	bool_t			promptExpected;
+}atTokenizer_t;
+
+void		at_Tokenizer_Init(atTokenizer_t *pTokenizer, uint8_t *pBuffer, uint16_t size);
+void		at_Tokenizer_Set_Buffer(atTokenizer_t *pTokenizer, uint8_t *pBuffer, uint16_t size);
+void		at_Tokenizer_Set_Filter(atTokenizer_t *pTokenizer, atLineFilter_t lineFilter, void *pContext);
+void		at_Tokenizer_Set_Matcher(atTokenizer_t *pTokenizer, const atMatcher_t *pMatcher);
+void		at_Tokenizer_Expect_Prompt(atTokenizer_t *pTokenizer, bool_t expected);
+atResult_t	at_Tokenizer_Feed(atTokenizer_t *pTokenizer, const uint8_t *pData, uint16_t length, uint16_t *pConsumed);
+void		at_Tokenizer_Stop(atTokenizer_t *pTokenizer);
+bool_t		at_Result_Is_Error(atResult_t result);
+bool_t		at_View_Next_Line(atView_t *pText, atView_t *pLine);
+bool_t		at_View_Starts_With(const atView_t *pView, const char *pText);
+bool_t		at_View_Equals(const atView_t *pView, const char *pText);
+bool_t		at_View_Contains(const atView_t *pView, const char *pText);
+
+#endif /* SIM800X_INC_AT_TOKENIZER_H_ */
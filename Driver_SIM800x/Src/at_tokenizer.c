@@ -0,0 +1,404 @@
+/**
+ * @file 	at_tokenizer.c
+ * @brief	This file presents the source code for the implementation of each function prototype
+ * 			described in the at_tokenizer.h file.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include "at_tokenizer.h"
+
+/**
+ * @struct	atResultCode_t
+ * @brief	Text of a final result code. If prefix is true, the line only has to start with the text,
+ * 			for example "+CME ERROR: 10".
+ * */
+typedef struct
+{
+	const char	*pText;
+	uint8_t		length;
+	bool_t		prefix;
+	atResult_t	result;
+}atResultCode_t;
+
+#define AT_RESULT_CODE(text, prefix, result)		{(text), (uint8_t)(sizeof(text) - 1U), (prefix), (result)}
+
+static const atResultCode_t atResultCodes[] = {
+	AT_RESULT_CODE("OK",				false,	AT_RESULT_OK),
+	AT_RESULT_CODE("ERROR",				false,	AT_RESULT_ERROR),
+	AT_RESULT_CODE("+CME ERROR:",		true,	AT_RESULT_CME_ERROR),
+	AT_RESULT_CODE("+CMS ERROR:",		true,	AT_RESULT_CMS_ERROR),
+	AT_RESULT_CODE("SEND OK",			false,	AT_RESULT_SEND_OK),
+	AT_RESULT_CODE("SEND FAIL",			false,	AT_RESULT_SEND_FAIL),
+	AT_RESULT_CODE("CONNECT OK",		false,	AT_RESULT_CONNECT_OK),
+	AT_RESULT_CODE("CONNECT FAIL",		false,	AT_RESULT_CONNECT_FAIL),
+	AT_RESULT_CODE("ALREADY CONNECT",	false,	AT_RESULT_ALREADY_CONNECT),
+	AT_RESULT_CODE("SHUT OK",			false,	AT_RESULT_SHUT_OK),
+	AT_RESULT_CODE("CLOSE OK",			false,	AT_RESULT_CLOSE_OK),
+	AT_RESULT_CODE("STATE:",			true,	AT_RESULT_STATE),
+	AT_RESULT_CODE("CONNECT",			false,	AT_RESULT_CONNECT),
+	AT_RESULT_CODE("DATA ACCEPT:",		true,	AT_RESULT_DATA_ACCEPT),
+};
+
+/*--------------------- Prototypes of private functions ----------------------*/
+static void store_Bytes_Tokenizer(atTokenizer_t *pTokenizer, const uint8_t *pData, uint16_t length);
+static void remove_Line_Tokenizer(atTokenizer_t *pTokenizer);
+static atResult_t classify_Line_Tokenizer(const atTokenizer_t *pTokenizer);
+static bool_t is_IP_Address_Line(const atTokenizer_t *pTokenizer);
+
+/**
+ * @brief	Initializes the tokenizer to receive a new response.
+ * @param	Pointer to the tokenizer.
+ * @param	Pointer to the buffer where the response is copied, or NULL to only recognize the result code.
+ * @param	Size of the buffer, including the '\0' terminator.
+ * @retval 	None.
+ */
+void at_Tokenizer_Init(atTokenizer_t *pTokenizer, uint8_t *pBuffer, uint16_t size)
+{
+	pTokenizer->lineLength = 0;
+	pTokenizer->lineTruncated = false;
+	pTokenizer->lineFilter = NULL;
+	pTokenizer->pFilterContext = NULL;
+	pTokenizer->promptExpected = false;
+
+	at_Tokenizer_Set_Matcher(pTokenizer, NULL);
+	at_Tokenizer_Set_Buffer(pTokenizer, pBuffer, size);
+}
+
+/**
+ * @brief	Changes the buffer of the response, keeping the line in progress, the line filter and the matcher.
+ * @note	It is used to start a new response without losing the unsolicited line that may be arriving.
+ * @param	Pointer to the tokenizer.
+ * @param	Pointer to the buffer where the response is copied, or NULL to only recognize the result code.
+ * @param	Size of the buffer, including the '\0' terminator.
+ * @retval 	None.
+ */
+void at_Tokenizer_Set_Buffer(atTokenizer_t *pTokenizer, uint8_t *pBuffer, uint16_t size)
+{
+	pTokenizer->pBuffer = pBuffer;
+	pTokenizer->size = (pBuffer != NULL) ? size : 0;
+	pTokenizer->length = 0;
+	pTokenizer->lineStart = 0;
+	pTokenizer->overflow = false;
+	pTokenizer->result = AT_RESULT_NONE;
+
+	if(pTokenizer->size != 0)
+		pTokenizer->pBuffer[0] = '\0';
+}
+
+/**
+ * @brief	Sets the function that receives each completed line before it is classified.
+ * @param	Pointer to the tokenizer.
+ * @param	Line filter, NULL to classify all the lines.
+ * @param	Pointer passed to the line filter.
+ * @retval 	None.
+ */
+void at_Tokenizer_Set_Filter(atTokenizer_t *pTokenizer, atLineFilter_t lineFilter, void *pContext)
+{
+	pTokenizer->lineFilter = lineFilter;
+	pTokenizer->pFilterContext = pContext;
+}
+
+/**
+ * @brief	Sets the keywords searched in the lines of the response and clears the hits.
+ * @param	Pointer to the tokenizer.
+ * @param	Pointer to the compiled matcher, NULL to search no keyword. It must remain valid while it is set.
+ * @retval 	None.
+ */
+void at_Tokenizer_Set_Matcher(atTokenizer_t *pTokenizer, const atMatcher_t *pMatcher)
+{
+	pTokenizer->pMatcher = pMatcher;
+	pTokenizer->matchState = 0;
+	pTokenizer->lineHits = 0;
+	pTokenizer->hits = 0;
+}
+
+/**
+ * @brief	Enables or disables the recognition of the "> " prompt.
+ * @note	It is enabled while a command waits for the prompt to send its data, and disabled once the prompt
+ * 			is received, so the echo of the data is never taken for a second prompt.
+ * @param	Pointer to the tokenizer.
+ * @param	true to recognize the prompt, false to handle the lines that start with '>' as normal lines.
+ * @retval 	None.
+ */
+void at_Tokenizer_Expect_Prompt(atTokenizer_t *pTokenizer, bool_t expected)
+{
+	pTokenizer->promptExpected = expected;
+}
+
+/**
+ * @brief	Processes the bytes received from the SIM until a final result code is recognized.
+ * @note	Each byte is visited once. <CR> is ignored and <LF> ends the line, which is copied to the response
+ * 			buffer in a single block and then compared with the
+ * 			result codes. While the prompt is expected, a line "> " is recognized as soon as the space arrives,
+ * 			because the SIM does not send <CR><LF> after the prompt; the recognition then stops until it is
+ * 			expected again. The bytes after the final result code are not consumed.
+ * 			The lines consumed by the line filter are removed from the response buffer and never classified.
+ * 			The result codes of the multi-connection mode, "<n>, <result>", are classified as <result>.
+ * 			The keywords of the matcher are searched in the same pass, also in the bytes that do not fit in the
+ * 			response buffer.
+ * @param	Pointer to the tokenizer.
+ * @param	Pointer to the received bytes.
+ * @param	Number of received bytes.
+ * @param	Pointer where the number of bytes consumed is stored, it can be NULL.
+ * @retval 	Final result code, or AT_RESULT_NONE if the bytes did not complete one.
+ */
+atResult_t at_Tokenizer_Feed(atTokenizer_t *pTokenizer, const uint8_t *pData, uint16_t length, uint16_t *pConsumed)
+{
+	atResult_t result = AT_RESULT_NONE;
+	uint16_t runStart = 0;
+	uint16_t i;
+	uint8_t data;
+
+	pTokenizer->stop = false;
+
+	for(i = 0; (i < length) && (result == AT_RESULT_NONE) && (pTokenizer->stop == false); i++)
+	{
+		data = pData[i];
+
+		if(data == '\n')
+		{
+			store_Bytes_Tokenizer(pTokenizer, &pData[runStart], i + 1U - runStart);
+			runStart = i + 1U;
+
+			if((pTokenizer->lineLength != 0) && (pTokenizer->lineFilter != NULL)
+					&& (pTokenizer->lineFilter(pTokenizer->line, pTokenizer->lineLength, pTokenizer->pFilterContext) == true))
+				remove_Line_Tokenizer(pTokenizer);
+			else if(pTokenizer->lineLength != 0)
+			{
+				pTokenizer->hits |= pTokenizer->lineHits;
+				result = classify_Line_Tokenizer(pTokenizer);
+			}
+
+			pTokenizer->matchState = 0;
+			pTokenizer->lineHits = 0;
+			pTokenizer->lineStart = pTokenizer->length;
+			pTokenizer->lineLength = 0;
+			pTokenizer->lineTruncated = false;
+		}
+		else if((data == ' ') && (pTokenizer->promptExpected == true) && (pTokenizer->lineLength == 1)
+				&& (pTokenizer->line[0] == '>'))
+		{
+			/* The prompt stays in the response buffer as an empty line */
+			result = AT_RESULT_PROMPT;
+			pTokenizer->promptExpected = false;
+			pTokenizer->matchState = 0;
+			pTokenizer->lineHits = 0;
+			pTokenizer->lineLength = 0;
+		}
+		else if(data != '\r')
+		{
+			if(pTokenizer->pMatcher != NULL)
+				pTokenizer->matchState = at_Matcher_Step(pTokenizer->pMatcher, pTokenizer->matchState, data, &pTokenizer->lineHits);
+
+			if(pTokenizer->lineLength < AT_LINE_SIZE)
+				pTokenizer->line[pTokenizer->lineLength++] = data;
+			else
+				pTokenizer->lineTruncated = true;
+		}
+	}
+
+	/* The rest of the line in progress, or the '>' prompt */
+	store_Bytes_Tokenizer(pTokenizer, &pData[runStart], i - runStart);
+
+	pTokenizer->result = result;
+	if(pConsumed != NULL)
+		*pConsumed = i;
+
+	return result;
+}
+
+/**
+ * @brief	Ends the feed in progress after the current line, the next bytes are not consumed.
+ * @note	It is called from the line filter when the bytes after the line are not text, for example the data
+ * 			announced by a URC.
+ * @param	Pointer to the tokenizer.
+ * @retval 	None.
+ */
+void at_Tokenizer_Stop(atTokenizer_t *pTokenizer)
+{
+	pTokenizer->stop = true;
+}
+
+/**
+ * @brief	Checks if the final result code reports a failure of the command.
+ * @param	Final result code.
+ * @retval 	Returns true for ERROR, +CME ERROR, +CMS ERROR, SEND FAIL and CONNECT FAIL, otherwise false.
+ */
+bool_t at_Result_Is_Error(atResult_t result)
+{
+	return (result == AT_RESULT_ERROR) || (result == AT_RESULT_CME_ERROR) || (result == AT_RESULT_CMS_ERROR)
+			|| (result == AT_RESULT_SEND_FAIL) || (result == AT_RESULT_CONNECT_FAIL);
+}
+
+/**
+ * @brief	Splits the next line of a text, skipping the empty lines.
+ * @note	The lines end with <CR><LF>, which is not part of the line. The text view is advanced past the line.
+ * @param	Pointer to the view of the text, for example the response of a command.
+ * @param	Pointer to the view where the line is stored.
+ * @retval 	Returns true if a line was found, false at the end of the text.
+ */
+bool_t at_View_Next_Line(atView_t *pText, atView_t *pLine)
+{
+	uint16_t start = 0;
+	uint16_t end;
+
+	while((start < pText->length) && ((pText->pData[start] == '\r') || (pText->pData[start] == '\n')))
+		start++;
+
+	end = start;
+	while((end < pText->length) && (pText->pData[end] != '\r') && (pText->pData[end] != '\n'))
+		end++;
+
+	pLine->pData = (end != start) ? &pText->pData[start] : NULL;
+	pLine->length = end - start;
+	pText->pData = (pText->pData != NULL) ? &pText->pData[end] : NULL;
+	pText->length -= end;
+
+	return (pLine->length != 0);
+}
+
+/**
+ * @brief	Checks if the view starts with a text.
+ * @param	Pointer to the view.
+ * @param	Pointer to the text terminated with '\0'.
+ * @retval 	Returns true if the view starts with the text, otherwise false.
+ */
+bool_t at_View_Starts_With(const atView_t *pView, const char *pText)
+{
+	uint16_t textLength = strlen(pText);
+
+	return (pView->pData != NULL) && (pView->length >= textLength) && (memcmp(pView->pData, pText, textLength) == 0);
+}
+
+/**
+ * @brief	Checks if the view is exactly a text.
+ * @param	Pointer to the view.
+ * @param	Pointer to the text terminated with '\0'.
+ * @retval 	Returns true if the view and the text are equal, otherwise false.
+ */
+bool_t at_View_Equals(const atView_t *pView, const char *pText)
+{
+	return (pView->length == strlen(pText)) && (at_View_Starts_With(pView, pText) == true);
+}
+
+/**
+ * @brief	Searches a text in the view.
+ * @param	Pointer to the view.
+ * @param	Pointer to the text terminated with '\0'.
+ * @retval 	Returns true if the text was found, otherwise false.
+ */
+bool_t at_View_Contains(const atView_t *pView, const char *pText)
+{
+	bool_t found = false;
+	uint16_t textLength = strlen(pText);
+	uint16_t i;
+
+	for(i = 0; (pView->pData != NULL) && (i + textLength <= pView->length) && (found == false); i++)
+	{
+		if(memcmp(&pView->pData[i], pText, textLength) == 0)
+			found = true;
+	}
+
+	return found;
+}
+
+/**
+ * @brief	Copies a block of bytes to the response buffer, keeping it terminated with '\0'.
+ * @note	The bytes that do not fit are discarded and overflow is set.
+ * @param	Pointer to the tokenizer.
+ * @param	Pointer to the bytes to copy.
+ * @param	Number of bytes to copy.
+ * @retval 	None.
+ */
+static void store_Bytes_Tokenizer(atTokenizer_t *pTokenizer, const uint8_t *pData, uint16_t length)
+{
+	uint16_t space = (pTokenizer->size != 0) ? (uint16_t)(pTokenizer->size - 1U - pTokenizer->length) : 0U;
+
+	if(length > space)
+	{
+		length = space;
+		pTokenizer->overflow = true;
+	}
+
+	if(length != 0)
+	{
+		memcpy(&pTokenizer->pBuffer[pTokenizer->length], pData, length);
+		pTokenizer->length += length;
+		pTokenizer->pBuffer[pTokenizer->length] = '\0';
+	}
+}
+
+/**
+ * @brief	Removes the completed line from the response buffer.
+ * @param	Pointer to the tokenizer.
+ * @retval 	None.
+ */
+static void remove_Line_Tokenizer(atTokenizer_t *pTokenizer)
+{
+	pTokenizer->length = pTokenizer->lineStart;
+
+	if(pTokenizer->size != 0)
+		pTokenizer->pBuffer[pTokenizer->length] = '\0';
+}
+
+/**
+ * @brief	Compares the completed line with the final result codes.
+ * @param	Pointer to the tokenizer.
+ * @retval 	Final result code, or AT_RESULT_NONE if the line is an information response.
+ */
+static atResult_t classify_Line_Tokenizer(const atTokenizer_t *pTokenizer)
+{
+	atResult_t result = AT_RESULT_NONE;
+	const uint8_t *pLine = pTokenizer->line;
+	uint8_t lineLength = pTokenizer->lineLength;
+	uint8_t i;
+
+	/* Result of a connection in multi-connection mode: "<n>, SEND OK" */
+	if((lineLength > 3U) && (pLine[0] >= '0') && (pLine[0] <= '9') && (pLine[1] == ',') && (pLine[2] == ' '))
+	{
+		pLine = &pLine[3];
+		lineLength -= 3U;
+	}
+
+	for(i = 0; i < sizeof(atResultCodes)/sizeof(atResultCodes[0]); i++)
+	{
+		if(((atResultCodes[i].prefix == true) && (lineLength >= atResultCodes[i].length)) ||
+		   ((lineLength == atResultCodes[i].length) && (pTokenizer->lineTruncated == false)))
+		{
+			if(memcmp(pLine, atResultCodes[i].pText, atResultCodes[i].length) == 0)
+			{
+				result = atResultCodes[i].result;
+				break;
+			}
+		}
+	}
+
+	if((result == AT_RESULT_NONE) && (is_IP_Address_Line(pTokenizer) == true))
+		result = AT_RESULT_IP_ADDRESS;
+
+	return result;
+}
+
+/**
+ * @brief	Checks if the completed line is a dotted IP address, for example "10.152.34.7".
+ * @param	Pointer to the tokenizer.
+ * @retval 	Returns true if the line only has digits and three dots, otherwise false.
+ */
+static bool_t is_IP_Address_Line(const atTokenizer_t *pTokenizer)
+{
+	uint8_t nDots = 0;
+	uint8_t i;
+	bool_t isAddress = (pTokenizer->lineTruncated == false);
+
+	for(i = 0; (i < pTokenizer->lineLength) && (isAddress == true); i++)
+	{
+		if(pTokenizer->line[i] == '.')
+			nDots++;
+		else if((pTokenizer->line[i] < '0') || (pTokenizer->line[i] > '9'))
+			isAddress = false;
+	}
+
+	return (isAddress == true) && (nDots == 3U);
+}
@@ -9,40 +9,51 @@
 
 #include "port.h"
 
-static UART_HandleTypeDef	UARTHandlerPort;
-static UART_HandleTypeDef	*pUARTHandlerPort;
-static GPIO_TypeDef			*resetHandlerPort;
-static GPIO_TypeDef			*powerKeyHandlerPort;
-static uint16_t				_powerKeyPin;
-static uint16_t				_resetPin;
 static const uint16_t 		gpioPin[PINn] = {GPIO_PIN_0,GPIO_PIN_1,GPIO_PIN_2,GPIO_PIN_3,
 											 GPIO_PIN_4,GPIO_PIN_5,GPIO_PIN_6,GPIO_PIN_7,
 											 GPIO_PIN_8,GPIO_PIN_9,GPIO_PIN_10,GPIO_PIN_11,
 											 GPIO_PIN_12,GPIO_PIN_13,GPIO_PIN_14,GPIO_PIN_15,
 											};
-static uint8_t				serialUARTBuffer[MAX_BUFFER_SIZE];
+static portSIM_t			*portInstancesUART[MAX_PORT_INSTANCES];
 
+/*--------------------- Prototypes of private functions ----------------------*/
+static bool_t start_Reception_UART(portSIM_t *pPort);
+static bool_t start_DMA_Reception_UART(portSIM_t *pPort);
+static void transfer_DMA_Data_UART(portSIM_t *pPort);
+static bool_t start_DMA_Transmission_UART(portSIM_t *pPort);
+static bool_t start_Next_TX_UART(portSIM_t *pPort);
+static void complete_TX_UART(portSIM_t *pPort);
+static bool_t reinit_UART(portSIM_t *pPort);
+static void resume_Reception_UART(portSIM_t *pPort);
+static void process_IRQ_UART(portSIM_t *pPort);
+static bool_t register_Port_UART(portSIM_t *pPort);
+static portSIM_t *find_Port_UART(const USART_TypeDef *uartInstance);
+static GPIO_TypeDef *get_GPIO_Port_SIM(Port_t portX);
 
 /**
  * @brief	Initializes the UART peripheral passed as a parameter for communication with the SIM800x.
- * @note	This function only works with USARTx other than USART1, because USART1 is used by default.
+ * @note	Each port must use a different UART: USART1, USART2 or USART6.
+ * @param	Pointer to the port of the SIM.
  * @param	UartHandle pointer to the UART_Handle structure.
  * @retval 	Initialization status. If the initialization was successful it returns true, otherwise it returns false.
  */
-bool_t config_UART_SIM(UART_HandleTypeDef *uartHandler)
+bool_t config_UART_SIM(portSIM_t *pPort, UART_HandleTypeDef *uartHandler)
 {
 	bool_t initStatusUART;
 
-	if(uartHandler != NULL)
+	if((pPort != NULL) && (uartHandler != NULL))
 	{
-		pUARTHandlerPort = uartHandler;
+		pPort->pUARTHandler = uartHandler;
+		pPort->dtrPort = NULL;
+		pPort->riPort = NULL;
+		pPort->ringIndicated = false;
 
 		/* If the maximum baud rate is exceeded for USARTx, the default is 9600 baud */
-		if(pUARTHandlerPort->Init.BaudRate > MAX_BAUD_RATE)
-			pUARTHandlerPort->Init.BaudRate = DEFAULT_BAUD_RATE;
+		if(pPort->pUARTHandler->Init.BaudRate > MAX_BAUD_RATE)
+			pPort->pUARTHandler->Init.BaudRate = DEFAULT_BAUD_RATE;
 
-		/* Initializes USARTx asynchronous mode */
-		if (HAL_UART_Init(pUARTHandlerPort) == HAL_OK)
+		/* Initializes USARTx asynchronous mode and starts the interrupt-driven reception */
+		if ((HAL_UART_Init(pPort->pUARTHandler) == HAL_OK) && (start_Reception_UART(pPort) == SUCCESSFUL))
 			initStatusUART = SUCCESSFUL;
 		else
 			initStatusUART = UNSUCCESSFUL;
@@ -61,10 +72,10 @@ bool_t config_UART_SIM(UART_HandleTypeDef *uartHandler)
 				Reset Pin	: 	PIN_B1, initial state: ON
 			In addition, the SIM remains turn off and reset until the power_On_SIM function is used.
 			This is because some modules do not have the powerKey pin, so we reset the SIM.
- * @param	None.
+ * @param	Pointer to the port of the SIM.
  * @retval 	Initialization status. If the initialization was successful it returns true, otherwise it returns false.
  */
-bool_t config_Default_SIM()
+bool_t config_Default_SIM(portSIM_t *pPort)
 {
 	GPIO_InitTypeDef GPIO_InitStruct={0};
 	bool_t initStatusHwSIM;
@@ -74,44 +85,49 @@ bool_t config_Default_SIM()
 	DEFAULT_RST_GPIO_CLK_ENABLE();
 
 	/* Default pin assignments for reset and powerKey pins */
-	_powerKeyPin = DEFAULT_POWERKEY_PIN;
-	powerKeyHandlerPort = DEFAULT_POWERKEY_GPIO_PORT;
+	pPort->powerKeyPin = DEFAULT_POWERKEY_PIN;
+	pPort->powerKeyPort = DEFAULT_POWERKEY_GPIO_PORT;
 
-	_resetPin = DEFAULT_RST_PIN;
-	resetHandlerPort = DEFAULT_RST_GPIO_PORT;
+	pPort->resetPin = DEFAULT_RST_PIN;
+	pPort->resetPort = DEFAULT_RST_GPIO_PORT;
+
+	/* The sleep pins are optional, see initDTRPin() and initRIPin() */
+	pPort->dtrPort = NULL;
+	pPort->riPort = NULL;
+	pPort->ringIndicated = false;
 
 	/* Configure GPIO pin : Power Key */
-	GPIO_InitStruct.Pin = _powerKeyPin;
+	GPIO_InitStruct.Pin = pPort->powerKeyPin;
 	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
 	GPIO_InitStruct.Pull = GPIO_NOPULL;
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
 
-	HAL_GPIO_Init(powerKeyHandlerPort, &GPIO_InitStruct);
-	HAL_GPIO_WritePin(powerKeyHandlerPort, _powerKeyPin, PWRKEY_OFF);
+	HAL_GPIO_Init(pPort->powerKeyPort, &GPIO_InitStruct);
+	HAL_GPIO_WritePin(pPort->powerKeyPort, pPort->powerKeyPin, PWRKEY_OFF);
 
 	/*Configure GPIO pin : Reset */
-	GPIO_InitStruct.Pin = _resetPin;
+	GPIO_InitStruct.Pin = pPort->resetPin;
 	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
 	GPIO_InitStruct.Pull = GPIO_NOPULL;
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
 
-	HAL_GPIO_Init(resetHandlerPort, &GPIO_InitStruct);
-	HAL_GPIO_WritePin(resetHandlerPort, _resetPin, RST_ON);
+	HAL_GPIO_Init(pPort->resetPort, &GPIO_InitStruct);
+	HAL_GPIO_WritePin(pPort->resetPort, pPort->resetPin, RST_ON);
 
 	/* Configuration parameters for USART1 peripherals */
-	UARTHandlerPort.Instance = DEFAULT_USART;
-	UARTHandlerPort.Init.BaudRate = DEFAULT_BAUD_RATE;
-	UARTHandlerPort.Init.WordLength = UART_WORDLENGTH_8B;
-	UARTHandlerPort.Init.StopBits = UART_STOPBITS_1;
-	UARTHandlerPort.Init.Parity = UART_PARITY_NONE;
-	UARTHandlerPort.Init.Mode = UART_MODE_TX_RX;
-	UARTHandlerPort.Init.HwFlowCtl = UART_HWCONTROL_NONE;
-	UARTHandlerPort.Init.OverSampling = UART_OVERSAMPLING_16;
-
-	pUARTHandlerPort = &UARTHandlerPort;
-
-	/* USART1 initialization with default parameters */
-	if (HAL_UART_Init(pUARTHandlerPort) == HAL_OK)
+	pPort->UARTHandler.Instance = DEFAULT_USART;
+	pPort->UARTHandler.Init.BaudRate = DEFAULT_BAUD_RATE;
+	pPort->UARTHandler.Init.WordLength = UART_WORDLENGTH_8B;
+	pPort->UARTHandler.Init.StopBits = UART_STOPBITS_1;
+	pPort->UARTHandler.Init.Parity = UART_PARITY_NONE;
+	pPort->UARTHandler.Init.Mode = UART_MODE_TX_RX;
+	pPort->UARTHandler.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+	pPort->UARTHandler.Init.OverSampling = UART_OVERSAMPLING_16;
+
+	pPort->pUARTHandler = &pPort->UARTHandler;
+
+	/* USART1 initialization with default parameters and start of the interrupt-driven reception */
+	if ((HAL_UART_Init(pPort->pUARTHandler) == HAL_OK) && (start_Reception_UART(pPort) == SUCCESSFUL))
 		initStatusHwSIM = SUCCESSFUL;
 	else
 		initStatusHwSIM = UNSUCCESSFUL;
@@ -121,11 +137,12 @@ bool_t config_Default_SIM()
 
 /**
  * @brief	Set the GPIO port and pin assigned to powerKey.
+ * @param	Pointer to the port of the SIM.
  * @param	GPIOx specified by an enumeration type Port_t, where x can be A|B|C
  * @param	GPIO_Pin specifies the port bit to be written, where Pin can be [0..15]
  * @retval 	None.
  */
-void initPowerKeyPin(Port_t portX, uint16_t powerKeyPin)
+void initPowerKeyPin(portSIM_t *pPort, Port_t portX, uint16_t powerKeyPin)
 {
 	GPIO_InitTypeDef GPIO_InitStruct={0};
 
@@ -134,45 +151,46 @@ void initPowerKeyPin(Port_t portX, uint16_t powerKeyPin)
 	{
 		case PORTA:
 			__HAL_RCC_GPIOA_CLK_ENABLE();
-			powerKeyHandlerPort = GPIOA;
+			pPort->powerKeyPort = GPIOA;
 			break;
 
 		case PORTB:
 			__HAL_RCC_GPIOB_CLK_ENABLE();
-			powerKeyHandlerPort = GPIOB;
+			pPort->powerKeyPort = GPIOB;
 			break;
 
 		case PORTC:
 			__HAL_RCC_GPIOC_CLK_ENABLE();
-			powerKeyHandlerPort = GPIOC;
+			pPort->powerKeyPort = GPIOC;
 			break;
 		default:
 			DEFAULT_POWERKEY_GPIO_CLK_ENABLE();
-			powerKeyHandlerPort = DEFAULT_POWERKEY_GPIO_PORT;
+			pPort->powerKeyPort = DEFAULT_POWERKEY_GPIO_PORT;
 			break;
 	}
 
 	/* GPIO pin selection for powerKey from the gpioPin array  */
-	_powerKeyPin =  gpioPin[powerKeyPin];
+	pPort->powerKeyPin =  gpioPin[powerKeyPin];
 
 	/*Configure GPIO pin : Power Key_Pin */
-	GPIO_InitStruct.Pin = _powerKeyPin;
+	GPIO_InitStruct.Pin = pPort->powerKeyPin;
 	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
 	GPIO_InitStruct.Pull = GPIO_NOPULL;
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
 
-	HAL_GPIO_Init(powerKeyHandlerPort, &GPIO_InitStruct);
+	HAL_GPIO_Init(pPort->powerKeyPort, &GPIO_InitStruct);
 	/* SIM: Turn off*/
-	HAL_GPIO_WritePin(powerKeyHandlerPort, _powerKeyPin, PWRKEY_OFF);
+	HAL_GPIO_WritePin(pPort->powerKeyPort, pPort->powerKeyPin, PWRKEY_OFF);
 }
 
 /**
  * @brief	Set the GPIO port and pin assigned to reset.
+ * @param	Pointer to the port of the SIM.
  * @param	GPIOx specified by an enumeration type Port_t, where x can be A|B|C
  * @param	GPIO_Pin specifies the port bit to be written, where Pin can be [0..15]
  * @retval 	None.
  */
-void initResetPin(Port_t portX, uint16_t resetPin)
+void initResetPin(portSIM_t *pPort, Port_t portX, uint16_t resetPin)
 {
 	GPIO_InitTypeDef GPIO_InitStruct={0};
 
@@ -180,57 +198,187 @@ void initResetPin(Port_t portX, uint16_t resetPin)
 	{
 		case PORTA:
 			__HAL_RCC_GPIOA_CLK_ENABLE();
-			resetHandlerPort = GPIOA;
+			pPort->resetPort = GPIOA;
 			break;
 
 		case PORTB:
 			__HAL_RCC_GPIOB_CLK_ENABLE();
-			resetHandlerPort = GPIOB;
+			pPort->resetPort = GPIOB;
 			break;
 
 		case PORTC:
 			__HAL_RCC_GPIOC_CLK_ENABLE();
-			resetHandlerPort = GPIOC;
+			pPort->resetPort = GPIOC;
 			break;
 		default:
 			DEFAULT_POWERKEY_GPIO_CLK_ENABLE();
-			resetHandlerPort = DEFAULT_POWERKEY_GPIO_PORT;
+			pPort->resetPort = DEFAULT_POWERKEY_GPIO_PORT;
 			break;
 	}
 	/* GPIO pin selection for Reset from the gpioPin array  */
-	_resetPin =  gpioPin[resetPin];
+	pPort->resetPin =  gpioPin[resetPin];
 
 	/*Configure GPIO pin : Power Reset Pin */
-	GPIO_InitStruct.Pin = _resetPin;
+	GPIO_InitStruct.Pin = pPort->resetPin;
 	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
 	GPIO_InitStruct.Pull = GPIO_NOPULL;
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
 
-	HAL_GPIO_Init(resetHandlerPort, &GPIO_InitStruct);
+	HAL_GPIO_Init(pPort->resetPort, &GPIO_InitStruct);
 	/* SIM: Reset status*/
-	HAL_GPIO_WritePin(resetHandlerPort, _resetPin, RST_ON);
+	HAL_GPIO_WritePin(pPort->resetPort, pPort->resetPin, RST_ON);
+}
+
+/**
+ * @brief	Initializes the pin connected to the DTR input of the SIM, which controls the sleep mode 1 (AT+CSCLK=1).
+ * @note	The pin starts low, so the SIM does not sleep until set_DTR_SIM() sets it high.
+ * @param	Pointer to the port of the SIM.
+ * @param	GPIO Port for DTR
+ * @param	GPIO Pin for DTR
+ * @retval 	None.
+ */
+void initDTRPin(portSIM_t *pPort, Port_t portX, uint16_t dtrPin)
+{
+	GPIO_InitTypeDef GPIO_InitStruct={0};
+
+	pPort->dtrPort = get_GPIO_Port_SIM(portX);
+	pPort->dtrPin = gpioPin[dtrPin];
+
+	GPIO_InitStruct.Pin = pPort->dtrPin;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+
+	HAL_GPIO_Init(pPort->dtrPort, &GPIO_InitStruct);
+	HAL_GPIO_WritePin(pPort->dtrPort, pPort->dtrPin, DTR_WAKE);
+}
+
+/**
+ * @brief	Initializes the pin connected to the RI output of the SIM as an external interrupt.
+ * @note	The SIM pulls RI low when it receives an SMS, a call or data, also while it sleeps, so the
+ * 			interrupt wakes the MCU from a low-power mode. The application must call irq_Handler_EXTI_SIM() from
+ * 			HAL_GPIO_EXTI_Callback(), and the EXTI handler of the line from stm32f4xx_it.c.
+ * @param	Pointer to the port of the SIM.
+ * @param	GPIO Port for RI
+ * @param	GPIO Pin for RI
+ * @retval 	None.
+ */
+void initRIPin(portSIM_t *pPort, Port_t portX, uint16_t riPin)
+{
+	GPIO_InitTypeDef GPIO_InitStruct={0};
+	IRQn_Type irqEXTI;
+
+	pPort->riPort = get_GPIO_Port_SIM(portX);
+	pPort->riPin = gpioPin[riPin];
+	pPort->ringIndicated = false;
+
+	GPIO_InitStruct.Pin = pPort->riPin;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+
+	HAL_GPIO_Init(pPort->riPort, &GPIO_InitStruct);
+
+	/* EXTI0 to EXTI4 have their own interrupt, the lines 5-9 and 10-15 share one */
+	if(riPin <= 4U)
+		irqEXTI = (IRQn_Type)(EXTI0_IRQn + riPin);
+	else if(riPin <= 9U)
+		irqEXTI = EXTI9_5_IRQn;
+	else
+		irqEXTI = EXTI15_10_IRQn;
+
+	HAL_NVIC_SetPriority(irqEXTI, UART_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(irqEXTI);
+}
+
+/**
+ * @brief	Sets the DTR pin of the SIM. In sleep mode 1 the SIM sleeps while DTR is high.
+ * @note	It does nothing if the DTR pin was not initialized with initDTRPin().
+ * @param	Pointer to the port of the SIM.
+ * @param	true to let the SIM sleep, false to wake it up.
+ * @retval 	None.
+ */
+void set_DTR_SIM(portSIM_t *pPort, bool_t sleep)
+{
+	if(pPort->dtrPort != NULL)
+		HAL_GPIO_WritePin(pPort->dtrPort, pPort->dtrPin, (sleep == true) ? DTR_SLEEP : DTR_WAKE);
+}
+
+/**
+ * @brief	Checks if the DTR pin of the SIM was initialized.
+ * @param	Pointer to the port of the SIM.
+ * @retval 	Returns true if the DTR pin is available, otherwise false.
+ */
+bool_t has_DTR_SIM(portSIM_t *pPort)
+{
+	return (pPort->dtrPort != NULL);
+}
+
+/**
+ * @brief	Checks if the SIM pulled the RI pin low since the last call, and clears the indication.
+ * @param	Pointer to the port of the SIM.
+ * @retval 	Returns true if the RI pin was pulled low, otherwise false.
+ */
+bool_t get_Ring_Indication_SIM(portSIM_t *pPort)
+{
+	bool_t indicated = pPort->ringIndicated;
+
+	if(indicated == true)
+		pPort->ringIndicated = false;
+
+	return indicated;
+}
+
+/**
+ * @brief	Handles the external interrupt of the RI pin.
+ * @note	It must be called from HAL_GPIO_EXTI_Callback() with the pin of the interrupt, the pins that are not
+ * 			the RI pin of a port are ignored.
+ * @param	Pin of the external interrupt.
+ * @retval 	None.
+ */
+void irq_Handler_EXTI_SIM(uint16_t gpioPin)
+{
+	uint8_t i;
+
+	for(i = 0; (i < MAX_PORT_INSTANCES) && (portInstancesUART[i] != NULL); i++)
+	{
+		if((portInstancesUART[i]->riPort != NULL) && (portInstancesUART[i]->riPin == gpioPin))
+			portInstancesUART[i]->ringIndicated = true;
+	}
 }
 
 /**
  * @brief	Turn on the SIM.
  * @note	The start-up sequence is as follows:
- * 				1. Hold the powerKey pin high for a time of at least 1s and then set it low.
+ * 				1. Discard the bytes stored in the RX ring buffer, so only the messages of this start-up remain.
+ * 				2. Hold the powerKey pin high for a time of at least 1s and then set it low.
  * 				This is specified in the Hardware Design Guide v1.9, page 22.
- * 				2. Wait a time of at least 15s for the SIM UART to be released.
- * 				On power-up, the SIM sends some initial status messages over the UART,
- * 				which are not relevant, so we wait for this time.
- * @param	None.
+ * 			The SIM is not ready yet when this function returns: it announces each stage of its start-up with
+ * 			a message over the UART (RDY, +CFUN: 1, +CPIN: READY, Call Ready, SMS Ready), which are stored in
+ * 			the RX ring buffer. SIM800_On_Async() runs the same sequence without blocking and waits for them.
+ * @param	Pointer to the port of the SIM.
  * @retval 	None.
  */
-void power_On_SIM()
+void power_On_SIM(portSIM_t *pPort)
 {
-	HAL_GPIO_WritePin(powerKeyHandlerPort, _powerKeyPin, PWRKEY_ON);
+	flush_Data_UART(pPort);
+
+	set_Power_Key_SIM(pPort, true);
 	HAL_Delay(DELAY_POWER_ON);
-	HAL_GPIO_WritePin(powerKeyHandlerPort, _powerKeyPin, PWRKEY_OFF);
-	HAL_Delay(DELAY_ENTRY_ACTIVE);
+	set_Power_Key_SIM(pPort, false);
+}
 
-	/* Initializes the serial receive buffer */
-	memset(&serialUARTBuffer,0,sizeof(serialUARTBuffer));
+/**
+ * @brief	Presses or releases the powerKey of the SIM, without waiting.
+ * @note	The SIM turns on or off when the powerKey is held at least DELAY_POWER_ON or DELAY_POWER_DOWN,
+ * 			so the caller times the pulse. It is used by the non-blocking power sequences of SIM800x.c.
+ * @param	Pointer to the port of the SIM.
+ * @param	true to press the powerKey, false to release it.
+ * @retval 	None.
+ */
+void set_Power_Key_SIM(portSIM_t *pPort, bool_t pressed)
+{
+	HAL_GPIO_WritePin(pPort->powerKeyPort, pPort->powerKeyPin, (pressed == true) ? PWRKEY_ON : PWRKEY_OFF);
 }
 
 /**
@@ -239,14 +387,14 @@ void power_On_SIM()
  * 				1. Hold the powerKey pin high for at least 1.5s and then set it low.
  * 				This is specified in the Hardware Design Guide v1.9, page 23.
  * 				2. Wait a time of at least 3s for the SIM UART to to wait for the UART SIM goes to the idle state.
- * @param	None.
+ * @param	Pointer to the port of the SIM.
  * @retval 	None.
  */
-void power_Down_SIM()
+void power_Down_SIM(portSIM_t *pPort)
 {
-	HAL_GPIO_WritePin(powerKeyHandlerPort, _powerKeyPin, PWRKEY_ON);
+	set_Power_Key_SIM(pPort, true);
 	HAL_Delay(DELAY_POWER_DOWN);
-	HAL_GPIO_WritePin(powerKeyHandlerPort, _powerKeyPin, PWRKEY_OFF);
+	set_Power_Key_SIM(pPort, false);
 	HAL_Delay(DELAY_ENTRY_IDLE);
 }
 
@@ -254,60 +402,1072 @@ void power_Down_SIM()
  * @brief	Reset the SIM.
  * @note	Resetting consists of holding the reset pin high for at least 105ms and then set it low.
  * 			This is specified in the Hardware Design Guide v1.9, page 25 - Table 6.
- * @param	None.
+ * @param	Pointer to the port of the SIM.
  * @retval 	None.
  */
-void restart_SIM()
+void restart_SIM(portSIM_t *pPort)
 {
-	memset(&serialUARTBuffer,0,sizeof(serialUARTBuffer));
+	flush_Data_UART(pPort);
 
-	HAL_GPIO_WritePin(resetHandlerPort, _resetPin, RST_ON);
+	HAL_GPIO_WritePin(pPort->resetPort, pPort->resetPin, RST_ON);
 	HAL_Delay(DELAY_RESET);
-	HAL_GPIO_WritePin(resetHandlerPort, _resetPin, RST_OFF);
+	HAL_GPIO_WritePin(pPort->resetPort, pPort->resetPin, RST_OFF);
 }
 
 /**
  * @brief	Keeps the SIM in a reset state
- * @param	None.
+ * @param	Pointer to the port of the SIM.
  * @retval 	None.
  */
-void keep_Reset_SIM()
+void keep_Reset_SIM(portSIM_t *pPort)
 {
-	HAL_GPIO_WritePin(resetHandlerPort, _resetPin, RST_ON);
+	HAL_GPIO_WritePin(pPort->resetPort, pPort->resetPin, RST_ON);
 }
 
 /**
  * @brief	Releases the SIM from the permanent reset state
- * @param	None.
+ * @param	Pointer to the port of the SIM.
  * @retval 	None.
  */
-void exit_Reset_SIM()
+void exit_Reset_SIM(portSIM_t *pPort)
 {
-	HAL_GPIO_WritePin(resetHandlerPort, _resetPin, RST_OFF);
+	HAL_GPIO_WritePin(pPort->resetPort, pPort->resetPin, RST_OFF);
 }
 
 /**
  * @brief	Sends a string of data over the specified UART peripheral.
+ * @note	The function returns when the whole string has been sent, so the string can be a temporary buffer.
+ * 			In TX_MODE_DMA the wait for a free descriptor and the wait for the transmission are bounded by TIMEOUT.
+ * @param	Pointer to the port of the SIM.
  * @param 	Pointer to the data string to be sent.
  * @retval 	None.
  */
-void write_Data_UART(uint8_t *pDataTx)
+void write_Data_UART(portSIM_t *pPort, uint8_t *pDataTx)
+{
+	uint16_t dataLength = 0;
+	uint32_t tickStart;
+	bool_t queued = false;
+
+	/* get the number of characters to send */
+	if(pDataTx != NULL)
+		dataLength = strlen((const char*)pDataTx);
+
+	if(dataLength != 0)	 /**< verifies that there is data to send */
+	{
+		if(pPort->txMode == TX_MODE_DMA)
+		{
+			/* Waits for a free descriptor if the queue is full, then waits for the end of the transmission */
+			tickStart = HAL_GetTick();
+			while((queued == false) && ((HAL_GetTick() - tickStart) < TIMEOUT))
+			{
+				queued = write_Data_UART_len(pPort, pDataTx, dataLength);
+				if(queued == false)
+					wait_TX_Complete_UART(pPort, TIMEOUT);
+			}
+
+			if(queued == true)
+				wait_TX_Complete_UART(pPort, TIMEOUT);
+		}
+		else
+			HAL_UART_Transmit(pPort->pUARTHandler,pDataTx, dataLength, TIMEOUT);
+	}
+}
+
+/**
+ * @brief	Sends length bytes of data over the specified UART peripheral.
+ * @note	The data may contain any byte value, including NUL.
+ * 			In TX_MODE_DMA the transmission is queued and the function returns immediately: the data must remain
+ * 			valid until is_TX_Busy_UART() returns false or the callback set with set_TX_Callback_UART() is called.
+ * 			In TX_MODE_BLOCKING the function returns when the data has been sent.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Pointer to the data to be sent.
+ * @param 	Number of bytes to send.
+ * @retval 	Returns true if the data was sent or queued, false if the queue is full or the transmission failed.
+ * 			A queued DMA transmission that the HAL refuses later is counted in txFailed, see get_TX_Failures_UART().
+ */
+bool_t write_Data_UART_len(portSIM_t *pPort, const uint8_t *pDataTx, uint16_t length)
+{
+	bool_t statusTx = UNSUCCESSFUL;
+	uint8_t head = pPort->txQueueHead;
+
+	if((pDataTx != NULL) && (length != 0))
+	{
+		if(pPort->txMode == TX_MODE_DMA)
+		{
+			if((uint8_t)(head - pPort->txQueueTail) < TX_QUEUE_SIZE)
+			{
+				pPort->txQueue[head & (TX_QUEUE_SIZE - 1U)].pData = pDataTx;
+				pPort->txQueue[head & (TX_QUEUE_SIZE - 1U)].length = length;
+				pPort->txQueueHead = head + 1U;
+
+				/* If the DMA is idle the transmission starts now, otherwise the TX complete interrupt starts it */
+				if(pPort->txBusy == false)
+				{
+					pPort->txBusy = true;
+					pPort->txError = false;
+					statusTx = start_Next_TX_UART(pPort);
+				}
+				else
+					statusTx = SUCCESSFUL;
+			}
+		}
+		else if(HAL_UART_Transmit(pPort->pUARTHandler, (uint8_t *)pDataTx, length, TIMEOUT) == HAL_OK)
+			statusTx = SUCCESSFUL;
+	}
+
+	return statusTx;
+}
+
+/**
+ * @brief	Sends several segments of data as a single UART transfer (scatter-gather).
+ * @note	The segments are gathered in an internal buffer and sent with one transmission, so an AT command made of
+ * 			a prefix, the command, the parameters and the terminator costs a single HAL transaction.
+ * 			If the segments do not fit in TX_GATHER_BUFFER_SIZE, one transfer is sent each time the buffer is full.
+ * 			In TX_MODE_DMA the function returns without waiting for the last transfer, the segments can be
+ * 			temporary buffers because they are copied.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Pointer to the array of segments.
+ * @param 	Number of segments in the array.
+ * @retval 	Returns true if all the data was sent or queued, otherwise it returns false.
+ */
+bool_t write_Vector_UART(portSIM_t *pPort, const ioVector_t *pVector, uint8_t count)
+{
+	bool_t statusTx = SUCCESSFUL;
+	uint16_t gatherLength = 0;
+	uint16_t copyLength;
+	uint16_t offset;
+	uint8_t i;
+
+	if(pVector != NULL)
+	{
+		/* The gather buffer may still be in use by the previous DMA transfer */
+		if(wait_TX_Complete_UART(pPort, TIMEOUT) == false)
+			statusTx = UNSUCCESSFUL;
+
+		for(i = 0; (i < count) && (statusTx == SUCCESSFUL); i++)
+		{
+			offset = 0;
+			while((pVector[i].pData != NULL) && (offset < pVector[i].length) && (statusTx == SUCCESSFUL))
+			{
+				copyLength = pVector[i].length - offset;
+				if(copyLength > (TX_GATHER_BUFFER_SIZE - gatherLength))
+					copyLength = TX_GATHER_BUFFER_SIZE - gatherLength;
+
+				memcpy(&pPort->txGatherBuffer[gatherLength], &pVector[i].pData[offset], copyLength);
+				gatherLength += copyLength;
+				offset += copyLength;
+
+				/* Buffer full: it is sent and reused once the transfer is completed */
+				if(gatherLength == TX_GATHER_BUFFER_SIZE)
+				{
+					statusTx = write_Data_UART_len(pPort, pPort->txGatherBuffer, gatherLength);
+					if((statusTx == SUCCESSFUL) && (wait_TX_Complete_UART(pPort, TIMEOUT) == false))
+						statusTx = UNSUCCESSFUL;
+					gatherLength = 0;
+				}
+			}
+		}
+
+		if((statusTx == SUCCESSFUL) && (gatherLength != 0))
+			statusTx = write_Data_UART_len(pPort, pPort->txGatherBuffer, gatherLength);
+	}
+	else
+		statusTx = UNSUCCESSFUL;
+
+	return statusTx;
+}
+
+/**
+ * @brief	Checks if there are DMA transmissions in progress or queued.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Returns true while there is data pending to be sent.
+ */
+bool_t is_TX_Busy_UART(portSIM_t *pPort)
+{
+	return pPort->txBusy;
+}
+
+/**
+ * @brief	Waits until all the queued DMA transmissions are completed.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Maximum time to wait, in milliseconds.
+ * @retval 	Returns true if the transmissions were completed, false if the timeout expired.
+ */
+bool_t wait_TX_Complete_UART(portSIM_t *pPort, uint32_t timeout)
+{
+	uint32_t tickStart = HAL_GetTick();
+
+	while((pPort->txBusy == true) && ((HAL_GetTick() - tickStart) < timeout));
+
+	return (pPort->txBusy == false);
+}
+
+/**
+ * @brief	Gets the number of DMA transmissions refused by the HAL since the reception was started.
+ * @note	A caller that compares the value before and after its transmission knows if its data was lost,
+ * 			even if the transmission was started later from the interrupt.
+ * @param	Pointer to the port of the SIM.
+ * @retval 	Number of failed transmissions.
+ */
+uint32_t get_TX_Failures_UART(portSIM_t *pPort)
+{
+	return pPort->errorCounters.txFailed;
+}
+
+/**
+ * @brief	Sets the function called when all the queued DMA transmissions are completed.
+ * @note	The callback is executed in the interrupt context, it must be short.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Pointer to the callback function, or NULL to disable it.
+ * @retval 	None.
+ */
+void set_TX_Callback_UART(portSIM_t *pPort, txCallback_t txCallback)
+{
+	pPort->txCallback = txCallback;
+}
+
+/**
+ * @brief  	Reads a byte from the RX ring buffer filled by the UART interrupt.
+ * @note	If the ring buffer is empty, it waits up to TIMEOUT milliseconds for a byte to arrive.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	The data byte read, or 0 if no byte arrived before the timeout.
+ */
+uint8_t read_Data_UART(portSIM_t *pPort)
+{
+	uint8_t data = 0;
+	uint32_t tickStart = HAL_GetTick();
+
+	while(ring_Buffer_Get(&pPort->rxRingBuffer, &data) == false)
+	{
+		if((HAL_GetTick() - tickStart) >= TIMEOUT)
+			break;
+	}
+	resume_Reception_UART(pPort);
+
+	return data;
+}
+
+/**
+ * @brief  	Reads the bytes available in the RX ring buffer without blocking.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Pointer to the buffer where the bytes read are stored.
+ * @param 	Maximum number of bytes to read.
+ * @retval 	Number of bytes read.
+ */
+uint16_t read_Buffer_UART(portSIM_t *pPort, uint8_t *pDataRx, uint16_t size)
+{
+	uint16_t nBytes = 0;
+
+	if(pDataRx != NULL)
+		nBytes = ring_Buffer_Read(&pPort->rxRingBuffer, pDataRx, size);
+	resume_Reception_UART(pPort);
+
+	return nBytes;
+}
+
+/**
+ * @brief  	Gets the bytes available in the RX ring buffer without copying them.
+ * @note	The bytes are read in place in the storage of the ring buffer and remain there until they are
+ * 			released with release_Buffer_UART(). If the received bytes wrap around the end of the storage,
+ * 			the rest is returned by the next call.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Pointer where the address of the first byte is stored.
+ * @retval 	Number of contiguous bytes available.
+ */
+uint16_t peek_Buffer_UART(portSIM_t *pPort, const uint8_t **ppDataRx)
+{
+	return ring_Buffer_Peek(&pPort->rxRingBuffer, ppDataRx);
+}
+
+/**
+ * @brief  	Releases the bytes obtained with peek_Buffer_UART(), so the UART can reuse their space.
+ * @note	If the reception was paused by the RTS flow control, it is resumed.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Number of bytes to release.
+ * @retval 	None.
+ */
+void release_Buffer_UART(portSIM_t *pPort, uint16_t count)
+{
+	ring_Buffer_Skip(&pPort->rxRingBuffer, count);
+	resume_Reception_UART(pPort);
+}
+
+/**
+ * @brief  	Reads the bytes of the frames already completed in the RX ring buffer.
+ * @note	A frame ends when the UART detects the IDLE line, that is, when the SIM stops transmitting for
+ * 			one character time. This allows the AT parser to get a whole response burst at once.
+ * 			If no complete frame is pending, it waits up to timeout milliseconds for one.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Pointer to the buffer where the bytes read are stored.
+ * @param 	Maximum number of bytes to read.
+ * @param 	Maximum time to wait for a frame, in milliseconds. Use 0 to return immediately.
+ * @retval 	Number of bytes read, 0 if no frame was completed before the timeout.
+ */
+uint16_t read_Frame_UART(portSIM_t *pPort, uint8_t *pDataRx, uint16_t size, uint32_t timeout)
+{
+	uint16_t nBytes = 0;
+	int16_t pendingBytes;
+	uint32_t tickStart = HAL_GetTick();
+
+	if(pDataRx != NULL)
+	{
+		do
+		{
+			/* Bytes between the tail of the ring buffer and the end of the last frame */
+			pendingBytes = (int16_t)(pPort->rxFrameEnd - pPort->rxRingBuffer.tail);
+
+			if(pendingBytes > 0)
+			{
+				if((uint16_t)pendingBytes > size)
+					pendingBytes = (int16_t)size;
+				nBytes = ring_Buffer_Read(&pPort->rxRingBuffer, pDataRx, (uint16_t)pendingBytes);
+				break;
+			}
+		}while((HAL_GetTick() - tickStart) < timeout);
+	}
+	resume_Reception_UART(pPort);
+
+	return nBytes;
+}
+
+/**
+ * @brief  	Gets the number of bytes received and pending to be read.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Number of bytes stored in the RX ring buffer.
+ */
+uint16_t available_Data_UART(portSIM_t *pPort)
+{
+	return ring_Buffer_Count(&pPort->rxRingBuffer);
+}
+
+/**
+ * @brief  	Discards all the bytes received and pending to be read.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	None.
+ */
+void flush_Data_UART(portSIM_t *pPort)
+{
+	ring_Buffer_Flush(&pPort->rxRingBuffer);
+	resume_Reception_UART(pPort);
+}
+
+/**
+ * @brief  	Gets a copy of the UART reception error counters.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Pointer to the structure where the counters are copied.
+ * @retval 	None.
+ */
+void get_Error_Counters_UART(portSIM_t *pPort, UARTErrorCounters_t *pCounters)
+{
+	if(pCounters != NULL)
+		*pCounters = pPort->errorCounters;
+}
+
+/**
+ * @brief  	Selects how the bytes received by the UART reach the RX ring buffer.
+ * @note	In RX_MODE_DMA the UART streams into a circular DMA buffer, so the CPU is only interrupted
+ * 			at half buffer, at full buffer and when the IDLE line marks the end of a response burst.
+ * 			The DMA streams used are: USART1 - DMA2 Stream2, USART2 - DMA1 Stream5, USART6 - DMA2 Stream1.
+ * 			The application must call irq_Handler_DMA_RX_UART() with the UART instance from the corresponding
+ * 			DMA stream IRQ handler, and callback_DMA_RX_UART() from the HAL RX callbacks unless
+ * 			USE_HAL_UART_REGISTER_CALLBACKS is set to 1.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Reception mode: RX_MODE_INTERRUPT or RX_MODE_DMA.
+ * @retval 	Configuration status. If the configuration was successful it returns true, otherwise it returns false.
+ */
+bool_t config_RX_Mode_UART(portSIM_t *pPort, RxMode_t rxMode)
+{
+	bool_t configStatusRx = UNSUCCESSFUL;
+
+	if(pPort->pUARTHandler != NULL)
+	{
+		/* Stops the current reception before changing the mode */
+		__HAL_UART_DISABLE_IT(pPort->pUARTHandler, UART_IT_RXNE);
+		if(pPort->rxMode == RX_MODE_DMA)
+			HAL_UART_AbortReceive(pPort->pUARTHandler);
+
+		if(rxMode == RX_MODE_DMA)
+			configStatusRx = start_DMA_Reception_UART(pPort);
+		else
+		{
+			pPort->rxMode = RX_MODE_INTERRUPT;
+			pPort->rxPaused = false;
+			__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_IDLE);
+			__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_RXNE);
+			__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_PE);
+			__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_ERR);
+			configStatusRx = SUCCESSFUL;
+		}
+	}
+
+	return configStatusRx;
+}
+
+/**
+ * @brief  	Selects how the data is sent over the UART.
+ * @note	In TX_MODE_DMA the data is sent by the DMA from a queue of TX_QUEUE_SIZE descriptors.
+ * 			The DMA streams used are: USART1 - DMA2 Stream7, USART2 - DMA1 Stream6, USART6 - DMA2 Stream6.
+ * 			The application must call irq_Handler_DMA_TX_UART() with the UART instance from the corresponding
+ * 			DMA stream IRQ handler.
+ * @param	Pointer to the port of the SIM.
+ * @param 	Transmission mode: TX_MODE_BLOCKING or TX_MODE_DMA.
+ * @retval 	Configuration status. If the configuration was successful it returns true, otherwise it returns false.
+ */
+bool_t config_TX_Mode_UART(portSIM_t *pPort, TxMode_t txMode)
+{
+	bool_t configStatusTx = UNSUCCESSFUL;
+
+	if(pPort->pUARTHandler != NULL)
+	{
+		/* Finishes the pending transmissions before changing the mode */
+		wait_TX_Complete_UART(pPort, TIMEOUT);
+
+		if(txMode == TX_MODE_DMA)
+			configStatusTx = start_DMA_Transmission_UART(pPort);
+		else
+		{
+			pPort->txMode = TX_MODE_BLOCKING;
+			configStatusTx = SUCCESSFUL;
+		}
+	}
+
+	return configStatusTx;
+}
+
+/**
+ * @brief  	Changes the baud rate of the UART on the fly.
+ * @note	The pending transmissions are completed first and the reception is restarted in the same mode.
+ * 			Oversampling by 16 is used whenever the peripheral clock allows it, otherwise oversampling by 8
+ * 			is selected, which doubles the maximum baud rate for the same clock.
+ * @param	Pointer to the port of the SIM.
+ * @param 	New baud rate, up to MAX_BAUD_RATE.
+ * @retval 	Configuration status. If the configuration was successful it returns true, otherwise it returns false.
+ */
+bool_t set_Baud_Rate_UART(portSIM_t *pPort, uint32_t baudRate)
+{
+	bool_t configStatusBaud = UNSUCCESSFUL;
+	uint32_t pclkFreq;
+
+	if((pPort->pUARTHandler != NULL) && (baudRate != 0) && (baudRate <= MAX_BAUD_RATE))
+	{
+		/* USART1 and USART6 are clocked by APB2, USART2 by APB1 */
+		if((pPort->pUARTHandler->Instance == USART1) || (pPort->pUARTHandler->Instance == USART6))
+			pclkFreq = HAL_RCC_GetPCLK2Freq();
+		else
+			pclkFreq = HAL_RCC_GetPCLK1Freq();
+
+		/* The divider fPCLK/baud must be at least 16 with oversampling by 16 and at least 8 with oversampling by 8 */
+		if((pclkFreq / baudRate) >= 8U)
+		{
+			pPort->pUARTHandler->Init.BaudRate = baudRate;
+			if((pclkFreq / baudRate) >= 16U)
+				pPort->pUARTHandler->Init.OverSampling = UART_OVERSAMPLING_16;
+			else
+				pPort->pUARTHandler->Init.OverSampling = UART_OVERSAMPLING_8;
+
+			configStatusBaud = reinit_UART(pPort);
+		}
+	}
+
+	return configStatusBaud;
+}
+
+/**
+ * @brief  	Enables or disables the RTS/CTS hardware flow control of the UART.
+ * @note	The pins used are: USART1 - CTS PA11, RTS PA12; USART2 - CTS PA0, RTS PA1.
+ * 			With CTS the UART stops transmitting while the SIM is not ready, without any CPU intervention.
+ * 			With RTS, in RX_MODE_INTERRUPT, the byte is left in the data register when the RX ring buffer is full,
+ * 			so the UART deasserts RTS until the application reads the ring buffer. In RX_MODE_DMA the DMA
+ * 			request is paused when the ring buffer cannot take a full DMA buffer, with the same effect.
+ * 			The SIM must be configured with AT+IFC=2,2 before enabling the flow control.
+ * @param	Pointer to the port of the SIM.
+ * @param 	true to enable RTS/CTS, false to disable it.
+ * @retval 	Configuration status. If the configuration was successful it returns true, otherwise it returns false.
+ */
+bool_t config_Flow_Control_UART(portSIM_t *pPort, bool_t enable)
+{
+	GPIO_InitTypeDef GPIO_InitStruct={0};
+	bool_t configStatusFlow = UNSUCCESSFUL;
+
+	if(pPort->pUARTHandler != NULL)
+	{
+		GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+
+		if(pPort->pUARTHandler->Instance == USART1)
+		{
+			GPIO_InitStruct.Pin = GPIO_PIN_11|GPIO_PIN_12;
+			GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
+			configStatusFlow = SUCCESSFUL;
+		}
+		else if(pPort->pUARTHandler->Instance == USART2)
+		{
+			GPIO_InitStruct.Pin = GPIO_PIN_0|GPIO_PIN_1;
+			GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
+			configStatusFlow = SUCCESSFUL;
+		}
+
+		if(configStatusFlow == SUCCESSFUL)
+		{
+			if(enable == true)
+			{
+				/* Configure GPIO pins : CTS and RTS */
+				__HAL_RCC_GPIOA_CLK_ENABLE();
+				HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+				pPort->pUARTHandler->Init.HwFlowCtl = UART_HWCONTROL_RTS_CTS;
+			}
+			else
+				pPort->pUARTHandler->Init.HwFlowCtl = UART_HWCONTROL_NONE;
+
+			configStatusFlow = reinit_UART(pPort);
+			if(configStatusFlow == SUCCESSFUL)
+				pPort->flowControl = enable;
+		}
+	}
+
+	return configStatusFlow;
+}
+
+/**
+ * @brief  	Gets the current baud rate of the UART.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Baud rate, or 0 if the UART is not configured.
+ */
+uint32_t get_Baud_Rate_UART(portSIM_t *pPort)
+{
+	uint32_t baudRate = 0;
+
+	if(pPort->pUARTHandler != NULL)
+		baudRate = pPort->pUARTHandler->Init.BaudRate;
+
+	return baudRate;
+}
+
+/**
+ * @brief  	Handles the interrupt of the UART used by a SIM.
+ * @note	This function must be called from the USARTx_IRQHandler of each UART used by a SIM,
+ * 			for example irq_Handler_UART(USART1) from USART1_IRQHandler().
+ * @param 	UART instance: USART1, USART2 or USART6.
+ * @retval 	None.
+ */
+void irq_Handler_UART(USART_TypeDef *uartInstance)
+{
+	portSIM_t *pPort = find_Port_UART(uartInstance);
+
+	if(pPort != NULL)
+		process_IRQ_UART(pPort);
+}
+
+/**
+ * @brief  	Handles the interrupt of the DMA stream used for the reception of a SIM UART.
+ * @note	This function must be called from the DMAx_Streamy_IRQHandler of the stream used by the UART,
+ * 			for example irq_Handler_DMA_RX_UART(USART1) from DMA2_Stream2_IRQHandler().
+ * @param 	UART instance: USART1, USART2 or USART6.
+ * @retval 	None.
+ */
+void irq_Handler_DMA_RX_UART(USART_TypeDef *uartInstance)
+{
+	portSIM_t *pPort = find_Port_UART(uartInstance);
+
+	if(pPort != NULL)
+		HAL_DMA_IRQHandler(&pPort->dmaRxHandler);
+}
+
+/**
+ * @brief  	Handles the interrupt of the DMA stream used for the transmission of a SIM UART.
+ * @note	This function must be called from the DMAx_Streamy_IRQHandler of the stream used by the UART,
+ * 			for example irq_Handler_DMA_TX_UART(USART1) from DMA2_Stream7_IRQHandler().
+ * @param 	UART instance: USART1, USART2 or USART6.
+ * @retval 	None.
+ */
+void irq_Handler_DMA_TX_UART(USART_TypeDef *uartInstance)
+{
+	portSIM_t *pPort = find_Port_UART(uartInstance);
+
+	if(pPort != NULL)
+		HAL_DMA_IRQHandler(&pPort->dmaTxHandler);
+}
+
+/**
+ * @brief  	Handles the half and full transfer of the circular DMA buffer of a SIM UART.
+ * @note	The driver does not define the HAL callbacks, so the application keeps them for its other UARTs.
+ * 			With USE_HAL_UART_REGISTER_CALLBACKS set to 1 config_RX_Mode_UART() registers this function,
+ * 			otherwise it must be called from HAL_UART_RxHalfCpltCallback() and HAL_UART_RxCpltCallback().
+ * 			UARTs that are not used by a SIM are ignored.
+ * @param 	Pointer to the UART_Handle structure.
+ * @retval 	None.
+ */
+void callback_DMA_RX_UART(UART_HandleTypeDef *huart)
+{
+	portSIM_t *pPort = find_Port_UART(huart->Instance);
+
+	if(pPort != NULL)
+		transfer_DMA_Data_UART(pPort);
+}
+
+/**
+ * @brief  	Initializes the RX ring buffer and enables the reception and error interrupts of the UART.
+ * @note	Only USART1, USART2 and USART6 are available on the STM32F411.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Initialization status. If the initialization was successful it returns true, otherwise it returns false.
+ */
+static bool_t start_Reception_UART(portSIM_t *pPort)
+{
+	IRQn_Type irqUART;
+	bool_t initStatusRx = SUCCESSFUL;
+
+	if(pPort->pUARTHandler->Instance == USART1)
+		irqUART = USART1_IRQn;
+	else if(pPort->pUARTHandler->Instance == USART2)
+		irqUART = USART2_IRQn;
+	else if(pPort->pUARTHandler->Instance == USART6)
+		irqUART = USART6_IRQn;
+	else
+		initStatusRx = UNSUCCESSFUL;
+
+	if((initStatusRx == SUCCESSFUL) && (register_Port_UART(pPort) == UNSUCCESSFUL))
+		initStatusRx = UNSUCCESSFUL;
+
+	if(initStatusRx == SUCCESSFUL)
+	{
+		ring_Buffer_Init(&pPort->rxRingBuffer, pPort->rxStorage, RX_BUFFER_SIZE);
+		memset(&pPort->errorCounters, 0, sizeof(pPort->errorCounters));
+		pPort->rxFrameEnd = 0;
+		pPort->rxMode = RX_MODE_INTERRUPT;
+		pPort->rxPaused = false;
+		pPort->flowControl = (pPort->pUARTHandler->Init.HwFlowCtl == UART_HWCONTROL_RTS_CTS);
+		pPort->txMode = TX_MODE_BLOCKING;
+		pPort->txBusy = false;
+
+		HAL_NVIC_SetPriority(irqUART, UART_IRQ_PRIORITY, 0);
+		HAL_NVIC_EnableIRQ(irqUART);
+
+		__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_RXNE);
+		__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_PE);
+		__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_ERR);
+		__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_IDLE);
+	}
+
+	return initStatusRx;
+}
+
+/**
+ * @brief  	Configures the DMA stream of the UART reception in circular mode and starts the reception.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Initialization status. If the initialization was successful it returns true, otherwise it returns false.
+ */
+static bool_t start_DMA_Reception_UART(portSIM_t *pPort)
+{
+	IRQn_Type irqDMA;
+	bool_t initStatusDMA = SUCCESSFUL;
+
+	if(pPort->pUARTHandler->Instance == USART1)
+	{
+		__HAL_RCC_DMA2_CLK_ENABLE();
+		pPort->dmaRxHandler.Instance = DMA2_Stream2;
+		pPort->dmaRxHandler.Init.Channel = DMA_CHANNEL_4;
+		irqDMA = DMA2_Stream2_IRQn;
+	}
+	else if(pPort->pUARTHandler->Instance == USART2)
+	{
+		__HAL_RCC_DMA1_CLK_ENABLE();
+		pPort->dmaRxHandler.Instance = DMA1_Stream5;
+		pPort->dmaRxHandler.Init.Channel = DMA_CHANNEL_4;
+		irqDMA = DMA1_Stream5_IRQn;
+	}
+	else if(pPort->pUARTHandler->Instance == USART6)
+	{
+		__HAL_RCC_DMA2_CLK_ENABLE();
+		pPort->dmaRxHandler.Instance = DMA2_Stream1;
+		pPort->dmaRxHandler.Init.Channel = DMA_CHANNEL_5;
+		irqDMA = DMA2_Stream1_IRQn;
+	}
+	else
+		initStatusDMA = UNSUCCESSFUL;
+
+	if(initStatusDMA == SUCCESSFUL)
+	{
+		pPort->dmaRxHandler.Init.Direction = DMA_PERIPH_TO_MEMORY;
+		pPort->dmaRxHandler.Init.PeriphInc = DMA_PINC_DISABLE;
+		pPort->dmaRxHandler.Init.MemInc = DMA_MINC_ENABLE;
+		pPort->dmaRxHandler.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		pPort->dmaRxHandler.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+		pPort->dmaRxHandler.Init.Mode = DMA_CIRCULAR;
+		pPort->dmaRxHandler.Init.Priority = DMA_PRIORITY_HIGH;
+		pPort->dmaRxHandler.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+		if(HAL_DMA_Init(&pPort->dmaRxHandler) == HAL_OK)
+		{
+			__HAL_LINKDMA(pPort->pUARTHandler, hdmarx, pPort->dmaRxHandler);
+
+			HAL_NVIC_SetPriority(irqDMA, UART_IRQ_PRIORITY, 0);
+			HAL_NVIC_EnableIRQ(irqDMA);
+
+			pPort->dmaRxLastPosition = 0;
+			pPort->rxMode = RX_MODE_DMA;
+			pPort->rxPaused = false;
+
+#if (USE_HAL_UART_REGISTER_CALLBACKS == 1)
+			HAL_UART_RegisterCallback(pPort->pUARTHandler, HAL_UART_RX_HALFCOMPLETE_CB_ID, callback_DMA_RX_UART);
+			HAL_UART_RegisterCallback(pPort->pUARTHandler, HAL_UART_RX_COMPLETE_CB_ID, callback_DMA_RX_UART);
+#endif
+
+			/* The HAL enables the error interrupts and the DMA request, the IDLE interrupt stays enabled */
+			if(HAL_UART_Receive_DMA(pPort->pUARTHandler, pPort->dmaRxBuffer, DMA_RX_BUFFER_SIZE) != HAL_OK)
+			{
+				pPort->rxMode = RX_MODE_INTERRUPT;
+				initStatusDMA = UNSUCCESSFUL;
+			}
+		}
+		else
+			initStatusDMA = UNSUCCESSFUL;
+	}
+
+	return initStatusDMA;
+}
+
+/**
+ * @brief  	Moves the bytes written by the DMA since the last call from the circular buffer to the RX ring buffer.
+ * @note	It is called from the UART (IDLE) and DMA (half and full transfer) interrupts, which share the
+ * 			same priority, so the RX ring buffer keeps a single producer.
+ * 			With flow control, when the RX ring buffer has less space than the DMA buffer, the DMA request is
+ * 			paused: the next byte stays in the data register and the UART deasserts RTS. The request is
+ * 			enabled again by resume_Reception_UART(), so no byte written by the DMA is ever dropped.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	None.
+ */
+static void transfer_DMA_Data_UART(portSIM_t *pPort)
+{
+	uint16_t dmaPosition = DMA_RX_BUFFER_SIZE - (uint16_t)__HAL_DMA_GET_COUNTER(&pPort->dmaRxHandler);
+
+	if(dmaPosition >= DMA_RX_BUFFER_SIZE)
+		dmaPosition = 0;
+
+	while(pPort->dmaRxLastPosition != dmaPosition)
+	{
+		if(ring_Buffer_Put(&pPort->rxRingBuffer, pPort->dmaRxBuffer[pPort->dmaRxLastPosition]) == false)
+			pPort->errorCounters.dropped++;
+
+		if(++pPort->dmaRxLastPosition >= DMA_RX_BUFFER_SIZE)
+			pPort->dmaRxLastPosition = 0;
+	}
+
+	if((pPort->flowControl == true) && (ring_Buffer_Free(&pPort->rxRingBuffer) < DMA_RX_BUFFER_SIZE))
+	{
+		ATOMIC_CLEAR_BIT(pPort->pUARTHandler->Instance->CR3, USART_CR3_DMAR);
+		__HAL_UART_DISABLE_IT(pPort->pUARTHandler, UART_IT_IDLE);
+		pPort->rxPaused = true;
+	}
+}
+
+/**
+ * @brief  	Configures the DMA stream of the UART transmission in normal mode.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Initialization status. If the initialization was successful it returns true, otherwise it returns false.
+ */
+static bool_t start_DMA_Transmission_UART(portSIM_t *pPort)
+{
+	IRQn_Type irqDMA;
+	bool_t initStatusDMA = SUCCESSFUL;
+
+	if(pPort->pUARTHandler->Instance == USART1)
+	{
+		__HAL_RCC_DMA2_CLK_ENABLE();
+		pPort->dmaTxHandler.Instance = DMA2_Stream7;
+		pPort->dmaTxHandler.Init.Channel = DMA_CHANNEL_4;
+		irqDMA = DMA2_Stream7_IRQn;
+	}
+	else if(pPort->pUARTHandler->Instance == USART2)
+	{
+		__HAL_RCC_DMA1_CLK_ENABLE();
+		pPort->dmaTxHandler.Instance = DMA1_Stream6;
+		pPort->dmaTxHandler.Init.Channel = DMA_CHANNEL_4;
+		irqDMA = DMA1_Stream6_IRQn;
+	}
+	else if(pPort->pUARTHandler->Instance == USART6)
+	{
+		__HAL_RCC_DMA2_CLK_ENABLE();
+		pPort->dmaTxHandler.Instance = DMA2_Stream6;
+		pPort->dmaTxHandler.Init.Channel = DMA_CHANNEL_5;
+		irqDMA = DMA2_Stream6_IRQn;
+	}
+	else
+		initStatusDMA = UNSUCCESSFUL;
+
+	if(initStatusDMA == SUCCESSFUL)
+	{
+		pPort->dmaTxHandler.Init.Direction = DMA_MEMORY_TO_PERIPH;
+		pPort->dmaTxHandler.Init.PeriphInc = DMA_PINC_DISABLE;
+		pPort->dmaTxHandler.Init.MemInc = DMA_MINC_ENABLE;
+		pPort->dmaTxHandler.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		pPort->dmaTxHandler.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+		pPort->dmaTxHandler.Init.Mode = DMA_NORMAL;
+		pPort->dmaTxHandler.Init.Priority = DMA_PRIORITY_MEDIUM;
+		pPort->dmaTxHandler.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+		if(HAL_DMA_Init(&pPort->dmaTxHandler) == HAL_OK)
+		{
+			__HAL_LINKDMA(pPort->pUARTHandler, hdmatx, pPort->dmaTxHandler);
+
+			HAL_NVIC_SetPriority(irqDMA, UART_IRQ_PRIORITY, 0);
+			HAL_NVIC_EnableIRQ(irqDMA);
+
+			pPort->txQueueHead = 0;
+			pPort->txQueueTail = 0;
+			pPort->txBusy = false;
+			pPort->txError = false;
+			pPort->txMode = TX_MODE_DMA;
+		}
+		else
+			initStatusDMA = UNSUCCESSFUL;
+	}
+
+	return initStatusDMA;
+}
+
+/**
+ * @brief  	Starts the DMA transmission of the descriptor at the tail of the TX queue.
+ * @note	It is called from the main loop when the DMA is idle, or from the TX complete interrupt.
+ * 			If the HAL refuses the transfer, the failure is counted in txFailed and the descriptor is released
+ * 			as failed, so the queue never stalls and the TX callback reports it.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Returns true if the transmission was started, false if the HAL refused it.
+ */
+static bool_t start_Next_TX_UART(portSIM_t *pPort)
+{
+	txDescriptor_t *pDescriptor = &pPort->txQueue[pPort->txQueueTail & (TX_QUEUE_SIZE - 1U)];
+	bool_t statusStart = SUCCESSFUL;
+
+	if(HAL_UART_Transmit_DMA(pPort->pUARTHandler, (uint8_t *)pDescriptor->pData, pDescriptor->length) != HAL_OK)
+	{
+		pPort->errorCounters.txFailed++;
+		pPort->txError = true;
+		statusStart = UNSUCCESSFUL;
+		complete_TX_UART(pPort);
+	}
+
+	return statusStart;
+}
+
+/**
+ * @brief  	Releases the descriptor at the tail of the TX queue and starts the next one.
+ * @note	When the queue is empty the TX callback is called, with false if a transmission failed.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	None.
+ */
+static void complete_TX_UART(portSIM_t *pPort)
+{
+	pPort->txQueueTail++;
+
+	if(pPort->txQueueHead != pPort->txQueueTail)
+		start_Next_TX_UART(pPort);
+	else
+	{
+		pPort->txBusy = false;
+		if(pPort->txCallback != NULL)
+			pPort->txCallback(pPort, (pPort->txError == false));
+	}
+}
+
+/**
+ * @brief  	Initializes the UART again with the parameters of its Init structure.
+ * @note	The pending transmissions are completed first and the reception is restarted in the same mode.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Initialization status. If the initialization was successful it returns true, otherwise it returns false.
+ */
+static bool_t reinit_UART(portSIM_t *pPort)
+{
+	bool_t initStatusUART = UNSUCCESSFUL;
+	RxMode_t rxMode = pPort->rxMode;
+
+	wait_TX_Complete_UART(pPort, TIMEOUT);
+	if(pPort->rxMode == RX_MODE_DMA)
+		HAL_UART_AbortReceive(pPort->pUARTHandler);
+
+	if(HAL_UART_Init(pPort->pUARTHandler) == HAL_OK)
+		initStatusUART = config_RX_Mode_UART(pPort, rxMode);
+
+	return initStatusUART;
+}
+
+/**
+ * @brief  	Enables again the reception paused by the RTS flow control once the RX ring buffer has space.
+ * @note	In RX_MODE_INTERRUPT one free byte is enough. In RX_MODE_DMA the ring buffer must be able to take
+ * 			a full DMA buffer, the amount the DMA can write before the next half or full transfer interrupt.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	None.
+ */
+static void resume_Reception_UART(portSIM_t *pPort)
+{
+	if((pPort->rxPaused == true) && (pPort->rxMode == RX_MODE_DMA)
+			&& (ring_Buffer_Free(&pPort->rxRingBuffer) >= DMA_RX_BUFFER_SIZE))
+	{
+		pPort->rxPaused = false;
+		__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_IDLE);
+		ATOMIC_SET_BIT(pPort->pUARTHandler->Instance->CR3, USART_CR3_DMAR);
+	}
+	else if((pPort->rxPaused == true) && (pPort->rxMode == RX_MODE_INTERRUPT)
+			&& (ring_Buffer_Free(&pPort->rxRingBuffer) != 0))
+	{
+		pPort->rxPaused = false;
+		__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_IDLE);
+		__HAL_UART_ENABLE_IT(pPort->pUARTHandler, UART_IT_RXNE);
+	}
+}
+
+/**
+ * @brief  	Handles the UART interrupt: stores the received byte in the RX ring buffer, counts the errors
+ * 			and marks the end of a frame when the IDLE line is detected.
+ * @note	Reading the status register followed by the data register clears the error and IDLE flags.
+ * 			Bytes received with framing, noise or parity errors are discarded.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	None.
+ */
+static void process_IRQ_UART(portSIM_t *pPort)
 {
-	if(pDataTx!= NULL)	 /**< verifies that the data pointer is valid */
+	uint32_t statusReg = pPort->pUARTHandler->Instance->SR;
+	bool_t dataRegRead = false;
+	uint8_t data;
+
+	if(statusReg & USART_SR_ORE)
+		pPort->errorCounters.overrun++;
+	if(statusReg & USART_SR_FE)
+		pPort->errorCounters.framing++;
+	if(statusReg & USART_SR_NE)
+		pPort->errorCounters.noise++;
+	if(statusReg & USART_SR_PE)
+		pPort->errorCounters.parity++;
+
+	if(pPort->rxMode == RX_MODE_INTERRUPT)
+	{
+		if((pPort->flowControl == true) && (statusReg & USART_SR_RXNE) && (ring_Buffer_Free(&pPort->rxRingBuffer) == 0)
+				&& !(statusReg & (USART_SR_ORE | USART_SR_FE | USART_SR_NE | USART_SR_PE)))
+		{
+			/**
+			 * RX ring buffer full: the byte stays in the data register, so the UART deasserts RTS and the SIM
+			 * stops sending. The interrupts are enabled again by resume_Reception_UART() when there is space.
+			 * */
+			__HAL_UART_DISABLE_IT(pPort->pUARTHandler, UART_IT_RXNE);
+			__HAL_UART_DISABLE_IT(pPort->pUARTHandler, UART_IT_IDLE);
+			pPort->rxPaused = true;
+			dataRegRead = true;
+		}
+		else if(statusReg & (USART_SR_RXNE | USART_SR_ORE | USART_SR_FE | USART_SR_NE | USART_SR_PE))
+		{
+			data = (uint8_t)(pPort->pUARTHandler->Instance->DR & 0xFFU);
+			dataRegRead = true;
+
+			if((statusReg & USART_SR_RXNE) && !(statusReg & (USART_SR_FE | USART_SR_NE | USART_SR_PE)))
+			{
+				if(ring_Buffer_Put(&pPort->rxRingBuffer, data) == false)
+					pPort->errorCounters.dropped++;
+			}
+		}
+	}
+	else if(statusReg & (USART_SR_ORE | USART_SR_FE | USART_SR_NE | USART_SR_PE))
 	{
-		/* get the number of characters to send */
-		uint16_t dataLength = strlen((const char*)pDataTx);
-		HAL_UART_Transmit(pUARTHandlerPort,pDataTx, dataLength, TIMEOUT);
+		/* In DMA mode the data register is read by the DMA, only the error flags are cleared */
+		__HAL_UART_CLEAR_PEFLAG(pPort->pUARTHandler);
+		dataRegRead = true;
+	}
+
+	if((statusReg & USART_SR_IDLE) && (pPort->rxPaused == false))
+	{
+		if(dataRegRead == false)
+			__HAL_UART_CLEAR_IDLEFLAG(pPort->pUARTHandler);
+
+		if(pPort->rxMode == RX_MODE_DMA)
+			transfer_DMA_Data_UART(pPort);
+
+		/* The SIM stopped transmitting: everything received up to now is a complete frame */
+		pPort->rxFrameEnd = pPort->rxRingBuffer.head;
+	}
+
+	/* End of a DMA transmission: the same sequence as the HAL end of transmission */
+	if((statusReg & USART_SR_TC) && (pPort->pUARTHandler->Instance->CR1 & USART_CR1_TCIE))
+	{
+		__HAL_UART_DISABLE_IT(pPort->pUARTHandler, UART_IT_TC);
+		pPort->pUARTHandler->gState = HAL_UART_STATE_READY;
+		complete_TX_UART(pPort);
 	}
 }
 
 /**
- * @brief  	Reads a byte over the UART and stores it in the serialUARTBuffer array.
- * @param 	None.
- * @retval 	The first element of the array serialUARTBuffer, containing the data byte read.
+ * @brief  	Registers the port so that the interrupt handlers and the HAL callbacks can find it from its UART.
+ * @note	A port that is configured again replaces the previous registration of the same UART.
+ * @param 	Pointer to the port of the SIM.
+ * @retval 	Registration status. It returns false if the UART is used by another port or there is no free entry.
  */
-uint8_t read_Data_UART()
+static bool_t register_Port_UART(portSIM_t *pPort)
 {
-	HAL_UART_Receive(pUARTHandlerPort,&serialUARTBuffer,1,TIMEOUT);
-	return serialUARTBuffer[0];
+	bool_t statusRegister = UNSUCCESSFUL;
+	uint8_t i;
+
+	for(i = 0; i < MAX_PORT_INSTANCES; i++)
+	{
+		if((portInstancesUART[i] == pPort) || (portInstancesUART[i] == NULL))
+		{
+			portInstancesUART[i] = pPort;
+			statusRegister = SUCCESSFUL;
+			break;
+		}
+		if(portInstancesUART[i]->pUARTHandler->Instance == pPort->pUARTHandler->Instance)
+			break;
+	}
+
+	return statusRegister;
+}
+
+/**
+ * @brief  	Gets the port registered for the UART instance passed as a parameter.
+ * @param 	UART instance.
+ * @retval 	Pointer to the port, or NULL if no port uses that UART.
+ */
+static portSIM_t *find_Port_UART(const USART_TypeDef *uartInstance)
+{
+	portSIM_t *pPort = NULL;
+	uint8_t i;
+
+	for(i = 0; (i < MAX_PORT_INSTANCES) && (portInstancesUART[i] != NULL); i++)
+	{
+		if(portInstancesUART[i]->pUARTHandler->Instance == uartInstance)
+		{
+			pPort = portInstancesUART[i];
+			break;
+		}
+	}
+
+	return pPort;
+}
+
+/**
+ * @brief	Enables the clock of a GPIO port and gets its registers.
+ * @param	GPIO Port.
+ * @retval 	Pointer to the GPIO port, GPIOB if the port is not valid.
+ */
+static GPIO_TypeDef *get_GPIO_Port_SIM(Port_t portX)
+{
+	GPIO_TypeDef *pGPIO;
+
+	switch(portX)
+	{
+		case PORTA:
+			__HAL_RCC_GPIOA_CLK_ENABLE();
+			pGPIO = GPIOA;
+			break;
+
+		case PORTC:
+			__HAL_RCC_GPIOC_CLK_ENABLE();
+			pGPIO = GPIOC;
+			break;
+
+		case PORTB:
+		default:
+			__HAL_RCC_GPIOB_CLK_ENABLE();
+			pGPIO = GPIOB;
+			break;
+	}
+
+	return pGPIO;
 }
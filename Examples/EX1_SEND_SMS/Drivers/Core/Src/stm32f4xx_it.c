@@ -22,6 +22,7 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "port.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -199,5 +200,27 @@ void SysTick_Handler(void)
 /******************************************************************************/
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles USART1 global interrupt, used by the SIM800.
+  */
+void USART1_IRQHandler(void)
+{
+  irq_Handler_UART(USART1);
+}
 
+/**
+  * @brief This function handles DMA2 stream2 global interrupt, used by the SIM800 USART1 reception.
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+  irq_Handler_DMA_RX_UART(USART1);
+}
+
+/**
+  * @brief This function handles DMA2 stream7 global interrupt, used by the SIM800 USART1 transmission.
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  irq_Handler_DMA_TX_UART(USART1);
+}
 /* USER CODE END 1 */
@@ -15,6 +15,9 @@
 #include <string.h>
 #include <stdint.h>
 #include "port.h"
+#include "at_matcher.h"
+#include "at_tokenizer.h"
+#include "at_engine.h"
 
 /**
  * @typedef	bool_t
@@ -24,12 +27,41 @@ typedef bool bool_t;
 
 /*---- COMMUNICATION AND CONFIG SERIAL PORT SIM ----*/
 /**
- * @def		AT_CMD_CHECK_COMM
- * @brief	Defines the prefix "AT" used to check communication with the SIM.
+ * @def		N_SYNC_PROBES
+ * @brief	Defines the number of "AT" sent to verify the link after a baud rate change, and at each baud rate
+ * 			of the scan.
+ *
+ * @def		N_SYNC_ATTEMPTS
+ * @brief	Defines the number of "AT" sent at the current baud rate to synchronize the autobauding of the SIM.
+ *
+ * @def		N_SYNC_OK
+ * @brief	Defines the number of consecutive OK that validate the link.
+ *
+ * @def		TIMEOUT_SYNC
+ * @brief	Defines the time in milliseconds to wait for the answer to each "AT" of the synchronization.
+ *
+ * @def		TIME_AUTO_SLEEP
+ * @brief	Defines the time without activity on the UART after which the SIM enters the sleep mode 2.
+ *
+ * @def		FLOW_CONTROL_RTS_CTS
+ * @brief	Defines the parameter of AT+IFC to use RTS for the data received by the SIM and CTS for the data sent.
+ *
+ * @def		FLOW_CONTROL_NONE
+ * @brief	Defines the parameter of AT+IFC without flow control.
+ *
+ * @def		ECHO_OFF
+ * @brief	Defines the parameter of ATE that stops the echo of the commands.
  * */
-#define AT_CHECK_COMM				"AT"
-#define AT_CMD_CONFIG_BAUD			"IPR"
 #define DEFAULT_BAUD_RATE_SIM		"9600"
+#define N_SYNC_PROBES				3
+#define N_SYNC_ATTEMPTS				6
+#define N_SYNC_OK					2
+#define TIMEOUT_SYNC				300UL
+#define TIME_AUTO_SLEEP				5000UL
+#define FLOW_CONTROL_RTS_CTS		"2,2"
+#define FLOW_CONTROL_NONE			"0,0"
+#define ECHO_OFF					"0"
+#define ECHO_ON						"1"
 /*-------------------------------------------------*/
 
 /*---------- STATUS RESPONSES --------*/
@@ -39,7 +71,6 @@ typedef bool bool_t;
 /*------------------------------------*/
 
 /*----------------------------------- STATUS REGISTRATION NETWORK RESPONSES -------------------------------*/
-#define AT_CMD_NETWORK_REGISTER					"AT+CREG?"
 #define NETWORK_NOT_REGISTERED_NO_SEARCHING     ",0"
 #define NETWORK_REGISTERED                     	",1"
 #define NETWORK_NOT_REGISTERED_BUT_SEARCHING   	",2"
@@ -48,21 +79,8 @@ typedef bool bool_t;
 #define REGISTERED_ROAMING                     	",5"
 /*-------------------------------------------------------------------------------------------------------*/
 
-/*-------------------------------- CALL -----------------------------*/
-#define AT_CMD_CALL				"ATD"
-#define AT_CMD_END_CALL         "ATH"
-/*-------------------------------------------------------------------*/
-
 /*------------------------------------------------------------ SMS -----------------------------------------------------*/
 /**
- * @def		AT_CMD_LIST_SMS
- * @brief	Defines the the parameter of command used to list received messages according to their status:READ,UNREAD or
- * 			stored messages: SENT,UNSET.
- *
- * @def		AT_CMD_DELETE_SMS
- * @brief	Defines the the parameter of command used to delete received messages according to flag parameter [0-4]
- * 			which indicates which type of message to delete.
- *
  * @def		DELETE_ALL_SMS
  * @brief	Delete all messages from preferred message storage including unread messages
  *
@@ -87,19 +105,14 @@ typedef bool bool_t;
  * @def		CTRL_Z
  * @brief	Defines the character ASCII with which the text entry in the message is finalized and the message is sent.
  * */
-#define AT_CMD_TEXT_MODE							"CMGF"
 #define TEXT_MODE									"1"
-#define AT_CMD_SEND_SMS        						"CMGS"
 #define INPUT_DATA									'>'
 #define CTRL_Z          							0x1A
-#define AT_CMD_READ_SMS            					"CMGR"
-#define AT_CMD_LIST_SMS            					"CMGL"
 #define RECEIVED_UNREAD     						"\"REC UNREAD\""
 #define RECEIVED_READ       						"\"REC READ\""
 #define STORED_UNSENT       						"\"STO UNSENT\""
 #define STORED_SENT         						"\"STO SENT\""
 #define ALL                 						"\"ALL\""
-#define AT_CMD_DELETE_SMS							"CMGD"
 #define DELETE_ALL_SMS								4
 #define DELETE_ALL_READ_SENT_UNSET_SMS				3
 #define DELETE_ALL_READ_SENT_SMS					2
@@ -109,25 +122,49 @@ typedef bool bool_t;
 
 /*-------------------------- GPRS ----------------------*/
 /**
- * @def		CSTT
- * @brief	Defines the parameter of AT command used to set APN.
- *
- * @def		AT_CMD_DELETE_SMS
- * @brief	Defines the AT command used to delete received messages according to flag parameter [0-4]
- * 			which indicates which type of message to delete.
- *
  * @def		SHUT_OK
  * @brief	Defines the the response obtained by successfully disabling the GPRS PDP context.
+ *
+ * @def		KEEP_ALIVE_INTERVAL
+ * @brief	Defines the time in seconds between the TCP keepalive probes of AT+CIPTKA, from 30 to 600.
+ *
+ * @def		KEEP_ALIVE_PROBES
+ * @brief	Defines the number of TCP keepalive probes without answer after which the connection is closed, from 1 to 9.
+ *
+ * @def		ESCAPE_SEQUENCE
+ * @brief	Defines the sequence that switches a transparent connection from data mode to command mode.
+ *
+ * @def		GUARD_TIME_ESCAPE
+ * @brief	Defines the time in milliseconds without data that the SIM requires before and after the escape sequence.
+ *
+ * @def		TRANSPARENT_RETRIES
+ * @brief	Defines the default number of retransmissions of a packet in transparent mode, AT+CIPCCFG <NmRetry>.
+ *
+ * @def		TRANSPARENT_WAIT_TIME
+ * @brief	Defines the default time in units of 100 ms that the SIM waits for more data before sending a packet
+ * 			in transparent mode, AT+CIPCCFG <WaitTm>.
+ *
+ * @def		TRANSPARENT_SEND_SIZE
+ * @brief	Defines the default number of bytes that make the SIM send a packet in transparent mode without waiting,
+ * 			AT+CIPCCFG <SendSz>.
+ *
+ * @def		N_SOCKETS_SIM
+ * @brief	Defines the number of connections of the multi-connection mode, AT+CIPMUX=1, numbered from 0.
+ *
+ * @def		SOCKET_BUFFER_SIZE
+ * @brief	Defines the recommended size of the buffer passed to SIM800_Socket_Open() for the data received by
+ * 			a connection of the multi-connection mode, it holds a full segment of 1460 bytes reported by +RECEIVE.
+ *
+ * @def		QUICK_SEND_WINDOW
+ * @brief	Defines the default number of bytes sent in quick send mode and not yet acknowledged by the server,
+ * 			above which the sends wait.
+ *
+ * @def		QUICK_SEND_ACK_TIME
+ * @brief	Defines the time in milliseconds between the queries of AT+CIPACK while a send waits for the window.
+ *
+ * @def		QUICK_SEND_TIMEOUT
+ * @brief	Defines the maximum time in milliseconds that a send waits for the window before failing.
  * */
-#define AT_CMD_GPRS_SERVICE				"AT+CGATT?"
-#define AT_CMD_DESACT_GPRS_CONTEXT		"AT+CIPSHUT"
-#define CSTT            				"CSTT"
-#define AT_CMD_BRING_UP_GPRS_CONEXION  	"AT+CIICR"
-#define AT_CMD_GET_LOCAL_IP				"AT+CIFSR"
-#define AT_CMD_START_TCPUDP_CONEXION	"CIPSTART"
-#define AT_CMD_CLOSE_TCPUDP_CONEXION	"AT+CIPCLOSE"
-#define AT_CMD_SEND_DATA_TCPUDP			"AT+CIPSEND"
-#define CIPMODE         				"CIPMODE"
 #define CONNECT_OK      				"CONNECT"
 #define TCP             				"TCP"
 #define UDP             				"UDP"
@@ -136,8 +173,106 @@ typedef bool bool_t;
 #define SHUT_OK         				"SHUT OK"
 #define TRANSPARENT_MODE    			1
 #define COMMAND_MODE        			0
+#define KEEP_ALIVE_INTERVAL				75U
+#define KEEP_ALIVE_PROBES				9U
+#define ESCAPE_SEQUENCE					"+++"
+#define GUARD_TIME_ESCAPE				1000UL
+#define TRANSPARENT_RETRIES				5U
+#define TRANSPARENT_WAIT_TIME			2U
+#define TRANSPARENT_SEND_SIZE			1024U
+#define MULTI_CONNECTION				"1"
+#define N_SOCKETS_SIM					6U
+#define SOCKET_BUFFER_SIZE				2048U
+#define QUICK_SEND_WINDOW				2920U
+#define QUICK_SEND_ACK_TIME				500UL
+#define QUICK_SEND_TIMEOUT				30000UL
+#define CIPACK_RESPONSE					"+CIPACK: "
 /*------------------------------------------------------*/
 
+/*------------------------------- UNSOLICITED RESULT CODES -----------------------------*/
+/**
+ * @def		URC_NEW_SMS
+ * @brief	Defines the prefix of the URC sent when a new SMS is stored: +CMTI: "SM",<index>
+ *
+ * @def		URC_PDP_DEACT
+ * @brief	Defines the URC sent when the network deactivates the GPRS PDP context.
+ *
+ * @def		URC_UNDER_VOLTAGE
+ * @brief	Defines the prefix of the under-voltage warning and power down URCs.
+ *
+ * @def		URC_RDY
+ * @brief	Defines the URC sent when the UART of the SIM is ready after the power on. It is only sent when
+ * 			the baud rate is fixed, with autobauding the SIM does not know the baud rate yet.
+ *
+ * @def		URC_RECEIVE
+ * @brief	Defines the prefix of the header of the data received in multi-connection mode:
+ * 			+RECEIVE,<n>,<length>: followed by the data.
+ * */
+#define URC_NEW_SMS						"+CMTI:"
+#define URC_RING						"RING"
+#define URC_CLOSED						"CLOSED"
+#define URC_PDP_DEACT					"+PDP: DEACT"
+#define URC_CALL_READY					"Call Ready"
+#define URC_SMS_READY					"SMS Ready"
+#define URC_RDY							"RDY"
+#define URC_CFUN_FULL					"+CFUN: 1"
+#define URC_CPIN_READY					"+CPIN: READY"
+#define URC_UNDER_VOLTAGE				"UNDER-VOLTAGE"
+#define URC_RECEIVE						"+RECEIVE,"
+/*--------------------------------------------------------------------------------------*/
+
+/*------------------------------------ AT COMMANDS ------------------------------------*/
+/**
+ * @enum	commandSIM_t
+ * @brief	Type of enumeration for the AT commands used by the driver. Each one indexes a constant descriptor
+ * 			with its syntax, the final result codes that complete it and its maximum response time.
+ * @note	SIM_CMD_GENERIC is any command written in full by the application, completed by OK or an error.
+ * */
+typedef enum
+{
+	SIM_CMD_AT = 0,
+	SIM_CMD_ATE,
+	SIM_CMD_ATW,
+	SIM_CMD_IPR,
+	SIM_CMD_IPR_READ,
+	SIM_CMD_IFC,
+	SIM_CMD_IFC_READ,
+	SIM_CMD_CSCLK,
+	SIM_CMD_CREG,
+	SIM_CMD_CSQ,
+	SIM_CMD_CMGF,
+	SIM_CMD_CMGF_READ,
+	SIM_CMD_CNMI,
+	SIM_CMD_CNMI_READ,
+	SIM_CMD_CMGS,
+	SIM_CMD_CMGL,
+	SIM_CMD_CMGD,
+	SIM_CMD_ATD,
+	SIM_CMD_ATH,
+	SIM_CMD_CGATT,
+	SIM_CMD_CIPSHUT,
+	SIM_CMD_CIPMODE,
+	SIM_CMD_CSTT,
+	SIM_CMD_CIICR,
+	SIM_CMD_CIFSR,
+	SIM_CMD_CIPSTART,
+	SIM_CMD_CIPSTART_TRANSPARENT,
+	SIM_CMD_ATO,
+	SIM_CMD_CIPCCFG,
+	SIM_CMD_CIPCLOSE,
+	SIM_CMD_CIPSEND,
+	SIM_CMD_CIPTKA,
+	SIM_CMD_CIPSTATUS,
+	SIM_CMD_CIPMUX,
+	SIM_CMD_CIPCLOSE_MUX,
+	SIM_CMD_CIPQSEND,
+	SIM_CMD_CIPSEND_QUICK,
+	SIM_CMD_CIPACK,
+	SIM_CMD_GENERIC,
+	N_SIM_COMMANDS
+}commandSIM_t;
+/*-------------------------------------------------------------------------------------*/
+
 /*--------------- State of GPRS Attachment ------------*/
 #define GPRS_DETACHED   "CGATT: 0"
 #define GPRS_ATTACHED   "CGATT: 1"
@@ -151,42 +286,409 @@ typedef bool bool_t;
  * @brief	Defines the length of the array to form the AT command for voice call
  *
  * @def		LEN_FORMAT_CELL_NUMBER
- * @brief	Defines the length of the array to store the phone number including quotes and country code.
+ * @brief	Defines the length of the array to store the phone number including quotes and country code, it holds
+ * 			an international number of up to 16 characters: '+' and 15 digits.
+ *
+ * @def		LEN_FORMAT_APN
+ * @brief	Defines the length of the array to store the APN of up to 50 bytes including quotes.
+ *
+ * @def		LEN_FORMAT_CONNECTION
+ * @brief	Defines the length of the array to store the parameters of AT+CIPSTART: "TCP","<address>","<port>".
+ *
+ * @def		LEN_PROFILE_INFO
+ * @brief	Defines the length of the array to store the expected information response of each setting of the profile.
+ *
+ * @def		MAX_LENGTH_SEND_DATA
+ * @brief	Defines the maximum number of bytes sent with one AT+CIPSEND=<length> in command mode.
  * */
 #define SERIAL_RESPONSE_BUFFER_SIZE  	100
 #define LEN_BUFFER_AUX_CALL				18
 #define LEN_AT_CMD_CONFIG				15
-#define LEN_FORMAT_CELL_NUMBER			16
-#define LEN_FORMAT_APN					20
+#define LEN_FORMAT_CELL_NUMBER			19
+#define LEN_FORMAT_APN					53
+#define LEN_FORMAT_CONNECTION			64
+#define LEN_PROFILE_INFO				24
+#define MAX_LENGTH_SEND_DATA			1460
+
+/**
+ * @struct	profileSIM_t
+ * @brief	Configuration of the SIM saved in its non-volatile memory with AT&W: text mode, baud rate, echo,
+ * 			indication of the new messages and the flow control requested in SIM800_ConfigHW().
+ * @note	pNewMessageIndication has the parameters of AT+CNMI, for example "2,1,0,0,0" to send +CMTI when
+ * 			an SMS is stored, or NULL to keep the setting of the SIM.
+ * */
+typedef struct
+{
+	uint32_t	baudRate;
+	bool_t		echo;
+	const char	*pNewMessageIndication;
+}profileSIM_t;
+
+/**
+ * @enum	readySIM_t
+ * @brief	Type of enumeration for the readiness levels of the SIM after the power on, in the order in which
+ * 			the SIM announces them: RDY, +CFUN: 1, +CPIN: READY, Call Ready and SMS Ready.
+ * */
+typedef enum
+{
+	SIM_READY_NONE = 0,
+	SIM_READY_UART,
+	SIM_READY_FUNCTIONAL,
+	SIM_READY_PIN,
+	SIM_READY_CALL,
+	SIM_READY_SMS
+}readySIM_t;
+
+/**
+ * @enum	sleepModeSIM_t
+ * @brief	Type of enumeration for the sleep modes of AT+CSCLK. In SIM_SLEEP_DTR the SIM sleeps while the DTR
+ * 			pin is high, in SIM_SLEEP_AUTO it sleeps by itself when the UART has no activity for TIME_AUTO_SLEEP.
+ * */
+typedef enum
+{
+	SIM_SLEEP_DISABLED = 0,
+	SIM_SLEEP_DTR,
+	SIM_SLEEP_AUTO
+}sleepModeSIM_t;
+
+/**
+ * @typedef	powerCallback_t
+ * @brief	Function called from SIM800_Poll() when a power sequence is completed, with OK(0) or ERROR(1).
+ * */
+typedef void (*powerCallback_t)(uint8_t status, void *pContext);
+
+/**
+ * @enum	powerStateSIM_t
+ * @brief	Type of enumeration for the steps of the power sequences.
+ * */
+typedef enum
+{
+	SIM_POWER_IDLE = 0,
+	SIM_POWER_KEY_ON,
+	SIM_POWER_WAIT_READY,
+	SIM_POWER_KEY_DOWN,
+	SIM_POWER_WAIT_IDLE,
+	SIM_POWER_RESET
+}powerStateSIM_t;
+
+/**
+ * @struct	powerSIM_t
+ * @brief	Power sequence in progress: each step lasts duration milliseconds since startTime, the readiness
+ * 			level is waited at most timeout milliseconds since tickStart, the beginning of the sequence.
+ * */
+typedef struct
+{
+	powerStateSIM_t	state;
+	uint32_t		startTime;
+	uint32_t		duration;
+	uint32_t		tickStart;
+	readySIM_t		level;
+	uint32_t		timeout;
+	powerCallback_t	callback;
+	void			*pContext;
+}powerSIM_t;
+
+/**
+ * @typedef	linkCallback_t
+ * @brief	Function called from SIM800_Poll() when the connection is opened, with OK(0), or fails, with ERROR(1).
+ * */
+typedef void (*linkCallback_t)(uint8_t status, void *pContext);
+
+/**
+ * @struct	linkConfigSIM_t
+ * @brief	Configuration of the connection kept open by the connection manager.
+ * @note	pType is TCP or UDP. keepAliveTime is the idle time in seconds before the first TCP keepalive probe,
+ * 			from 30 to 7200, or 0 to disable the keepalive. The structure and its texts must remain valid.
+ * */
+typedef struct
+{
+	const uint8_t	*pApn;
+	const uint8_t	*pType;
+	const uint8_t	*pAddress;
+	const uint8_t	*pPort;
+	uint16_t		keepAliveTime;
+}linkConfigSIM_t;
+
+/**
+ * @enum	linkStateSIM_t
+ * @brief	Type of enumeration for the states of the connection kept open by the connection manager.
+ * */
+typedef enum
+{
+	SIM_LINK_DOWN = 0,
+	SIM_LINK_CONNECTING,
+	SIM_LINK_UP
+}linkStateSIM_t;
+
+/**
+ * @enum	ipStateSIM_t
+ * @brief	Type of enumeration for the states of the TCP/IP stack of the SIM reported by AT+CIPSTATUS.
+ * @note	The states of the connection group the TCP and UDP texts, for example "TCP CLOSED" and "UDP CLOSED".
+ * 			SIM_IP_UNKNOWN means that the SIM did not answer or answered an unknown state.
+ * */
+typedef enum
+{
+	SIM_IP_UNKNOWN = 0,
+	SIM_IP_INITIAL,
+	SIM_IP_START,
+	SIM_IP_CONFIG,
+	SIM_IP_GPRSACT,
+	SIM_IP_STATUS,
+	SIM_IP_CONNECTING,
+	SIM_IP_CONNECTED,
+	SIM_IP_CLOSING,
+	SIM_IP_CLOSED,
+	SIM_IP_PDP_DEACT,
+	N_IP_STATES
+}ipStateSIM_t;
+
+/**
+ * @enum	linkStepSIM_t
+ * @brief	Type of enumeration for the steps of the opening of the connection, one command each.
+ * @note	SIM_LINK_STEP_STATUS reads the state of the TCP/IP stack, which selects the first step to run.
+ * */
+typedef enum
+{
+	SIM_LINK_STEP_STATUS = 0,
+	SIM_LINK_STEP_SHUT,
+	SIM_LINK_STEP_MODE,
+	SIM_LINK_STEP_APN,
+	SIM_LINK_STEP_BEARER,
+	SIM_LINK_STEP_LOCAL_IP,
+	SIM_LINK_STEP_KEEP_ALIVE,
+	SIM_LINK_STEP_START
+}linkStepSIM_t;
+
+/**
+ * @struct	linkStatsSIM_t
+ * @brief	Statistics of the connection manager: connections opened, PDP context activations, data sent on an
+ * 			already open connection, connections lost (CLOSED, +PDP: DEACT or a failed send) and failed openings.
+ * */
+typedef struct
+{
+	uint32_t	connections;
+	uint32_t	activations;
+	uint32_t	reuses;
+	uint32_t	drops;
+	uint32_t	failures;
+}linkStatsSIM_t;
+
+/**
+ * @struct	linkSIM_t
+ * @brief	Connection kept open by the connection manager.
+ * @note	bearerUp is true while the PDP context is active, so a closed connection is opened again with
+ * 			AT+CIPSTART only. stepQueued is true while the command of the current step is in the engine.
+ * */
+typedef struct
+{
+	const linkConfigSIM_t *pConfig;
+	linkStateSIM_t	state;
+	linkStepSIM_t	step;
+	bool_t			stepQueued;
+	bool_t			bearerUp;
+	linkCallback_t	callback;
+	void			*pContext;
+	linkStatsSIM_t	stats;
+}linkSIM_t;
+
+/**
+ * @enum	streamStateSIM_t
+ * @brief	Type of enumeration for the states of a transparent connection. In SIM_STREAM_DATA the bytes written
+ * 			and read are the data of the connection; the escape sequence waits the guard time in
+ * 			SIM_STREAM_GUARD_BEFORE and SIM_STREAM_GUARD_AFTER; in SIM_STREAM_COMMAND the connection remains
+ * 			open while the SIM accepts AT commands, until it is resumed with ATO.
+ * */
+typedef enum
+{
+	SIM_STREAM_CLOSED = 0,
+	SIM_STREAM_DATA,
+	SIM_STREAM_GUARD_BEFORE,
+	SIM_STREAM_GUARD_AFTER,
+	SIM_STREAM_COMMAND
+}streamStateSIM_t;
+
+/**
+ * @struct	streamSIM_t
+ * @brief	Transparent connection: lastWrite is the time of the last byte written, from which the guard time
+ * 			of the escape sequence is measured. The callback is the one of the opening, the resume or the escape.
+ * */
+typedef struct
+{
+	streamStateSIM_t state;
+	uint32_t		lastWrite;
+	atCallback_t	callback;
+	void			*pContext;
+}streamSIM_t;
+
+/**
+ * @struct	quickSendSIM_t
+ * @brief	Quick send mode, AT+CIPQSEND=1: each send is completed by DATA ACCEPT as soon as the SIM takes the
+ * 			data, without waiting for the acknowledgement of the server. inFlight is the number of bytes sent and
+ * 			not yet acknowledged, as far as the driver knows: it grows with each send and is refreshed with
+ * 			AT+CIPACK when it reaches window.
+ * */
+typedef struct
+{
+	bool_t		enabled;
+	uint16_t	window;
+	uint32_t	inFlight;
+}quickSendSIM_t;
+
+/**
+ * @enum	socketStateSIM_t
+ * @brief	Type of enumeration for the states of a connection of the multi-connection mode.
+ * */
+typedef enum
+{
+	SIM_SOCKET_CLOSED = 0,
+	SIM_SOCKET_CONNECTING,
+	SIM_SOCKET_CONNECTED
+}socketStateSIM_t;
+
+/**
+ * @struct	socketSIM_t
+ * @brief	Connection of the multi-connection mode: the data received is stored in rxBuffer until it is read,
+ * 			the bytes that do not fit are discarded and counted in dropped, see SIM800_Socket_Get_Dropped().
+ * 			The storage of rxBuffer belongs to the application and is given when the connection is opened, so a
+ * 			modem that does not use the multi-connection mode does not reserve it. The callback is the one of
+ * 			the opening.
+ * */
+typedef struct
+{
+	socketStateSIM_t state;
+	ringBuffer_t	rxBuffer;
+	uint32_t		dropped;
+	atCallback_t	callback;
+	void			*pContext;
+}socketSIM_t;
+
+/**
+ * @struct	SIM800_t
+ * @brief	Context of a SIM800 modem: its hardware port, the command engine, the buffer for the responses
+ * 			and the configuration.
+ * @note	Every function of the driver receives the context of the modem, so one MCU can drive several
+ * 			modems, each one on its own UART. The structure must remain valid while the modem is in use.
+ * */
+typedef struct
+{
+	portSIM_t	port;
+	atEngine_t	engine;
+	uint8_t		serialResponseBuffer[SERIAL_RESPONSE_BUFFER_SIZE];
+	bool_t		flowControl;
+	readySIM_t	readyLevel;
+	uint32_t	timeToReady;
+	uint32_t	syncBaudRate;
+	uint32_t	syncTime;
+	powerSIM_t	power;
+	sleepModeSIM_t sleepMode;
+	bool_t		asleep;
+	uint32_t	lastActivity;
+	linkSIM_t	link;
+	streamSIM_t	stream;
+	quickSendSIM_t quickSend;
+	bool_t		multiConnection;
+	bool_t		socketHandlers;
+	socketSIM_t	sockets[N_SOCKETS_SIM];
+}SIM800_t;
 
 /*--------------------------------------------- SIM initialization functions ----------------------------------------------------------*/
-uint8_t SIM800_ConfigHW(UART_HandleTypeDef *uartHandler,Port_t powerKeyPort, uint16_t powerKeyPin,Port_t resetPort, uint16_t resetPin);
-uint8_t SIM800_Default_ConfigHW(void);
-uint8_t SIM800_Init(void);
-void	SIM800_On(void);
-void	SIM800_Off(void);
-void	SIM800_restart(void);
+uint8_t SIM800_ConfigHW(SIM800_t *pSIM, UART_HandleTypeDef *uartHandler,Port_t powerKeyPort, uint16_t powerKeyPin,Port_t resetPort, uint16_t resetPin,bool_t flowControl);
+uint8_t SIM800_Default_ConfigHW(SIM800_t *pSIM);
+uint8_t SIM800_Init(SIM800_t *pSIM);
+uint8_t SIM800_Init_Baud(SIM800_t *pSIM, uint32_t baudRate);
+uint8_t SIM800_Init_Profile(SIM800_t *pSIM, const profileSIM_t *pProfile);
+uint8_t SIM800_Set_Baud_Rate(SIM800_t *pSIM, uint32_t baudRate);
+void	SIM800_On(SIM800_t *pSIM);
+uint8_t	SIM800_On_Ready(SIM800_t *pSIM, readySIM_t level, uint32_t timeout);
+readySIM_t SIM800_Get_Ready_Level(SIM800_t *pSIM);
+uint32_t SIM800_Get_Time_To_Ready(SIM800_t *pSIM);
+uint32_t SIM800_Get_Sync_Baud_Rate(SIM800_t *pSIM);
+uint32_t SIM800_Get_Sync_Time(SIM800_t *pSIM);
+void	SIM800_Off(SIM800_t *pSIM);
+void	SIM800_restart(SIM800_t *pSIM);
+uint8_t SIM800_On_Async(SIM800_t *pSIM, readySIM_t level, uint32_t timeout, powerCallback_t callback, void *pContext);
+uint8_t SIM800_Off_Async(SIM800_t *pSIM, powerCallback_t callback, void *pContext);
+uint8_t SIM800_Restart_Async(SIM800_t *pSIM, readySIM_t level, uint32_t timeout, powerCallback_t callback, void *pContext);
+bool_t	SIM800_Is_Power_Busy(SIM800_t *pSIM);
+
+/*------------------------------------------------ Sleep mode --------------------------------------------------*/
+void	SIM800_Config_Sleep_Pins(SIM800_t *pSIM, Port_t dtrPort, uint16_t dtrPin, Port_t riPort, uint16_t riPin);
+uint8_t SIM800_Set_Sleep_Mode(SIM800_t *pSIM, sleepModeSIM_t mode);
+uint8_t SIM800_Sleep(SIM800_t *pSIM);
+bool_t	SIM800_Is_Ring_Indicated(SIM800_t *pSIM);
+
+/*------------------------------------------ Asynchronous commands ---------------------------------------------*/
+void	SIM800_Poll(SIM800_t *pSIM);
+bool_t	SIM800_Is_Busy(SIM800_t *pSIM);
+void	SIM800_Get_Response(SIM800_t *pSIM, atView_t *pResponse);
+void	SIM800_Release_Response(SIM800_t *pSIM);
+uint8_t SIM800_Send_Command(SIM800_t *pSIM, commandSIM_t command, const uint8_t *parameters, atCallback_t callback, void *pContext);
+uint8_t SIM800_Send_AT_Command(SIM800_t *pSIM, const uint8_t *command, uint32_t timeout, atCallback_t callback, void *pContext);
+uint8_t SIM800_Register_URC(SIM800_t *pSIM, const uint8_t *prefix, atUrcCallback_t callback, void *pContext);
+
+/*---------------------------------------- Batches of commands -------------------------------------------------*/
+uint8_t SIM800_Batch_Add(atBatch_t *pBatch, commandSIM_t command, const uint8_t *parameters);
+uint8_t SIM800_Execute_Batch(SIM800_t *pSIM, atBatch_t *pBatch);
+uint8_t SIM800_Send_Batch(SIM800_t *pSIM, const atBatch_t *pBatch, atCallback_t callback, void *pContext);
 
 /*------------------------- Functions for SMS ----------------------------------*/
-uint8_t check_Network_Registration(void);
-uint8_t send_SMS(uint8_t *cellNumber, uint8_t *message);
-uint8_t list_Received_SMS_(const uint8_t *smsToSearch, const uint8_t *status);
-uint8_t delete_SMS(uint8_t index,uint8_t flag);
+uint8_t check_Network_Registration(SIM800_t *pSIM);
+uint8_t check_Network_GPRS_Registration(SIM800_t *pSIM);
+uint8_t send_SMS(SIM800_t *pSIM, uint8_t *cellNumber, uint8_t *message);
+uint8_t list_Received_SMS_(SIM800_t *pSIM, const uint8_t *smsToSearch, const uint8_t *status);
+uint8_t search_Received_SMS(SIM800_t *pSIM, const uint8_t *status, const atMatcher_t *pKeywords, uint32_t *pHits);
+uint8_t delete_SMS(SIM800_t *pSIM, uint8_t index,uint8_t flag);
 
 /*----------- Functions for voice calls ---------*/
-uint8_t call(uint8_t *cellNumber);
-uint8_t endCall(void);
+uint8_t call(SIM800_t *pSIM, uint8_t *cellNumber);
+uint8_t endCall(SIM800_t *pSIM);
 
 /*------------------------------------- Functions for GPRS ----------------------------------*/
-uint8_t check_GPRS_Connection(void);
-uint8_t disable_GPRS_PDP_Context(void);
-uint8_t set_Application_Mode_TCPUDP(uint8_t tcpip_appMode);
-uint8_t setAPN(uint8_t *apn);
-uint8_t bring_Up_Wireless_Connection(void);
-uint8_t start_Up_TCPUDP_Connection(uint8_t *connection, uint8_t *ip_address, uint8_t *port);
-uint8_t close_TCPUDP_Connection(void);
-uint8_t send_Data_TCPUDP ( uint8_t *data, uint8_t tcpip_appMode);
-void 	enable_AT_CMD_In_Transparent_Mode(void);
+uint8_t check_GPRS_Connection(SIM800_t *pSIM);
+uint8_t disable_GPRS_PDP_Context(SIM800_t *pSIM);
+uint8_t set_Application_Mode_TCPUDP(SIM800_t *pSIM, uint8_t tcpip_appMode);
+uint8_t setAPN(SIM800_t *pSIM, uint8_t *apn);
+uint8_t bring_Up_Wireless_Connection(SIM800_t *pSIM);
+uint8_t bring_Up_Wireless_Connection_Async(SIM800_t *pSIM, atCallback_t callback, void *pContext);
+uint8_t start_Up_TCPUDP_Connection(SIM800_t *pSIM, uint8_t *connection, uint8_t *ip_address, uint8_t *port);
+uint8_t start_Up_TCPUDP_Connection_Async(SIM800_t *pSIM, uint8_t *connection, uint8_t *ip_address, uint8_t *port, atCallback_t callback, void *pContext);
+uint8_t close_TCPUDP_Connection(SIM800_t *pSIM);
+ipStateSIM_t get_IP_State(SIM800_t *pSIM);
+uint8_t send_Data_TCPUDP (SIM800_t *pSIM, uint8_t *data, uint8_t tcpip_appMode);
+uint8_t set_Quick_Send_TCPUDP(SIM800_t *pSIM, bool_t enable, uint16_t window);
+uint8_t get_Unacked_Data_TCPUDP(SIM800_t *pSIM, uint32_t *pUnacked);
+void 	enable_AT_CMD_In_Transparent_Mode(SIM800_t *pSIM);
+
+/*--------------------------------------- Transparent mode stream ----------------------------------------------*/
+uint8_t set_Transparent_Config_TCPUDP(SIM800_t *pSIM, uint8_t retries, uint8_t waitTime, uint16_t sendSize);
+uint8_t SIM800_Stream_Open_Async(SIM800_t *pSIM, uint8_t *connection, uint8_t *ip_address, uint8_t *port, atCallback_t callback, void *pContext);
+uint8_t SIM800_Stream_Write(SIM800_t *pSIM, const uint8_t *data, uint16_t length);
+uint16_t SIM800_Stream_Read(SIM800_t *pSIM, uint8_t *data, uint16_t size);
+uint16_t SIM800_Stream_Available(SIM800_t *pSIM);
+uint8_t SIM800_Stream_Escape_Async(SIM800_t *pSIM, atCallback_t callback, void *pContext);
+uint8_t SIM800_Stream_Resume_Async(SIM800_t *pSIM, atCallback_t callback, void *pContext);
+uint8_t SIM800_Stream_Close(SIM800_t *pSIM);
+streamStateSIM_t SIM800_Get_Stream_State(SIM800_t *pSIM);
+
+/*------------------------------------------ Multi-connection mode ---------------------------------------------*/
+uint8_t SIM800_Socket_Init(SIM800_t *pSIM, uint8_t *apn);
+uint8_t SIM800_Socket_Open(SIM800_t *pSIM, uint8_t socket, uint8_t *connection, uint8_t *ip_address, uint8_t *port, uint8_t *rxStorage, uint16_t rxSize);
+uint8_t SIM800_Socket_Open_Async(SIM800_t *pSIM, uint8_t socket, uint8_t *connection, uint8_t *ip_address, uint8_t *port, uint8_t *rxStorage, uint16_t rxSize, atCallback_t callback, void *pContext);
+uint8_t SIM800_Socket_Send(SIM800_t *pSIM, uint8_t socket, const uint8_t *data, uint16_t length);
+uint16_t SIM800_Socket_Read(SIM800_t *pSIM, uint8_t socket, uint8_t *data, uint16_t size);
+uint16_t SIM800_Socket_Available(SIM800_t *pSIM, uint8_t socket);
+uint32_t SIM800_Socket_Get_Dropped(SIM800_t *pSIM, uint8_t socket);
+uint8_t SIM800_Socket_Close(SIM800_t *pSIM, uint8_t socket);
+socketStateSIM_t SIM800_Get_Socket_State(SIM800_t *pSIM, uint8_t socket);
+
+/*---------------------------------------- Connection manager ------------------------------------------------*/
+uint8_t SIM800_Link_Config(SIM800_t *pSIM, const linkConfigSIM_t *pConfig);
+uint8_t SIM800_Link_Connect(SIM800_t *pSIM);
+uint8_t SIM800_Link_Connect_Async(SIM800_t *pSIM, linkCallback_t callback, void *pContext);
+uint8_t SIM800_Link_Send(SIM800_t *pSIM, const uint8_t *data, uint16_t length);
+uint8_t SIM800_Link_Close(SIM800_t *pSIM);
+linkStateSIM_t SIM800_Get_Link_State(SIM800_t *pSIM);
+void	SIM800_Get_Link_Stats(SIM800_t *pSIM, linkStatsSIM_t *pStats);
 
 
 #endif /* SIM800X_INC_SIM800X_H_ */
@@ -0,0 +1,217 @@
+/**
+ * @file 	at_engine.h
+ * @brief	Asynchronous AT command engine: the commands are queued with a completion callback and the exchange
+ * 			with the SIM advances in at_Engine_Poll() as the bytes arrive, without blocking the application.
+ * 			The unsolicited result codes (URC) are routed to the handlers registered by prefix.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#ifndef SIM800X_INC_AT_ENGINE_H_
+#define SIM800X_INC_AT_ENGINE_H_
+
+#include "port.h"
+#include "at_tokenizer.h"
+
+/**
+ * @def		AT_QUEUE_SIZE
+ * @brief	Defines the number of commands that can be waiting in the queue, it must be a power of two.
+ *
+ * @def		AT_COMMAND_SIZE
+ * @brief	Defines the maximum length of the text of a command, without the <CR> terminator.
+ *
+ * @def		AT_URC_HANDLERS
+ * @brief	Defines the maximum number of URC handlers that can be registered.
+ *
+ * @def		AT_BATCH_SIZE
+ * @brief	Defines the maximum number of commands joined in the same command line.
+ *
+ * @def		AT_CTRL_Z
+ * @brief	Defines the ASCII character that ends the text of AT+CMGS, AT+CIPSEND=<length> does not need it.
+ *
+ * @def		AT_RESULT_MASK
+ * @brief	Builds the bit of a result code in the masks of the results that complete a command.
+ *
+ * @def		AT_SUCCESS_DEFAULT
+ * @brief	Defines the result that completes successfully most of the commands.
+ *
+ * @def		AT_FAILURE_DEFAULT
+ * @brief	Defines the error results that any command can return.
+ * */
+#define AT_QUEUE_SIZE								4U
+#define AT_COMMAND_SIZE								80U
+#define AT_URC_HANDLERS								16U
+#define AT_BATCH_SIZE								4U
+#define AT_CTRL_Z									0x1AU
+#define AT_RESULT_MASK(result)						((uint32_t)1U << (uint32_t)(result))
+#define AT_SUCCESS_DEFAULT							AT_RESULT_MASK(AT_RESULT_OK)
+#define AT_FAILURE_DEFAULT							(AT_RESULT_MASK(AT_RESULT_ERROR) | AT_RESULT_MASK(AT_RESULT_CME_ERROR)\
+													| AT_RESULT_MASK(AT_RESULT_CMS_ERROR))
+
+/**
+ * @typedef	atCallback_t
+ * @brief	Function called from at_Engine_Poll() when a command is completed.
+ * @note	The result is AT_RESULT_NONE if the command timed out. The response is seen in place in the response
+ * 			buffer and is only valid during the call, unless it is held with at_Engine_Get_Response().
+ * */
+typedef void (*atCallback_t)(atResult_t result, const atView_t *pResponse, void *pContext);
+
+/**
+ * @typedef	atUrcCallback_t
+ * @brief	Function called from at_Engine_Poll() with a line that starts with the prefix of the handler.
+ * @note	The line has no <CR><LF> and is not terminated with '\0'. Only the first AT_LINE_SIZE characters
+ * 			of a longer line are passed.
+ * */
+typedef void (*atUrcCallback_t)(const uint8_t *pLine, uint8_t length, void *pContext);
+
+/**
+ * @typedef	atDataCallback_t
+ * @brief	Function called from at_Engine_Poll() with the bytes requested with at_Engine_Read_Data().
+ * @note	The bytes are seen in place in the RX buffer of the port, they can arrive in several calls.
+ * */
+typedef void (*atDataCallback_t)(const uint8_t *pData, uint16_t length, void *pContext);
+
+/**
+ * @struct	atUrcHandler_t
+ * @brief	Handler of the unsolicited result codes that start with pPrefix.
+ * */
+typedef struct
+{
+	const uint8_t	*pPrefix;
+	uint8_t			prefixLength;
+	atUrcCallback_t	callback;
+	void			*pContext;
+}atUrcHandler_t;
+
+/**
+ * @struct	atCommandDescriptor_t
+ * @brief	Constant description of an AT command: its syntax, the final result codes that complete it with
+ * 			success or failure, its maximum response time and if it requests its data with the '>' prompt.
+ * @note	pSyntax is the beginning of the command line, the parameters are added after it.
+ * 			For example "AT+CREG?", "AT+CSTT=" or "ATD".
+ * */
+typedef struct
+{
+	const char	*pSyntax;
+	uint32_t	successMask;
+	uint32_t	failureMask;
+	uint32_t	maxResponseTime;
+	bool_t		prompt;
+}atCommandDescriptor_t;
+
+/**
+ * @struct	atCommand_t
+ * @brief	Command waiting in the queue of the engine.
+ * @note	The results of the descriptor complete the command, any other result is skipped.
+ * 			If the descriptor has the prompt and pPayload is not NULL, the payload is sent when the SIM answers
+ * 			with '>', followed by the Ctrl-Z character if payloadCtrlZ is true.
+ * 			The payload is not copied, it must remain valid until the command is completed.
+ * 			The timeout is the maximum response time of the descriptor, unless it is changed before queuing.
+ * 			If pMatcher is not NULL, its keywords are searched in the response as it arrives and the hits are
+ * 			read with at_Engine_Get_Hits().
+ * */
+typedef struct
+{
+	const atCommandDescriptor_t *pDescriptor;
+	uint8_t			text[AT_COMMAND_SIZE];
+	uint8_t			textLength;
+	const uint8_t	*pPayload;
+	uint16_t		payloadLength;
+	bool_t			payloadCtrlZ;
+	uint32_t		timeout;
+	const atMatcher_t *pMatcher;
+	atCallback_t	callback;
+	void			*pContext;
+}atCommand_t;
+
+/**
+ * @struct	atBatch_t
+ * @brief	Commands sent in a single command line, for example AT+CREG?;+CGATT?;+CSQ
+ * @note	The SIM executes the commands in order and answers a single final result code, so the line costs
+ * 			one round trip. at_Batch_Split() assigns a result and the information response to each command:
+ * 			info is the view of the line "+<NAME>: ..." of the command inside the response, or an empty view
+ * 			if the command has no information response.
+ * */
+typedef struct
+{
+	const atCommandDescriptor_t	*pDescriptors[AT_BATCH_SIZE];
+	const uint8_t				*pParameters[AT_BATCH_SIZE];
+	uint8_t						count;
+	atResult_t					results[AT_BATCH_SIZE];
+	atView_t					info[AT_BATCH_SIZE];
+}atBatch_t;
+
+/**
+ * @enum	atEngineState_t
+ * @brief	Type of enumeration for the state of the engine.
+ * */
+typedef enum
+{
+	AT_ENGINE_IDLE = 0,
+	AT_ENGINE_WAIT_RESPONSE
+}atEngineState_t;
+
+/**
+ * @struct	atEngine_t
+ * @brief	Engine state.
+ * @note	The command at queueTail is the one in progress while the state is AT_ENGINE_WAIT_RESPONSE.
+ * 			The received bytes are fed to the tokenizer straight from the RX ring buffer of the port and released
+ * 			as they are consumed, the bytes after the final result code stay there for the next command.
+ * 			The lines of the response are copied once to pResponse and its views point there, not to the ring
+ * 			buffer, which wraps and keeps receiving while the response is in use.
+ * 			responseLength is the length of the last response. While responseHeld is true the next command
+ * 			is not started, so the views of the response remain valid. Nor is it started until holdOffTime
+ * 			has elapsed since holdOffStart.
+ * 			The tokenizer is fed even when no command is in progress, so the URCs are dispatched at any time,
+ * 			except in data mode: then the received bytes are left in the port for the application and no
+ * 			command is started.
+ * 			While rawLength is not 0, the received bytes are passed to rawCallback instead of the tokenizer.
+ * */
+typedef struct
+{
+	portSIM_t		*pPort;
+	atCommand_t		queue[AT_QUEUE_SIZE];
+	uint8_t			queueHead;
+	uint8_t			queueTail;
+	atEngineState_t	state;
+	atTokenizer_t	tokenizer;
+	uint8_t			*pResponse;
+	uint16_t		responseSize;
+	uint16_t		responseLength;
+	bool_t			responseHeld;
+	uint32_t		holdOffStart;
+	uint32_t		holdOffTime;
+	bool_t			dataMode;
+	uint16_t		rawLength;
+	atDataCallback_t rawCallback;
+	void			*pRawContext;
+	uint32_t		tickStart;
+	uint32_t		txFailures;
+	atUrcHandler_t	urcHandlers[AT_URC_HANDLERS];
+	uint8_t			nUrcHandlers;
+	uint32_t		hits;
+}atEngine_t;
+
+void		at_Engine_Init(atEngine_t *pEngine, portSIM_t *pPort, uint8_t *pResponse, uint16_t responseSize);
+bool_t		at_Command_Init(atCommand_t *pCommand, const atCommandDescriptor_t *pDescriptor, const uint8_t *pParameters);
+bool_t		at_Engine_Send(atEngine_t *pEngine, const atCommand_t *pCommand);
+void		at_Engine_Poll(atEngine_t *pEngine);
+bool_t		at_Engine_Is_Busy(const atEngine_t *pEngine);
+uint8_t		at_Engine_Free_Slots(const atEngine_t *pEngine);
+uint32_t	at_Engine_Get_Hits(const atEngine_t *pEngine);
+bool_t		at_Engine_Watch(atEngine_t *pEngine, const atMatcher_t *pMatcher);
+void		at_Engine_Get_Response(atEngine_t *pEngine, atView_t *pView);
+void		at_Engine_Release_Response(atEngine_t *pEngine);
+void		at_Engine_Hold_Off(atEngine_t *pEngine, uint32_t time);
+void		at_Engine_Set_Data_Mode(atEngine_t *pEngine, bool_t enable);
+bool_t		at_Engine_Is_Data_Mode(const atEngine_t *pEngine);
+void		at_Engine_Read_Data(atEngine_t *pEngine, uint16_t length, atDataCallback_t callback, void *pContext);
+void		at_Engine_Flush(atEngine_t *pEngine);
+bool_t		at_Engine_Register_URC(atEngine_t *pEngine, const uint8_t *pPrefix, atUrcCallback_t callback, void *pContext);
+void		at_Batch_Init(atBatch_t *pBatch);
+bool_t		at_Batch_Add(atBatch_t *pBatch, const atCommandDescriptor_t *pDescriptor, const uint8_t *pParameters);
+bool_t		at_Batch_Build(const atBatch_t *pBatch, atCommand_t *pCommand);
+void		at_Batch_Split(atBatch_t *pBatch, atResult_t result, const atView_t *pResponse);
+
+#endif /* SIM800X_INC_AT_ENGINE_H_ */
@@ -16,6 +16,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "stm32f4xx_hal.h"
+#include "ring_buffer.h"
 
 /**
  * @typedef	bool_t
@@ -23,6 +24,86 @@
  * */
 typedef bool bool_t;
 
+/**
+ * @struct	UARTErrorCounters_t
+ * @brief	Counters of the reception errors detected by the UART interrupt.
+ * @note	dropped counts the bytes received correctly but discarded because the RX ring buffer was full.
+ * 			txFailed counts the DMA transmissions refused by the HAL, their data was not sent.
+ * */
+typedef struct
+{
+	uint32_t overrun;
+	uint32_t framing;
+	uint32_t noise;
+	uint32_t parity;
+	uint32_t dropped;
+	uint32_t txFailed;
+}UARTErrorCounters_t;
+
+/**
+ * @enum	RxMode_t
+ * @brief	Type of enumeration for the UART reception mode
+ * @note	RX_MODE_INTERRUPT: each byte is moved to the RX ring buffer by the RXNE interrupt.
+ * 			RX_MODE_DMA: the UART streams into a circular DMA buffer which is moved to the RX ring buffer
+ * 			on the half-transfer, transfer-complete and IDLE-line events.
+ * */
+typedef enum
+{
+	RX_MODE_INTERRUPT = 0,
+	RX_MODE_DMA = 1
+}RxMode_t;
+
+/**
+ * @enum	TxMode_t
+ * @brief	Type of enumeration for the UART transmission mode
+ * @note	TX_MODE_BLOCKING: the data is sent by polling, the CPU waits until the last byte is sent.
+ * 			TX_MODE_DMA: the data is queued and sent by the DMA, the CPU continues with other tasks.
+ * */
+typedef enum
+{
+	TX_MODE_BLOCKING = 0,
+	TX_MODE_DMA = 1
+}TxMode_t;
+
+/**
+ * @typedef	portSIM_t
+ * @brief	A type definition for the port of a SIM, see struct portSIM.
+ * */
+typedef struct portSIM portSIM_t;
+
+/**
+ * @typedef	txCallback_t
+ * @brief	Function called from the interrupt context when all the queued transmissions of a port are completed.
+ * @note	success is false if the HAL refused one of the transmissions since the queue was last empty.
+ * */
+typedef void (*txCallback_t)(portSIM_t *pPort, bool_t success);
+
+/**
+ * @struct	ioVector_t
+ * @brief	Segment of data used by write_Vector_UART() to send several buffers in a single transfer.
+ * */
+typedef struct
+{
+	const uint8_t	*pData;
+	uint16_t		length;
+}ioVector_t;
+
+/**
+ * @struct	txDescriptor_t
+ * @brief	Pending DMA transmission: the data must remain valid until the transmission is completed.
+ * */
+typedef struct
+{
+	const uint8_t	*pData;
+	uint16_t		length;
+}txDescriptor_t;
+
+/**
+ * @def		IO_VECTOR_STRING
+ * @brief	Builds an ioVector_t from a string literal, the length is calculated at compile time.
+ * */
+#define IO_VECTOR_STRING(str)						{(const uint8_t *)(str), (uint16_t)(sizeof(str) - 1U)}
+
 /**
  * @enum	Port_t
  * @brief	Type of enumeration for BlackPill ports
@@ -42,7 +123,7 @@ typedef enum
  * @brief	Defines the minimum time the powerKey pin must be high to turn off the SIM.
  *
  * @def		DELAY_ENTRY_ACTIVE
- * @brief	Defines the time to wait until the SIM stops sending startup messages over the UART.
+ * @brief	Defines the default upper bound of the wait for the messages that announce that the SIM is ready.
  *
  * @def		DELAY_ENTRY_IDLE
  * @brief	Defines the time to wait until the UART goes to the idle state.
@@ -50,8 +131,31 @@ typedef enum
  * @def		DELAY_RESET
  * @brief	Defines the minimum time the reset pin must be high to restart the SIM
  *
+ * @def		DELAY_WAKE_UP
+ * @brief	Defines the time the SIM needs to accept commands after the DTR pin is set low in sleep mode 1.
+ *
  * @def		PINn
  * @brief	Defines the number of pins available per port
+ *
+ * @def		RX_BUFFER_SIZE
+ * @brief	Defines the size of the RX ring buffer filled by the UART interrupt. It must be a power of two.
+ *
+ * @def		DMA_RX_BUFFER_SIZE
+ * @brief	Defines the size of the circular buffer written by the DMA in RX_MODE_DMA. With flow control it must be
+ * 			smaller than RX_BUFFER_SIZE, the reception is paused while the ring buffer has less free space.
+ *
+ * @def		TX_QUEUE_SIZE
+ * @brief	Defines the number of pending DMA transmissions that can be queued. It must be a power of two.
+ *
+ * @def		TX_GATHER_BUFFER_SIZE
+ * @brief	Defines the size of the buffer where write_Vector_UART() gathers the segments before sending them.
+ *
+ * @def		MAX_PORT_INSTANCES
+ * @brief	Defines the maximum number of SIM ports, one per UART: USART1, USART2 and USART6.
+ *
+ * @def		UART_IRQ_PRIORITY
+ * @brief	Defines the NVIC preemption priority of the UART and DMA interrupts. Both interrupts use the
+ * 			same priority so that they never preempt each other while filling the RX ring buffer.
  * */
 #define DEFAULT_POWERKEY_PIN						GPIO_PIN_0
 #define DEFAULT_POWERKEY_GPIO_PORT					GPIOB
@@ -71,26 +175,104 @@ typedef enum
 #define DELAY_POWER_DOWN							2000L
 #define DELAY_ENTRY_IDLE							3000L
 #define DELAY_RESET									200L
+#define DELAY_WAKE_UP								50L
+#define DTR_SLEEP									GPIO_PIN_SET
+#define DTR_WAKE									GPIO_PIN_RESET
 
 #define DEFAULT_USART								USART1
 #define DEFAULT_BAUD_RATE							9600LU
-#define MAX_BAUD_RATE								115200LU
+#define MAX_BAUD_RATE								460800LU
 #define TIMEOUT										1000L
-#define MAX_BUFFER_SIZE								50U
+#define RX_BUFFER_SIZE								256U
+#define DMA_RX_BUFFER_SIZE							128U
+#define TX_QUEUE_SIZE								4U
+#define TX_GATHER_BUFFER_SIZE						128U
+#define UART_IRQ_PRIORITY							5U
+#define MAX_PORT_INSTANCES							3U
 
 #define SUCCESSFUL 									true
 #define UNSUCCESSFUL 								false
 
-bool_t 			config_UART_SIM(UART_HandleTypeDef *uartHandler);
-bool_t 			config_Default_SIM();
-void 			initPowerKeyPin(Port_t portX, uint16_t powerKeyPin);
-void 			initResetPin(Port_t portX, uint16_t resetPin);
-void			power_On_SIM();
-void			power_Down_SIM();
-void			restart_SIM();
-void 			keep_Reset_SIM();
-void 			exit_Reset_SIM();
-void 			write_Data_UART(uint8_t *pDataTx);
-uint8_t			read_Data_UART();
+/**
+ * @struct	portSIM
+ * @brief	Hardware context of a SIM: UART, pins, reception and transmission buffers and their state.
+ * @note	There is one structure per SIM, so several SIMs can be driven at the same time from different UARTs.
+ * 			The fields are private to port.c, the application only allocates the structure and passes its address.
+ * 			The structure must not be moved or released while the UART is running, because the interrupts use it.
+ * */
+struct portSIM
+{
+	UART_HandleTypeDef	UARTHandler;
+	UART_HandleTypeDef	*pUARTHandler;
+	GPIO_TypeDef		*powerKeyPort;
+	uint16_t			powerKeyPin;
+	GPIO_TypeDef		*resetPort;
+	uint16_t			resetPin;
+	GPIO_TypeDef		*dtrPort;
+	uint16_t			dtrPin;
+	GPIO_TypeDef		*riPort;
+	uint16_t			riPin;
+	volatile bool_t		ringIndicated;
+	uint8_t				rxStorage[RX_BUFFER_SIZE];
+	ringBuffer_t		rxRingBuffer;
+	UARTErrorCounters_t	errorCounters;
+	volatile uint16_t	rxFrameEnd;
+	RxMode_t			rxMode;
+	volatile bool_t		rxPaused;
+	bool_t				flowControl;
+	DMA_HandleTypeDef	dmaRxHandler;
+	uint8_t				dmaRxBuffer[DMA_RX_BUFFER_SIZE];
+	uint16_t			dmaRxLastPosition;
+	TxMode_t			txMode;
+	DMA_HandleTypeDef	dmaTxHandler;
+	txDescriptor_t		txQueue[TX_QUEUE_SIZE];
+	volatile uint8_t	txQueueHead;
+	volatile uint8_t	txQueueTail;
+	volatile bool_t		txBusy;
+	volatile bool_t		txError;
+	txCallback_t		txCallback;
+	uint8_t				txGatherBuffer[TX_GATHER_BUFFER_SIZE];
+};
+
+bool_t 			config_UART_SIM(portSIM_t *pPort, UART_HandleTypeDef *uartHandler);
+bool_t 			config_Default_SIM(portSIM_t *pPort);
+bool_t			config_RX_Mode_UART(portSIM_t *pPort, RxMode_t rxMode);
+bool_t			config_TX_Mode_UART(portSIM_t *pPort, TxMode_t txMode);
+bool_t			set_Baud_Rate_UART(portSIM_t *pPort, uint32_t baudRate);
+bool_t			config_Flow_Control_UART(portSIM_t *pPort, bool_t enable);
+uint32_t		get_Baud_Rate_UART(portSIM_t *pPort);
+void 			initPowerKeyPin(portSIM_t *pPort, Port_t portX, uint16_t powerKeyPin);
+void 			initResetPin(portSIM_t *pPort, Port_t portX, uint16_t resetPin);
+void			initDTRPin(portSIM_t *pPort, Port_t portX, uint16_t dtrPin);
+void			initRIPin(portSIM_t *pPort, Port_t portX, uint16_t riPin);
+void			set_DTR_SIM(portSIM_t *pPort, bool_t sleep);
+bool_t			has_DTR_SIM(portSIM_t *pPort);
+bool_t			get_Ring_Indication_SIM(portSIM_t *pPort);
+void			set_Power_Key_SIM(portSIM_t *pPort, bool_t pressed);
+void			power_On_SIM(portSIM_t *pPort);
+void			power_Down_SIM(portSIM_t *pPort);
+void			restart_SIM(portSIM_t *pPort);
+void 			keep_Reset_SIM(portSIM_t *pPort);
+void 			exit_Reset_SIM(portSIM_t *pPort);
+void 			write_Data_UART(portSIM_t *pPort, uint8_t *pDataTx);
+bool_t			write_Data_UART_len(portSIM_t *pPort, const uint8_t *pDataTx, uint16_t length);
+bool_t			write_Vector_UART(portSIM_t *pPort, const ioVector_t *pVector, uint8_t count);
+bool_t			is_TX_Busy_UART(portSIM_t *pPort);
+bool_t			wait_TX_Complete_UART(portSIM_t *pPort, uint32_t timeout);
+void			set_TX_Callback_UART(portSIM_t *pPort, txCallback_t txCallback);
+uint32_t		get_TX_Failures_UART(portSIM_t *pPort);
+uint8_t			read_Data_UART(portSIM_t *pPort);
+uint16_t		read_Buffer_UART(portSIM_t *pPort, uint8_t *pDataRx, uint16_t size);
+uint16_t		peek_Buffer_UART(portSIM_t *pPort, const uint8_t **ppDataRx);
+void			release_Buffer_UART(portSIM_t *pPort, uint16_t count);
+uint16_t		read_Frame_UART(portSIM_t *pPort, uint8_t *pDataRx, uint16_t size, uint32_t timeout);
+uint16_t		available_Data_UART(portSIM_t *pPort);
+void			flush_Data_UART(portSIM_t *pPort);
+void			get_Error_Counters_UART(portSIM_t *pPort, UARTErrorCounters_t *pCounters);
+void			irq_Handler_UART(USART_TypeDef *uartInstance);
+void			irq_Handler_DMA_RX_UART(USART_TypeDef *uartInstance);
+void			irq_Handler_DMA_TX_UART(USART_TypeDef *uartInstance);
+void			irq_Handler_EXTI_SIM(uint16_t gpioPin);
+void			callback_DMA_RX_UART(UART_HandleTypeDef *huart);
 
 #endif /* SIM800X_INC_PORT_H_ */
@@ -9,33 +9,238 @@
 
 #include "SIM800x.h"
 
-/*---------------------- Private variables -----------------------*/
-static uint8_t serialResponseBuffer[SERIAL_RESPONSE_BUFFER_SIZE];
+/**
+ * @struct	commandStatus_t
+ * @brief	Completion of a command executed by the blocking functions of the driver.
+ * */
+typedef struct
+{
+	bool_t		done;
+	atResult_t	result;
+}commandStatus_t;
+
+/**
+ * @struct	powerStatus_t
+ * @brief	Completion of a power sequence or of the opening of the connection executed by the blocking
+ * 			functions of the driver.
+ * */
+typedef struct
+{
+	bool_t		done;
+	uint8_t		status;
+}powerStatus_t;
+
+/*
+ * Maximum response times in milliseconds, taken from the SIM800 Series AT Command Manual.
+ * AT+CIPSEND can take up to 645 s when the network is congested, the wait is limited to 60 s.
+ * */
+#define MAX_TIME_CMGS				60000UL
+#define MAX_TIME_CMGL				20000UL
+#define MAX_TIME_CMGD				25000UL
+#define MAX_TIME_CALL				20000UL
+#define MAX_TIME_CGATT				10000UL
+#define MAX_TIME_CIPSHUT			65000UL
+#define MAX_TIME_CIICR				85000UL
+#define MAX_TIME_CIPSTART			160000UL
+#define MAX_TIME_CIPCLOSE			2000UL
+#define MAX_TIME_CIPSEND			60000UL
+
+#define SUCCESS_CONNECT				(AT_RESULT_MASK(AT_RESULT_CONNECT_OK) | AT_RESULT_MASK(AT_RESULT_ALREADY_CONNECT))
+#define FAILURE_CONNECT				(AT_FAILURE_DEFAULT | AT_RESULT_MASK(AT_RESULT_CONNECT_FAIL))
+#define FAILURE_TRANSPARENT			(FAILURE_CONNECT | AT_RESULT_MASK(AT_RESULT_ALREADY_CONNECT))
+#define FAILURE_SEND				(AT_FAILURE_DEFAULT | AT_RESULT_MASK(AT_RESULT_SEND_FAIL))
+
+/**
+ * @brief	Descriptors of the AT commands, indexed by commandSIM_t.
+ * @note	The table is constant, so it is placed in flash and no command is built at run time.
+ * */
+static const atCommandDescriptor_t commandsSIM[N_SIM_COMMANDS] = {
+	/*						syntax				success									failure				max. response time	prompt */
+	[SIM_CMD_AT]		= {"AT",				AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_ATE]		= {"ATE",				AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_ATW]		= {"AT&W",				AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_IPR]		= {"AT+IPR=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_IPR_READ]	= {"AT+IPR?",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_IFC]		= {"AT+IFC=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_IFC_READ]	= {"AT+IFC?",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CSCLK]		= {"AT+CSCLK=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CREG]		= {"AT+CREG?",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CSQ]		= {"AT+CSQ",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CMGF]		= {"AT+CMGF=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CMGF_READ]	= {"AT+CMGF?",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CNMI]		= {"AT+CNMI=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CNMI_READ]	= {"AT+CNMI?",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CMGS]		= {"AT+CMGS=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	MAX_TIME_CMGS,		true},
+	[SIM_CMD_CMGL]		= {"AT+CMGL=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	MAX_TIME_CMGL,		false},
+	[SIM_CMD_CMGD]		= {"AT+CMGD=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	MAX_TIME_CMGD,		false},
+	[SIM_CMD_ATD]		= {"ATD",				AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	MAX_TIME_CALL,		false},
+	[SIM_CMD_ATH]		= {"ATH",				AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	MAX_TIME_CALL,		false},
+	[SIM_CMD_CGATT]		= {"AT+CGATT?",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	MAX_TIME_CGATT,		false},
+	[SIM_CMD_CIPSHUT]	= {"AT+CIPSHUT",		AT_RESULT_MASK(AT_RESULT_SHUT_OK),		AT_FAILURE_DEFAULT,	MAX_TIME_CIPSHUT,	false},
+	[SIM_CMD_CIPMODE]	= {"AT+CIPMODE=",		AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CSTT]		= {"AT+CSTT=",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIICR]		= {"AT+CIICR",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	MAX_TIME_CIICR,		false},
+	[SIM_CMD_CIFSR]		= {"AT+CIFSR",			AT_RESULT_MASK(AT_RESULT_IP_ADDRESS),	AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIPSTART]	= {"AT+CIPSTART=",		SUCCESS_CONNECT,						FAILURE_CONNECT,	MAX_TIME_CIPSTART,	false},
+	[SIM_CMD_CIPSTART_TRANSPARENT]	= {"AT+CIPSTART=",	AT_RESULT_MASK(AT_RESULT_CONNECT),		FAILURE_TRANSPARENT,	MAX_TIME_CIPSTART,	false},
+	[SIM_CMD_ATO]		= {"ATO",				AT_RESULT_MASK(AT_RESULT_CONNECT),		AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIPCCFG]	= {"AT+CIPCCFG=",		AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIPCLOSE]	= {"AT+CIPCLOSE",		AT_RESULT_MASK(AT_RESULT_CLOSE_OK),		AT_FAILURE_DEFAULT,	MAX_TIME_CIPCLOSE,	false},
+	[SIM_CMD_CIPSEND]	= {"AT+CIPSEND=",		AT_RESULT_MASK(AT_RESULT_SEND_OK),		FAILURE_SEND,		MAX_TIME_CIPSEND,	true},
+	[SIM_CMD_CIPTKA]	= {"AT+CIPTKA=",		AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIPSTATUS]	= {"AT+CIPSTATUS",		AT_RESULT_MASK(AT_RESULT_STATE),		AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIPMUX]	= {"AT+CIPMUX=",		AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIPCLOSE_MUX]	= {"AT+CIPCLOSE=",	AT_RESULT_MASK(AT_RESULT_CLOSE_OK),		AT_FAILURE_DEFAULT,	MAX_TIME_CIPCLOSE,	false},
+	[SIM_CMD_CIPQSEND]	= {"AT+CIPQSEND=",		AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_CIPSEND_QUICK]	= {"AT+CIPSEND=",	AT_RESULT_MASK(AT_RESULT_DATA_ACCEPT),	FAILURE_SEND,		MAX_TIME_CIPSEND,	true},
+	[SIM_CMD_CIPACK]	= {"AT+CIPACK",			AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+	[SIM_CMD_GENERIC]	= {"",					AT_SUCCESS_DEFAULT,						AT_FAILURE_DEFAULT,	TIMEOUT,			false},
+};
+
+/**
+ * @enum	keywordSIM_t
+ * @brief	Keywords searched by the driver in the responses, each one is a bit of the mask of hits.
+ * */
+typedef enum
+{
+	KEYWORD_NETWORK_REGISTERED = 0,
+	KEYWORD_GPRS_ATTACHED,
+	KEYWORD_RDY,
+	KEYWORD_CFUN_FULL,
+	KEYWORD_CPIN_READY,
+	KEYWORD_CALL_READY,
+	KEYWORD_SMS_READY,
+	N_KEYWORDS_SIM
+}keywordSIM_t;
+
+static const char * const keywordsSIM[N_KEYWORDS_SIM] = {
+	[KEYWORD_NETWORK_REGISTERED]	= NETWORK_REGISTERED,
+	[KEYWORD_GPRS_ATTACHED]			= GPRS_ATTACHED,
+	[KEYWORD_RDY]					= URC_RDY,
+	[KEYWORD_CFUN_FULL]				= URC_CFUN_FULL,
+	[KEYWORD_CPIN_READY]			= URC_CPIN_READY,
+	[KEYWORD_CALL_READY]			= URC_CALL_READY,
+	[KEYWORD_SMS_READY]				= URC_SMS_READY,
+};
+
+/**
+ * @brief	Automaton of keywordsSIM, compiled by the first hardware configuration. It is only read afterwards,
+ * 			so it is shared by all the modems.
+ * */
+static atMatcher_t matcherSIM;
+
+/**
+ * @brief	Automaton of the text searched by list_Received_SMS_() and the copy of that text. It is compiled
+ * 			again only when the text changes, so it is kept out of the stack and not rebuilt on every call.
+ * */
+static atMatcher_t matcherSMS;
+static char keywordSMS[AT_MATCHER_STATES];
+
+/**
+ * @brief	Texts of the states of the TCP/IP stack in the answer of AT+CIPSTATUS, indexed by ipStateSIM_t.
+ * @note	They are searched in order in the line "STATE: <state>", so the TCP and UDP states share the text.
+ * */
+static const char * const ipStatesSIM[N_IP_STATES] = {
+	[SIM_IP_INITIAL]	= "IP INITIAL",
+	[SIM_IP_START]		= "IP START",
+	[SIM_IP_CONFIG]		= "IP CONFIG",
+	[SIM_IP_GPRSACT]	= "IP GPRSACT",
+	[SIM_IP_STATUS]		= "IP STATUS",
+	[SIM_IP_CONNECTING]	= "CONNECTING",
+	[SIM_IP_CONNECTED]	= "CONNECT OK",
+	[SIM_IP_CLOSING]	= "CLOSING",
+	[SIM_IP_CLOSED]		= "CLOSED",
+	[SIM_IP_PDP_DEACT]	= "PDP DEACT",
+};
+
+/**
+ * @brief	URCs sent when the server closes a connection of the multi-connection mode, indexed by its number.
+ * */
+static const char * const closedSocketsSIM[N_SOCKETS_SIM] = {
+	"0, CLOSED", "1, CLOSED", "2, CLOSED", "3, CLOSED", "4, CLOSED", "5, CLOSED"
+};
 
 /*--------------------- Prototypes of private functions ----------------------*/
-static void send_Test_Read_AT_CMD( uint8_t* command);
-static void send_Write_Execution_AT_CMD( uint8_t* command, uint8_t* value);
-static void read_Response_SIM(uint8_t *pBuffer);
-static void read_Response_AT_Command_CIPSTART(uint8_t *pBuffer);
+static void build_AT_CMD(atCommand_t *pCommand, commandSIM_t command, const uint8_t *parameters);
+static atResult_t execute_AT_CMD(SIM800_t *pSIM, atCommand_t *pCommand);
+static void wait_Command_SIM(SIM800_t *pSIM, commandStatus_t *pStatus);
+static void store_Result_SIM(atResult_t result, const atView_t *pResponse, void *pContext);
+static uint8_t queue_TCPUDP_Connection(SIM800_t *pSIM, commandSIM_t startCommand, uint8_t *connection, uint8_t *ip_address, uint8_t *port, atCallback_t callback, void *pContext);
+static uint8_t probe_Communication_SIM(SIM800_t *pSIM, uint8_t attempts);
+static uint8_t scan_Baud_Rate_SIM(SIM800_t *pSIM);
+static uint8_t verify_Profile_SIM(SIM800_t *pSIM, const profileSIM_t *pProfile);
+static uint8_t write_Profile_SIM(SIM800_t *pSIM, const profileSIM_t *pProfile, uint32_t currentBaudRate);
+static bool_t is_Baud_Rate_Supported_SIM(uint32_t baudRate);
+static uint8_t switch_Baud_Rate_SIM(SIM800_t *pSIM, uint32_t baudRate, uint32_t previousBaudRate);
+static readySIM_t get_Ready_Level_SIM(uint32_t hits);
+static void poll_Power_SIM(SIM800_t *pSIM);
+static void start_Step_Power_SIM(SIM800_t *pSIM, powerStateSIM_t state, uint32_t duration);
+static void finish_Power_SIM(SIM800_t *pSIM, uint8_t status);
+static void wait_Power_SIM(SIM800_t *pSIM, powerStatus_t *pStatus);
+static void store_Power_SIM(uint8_t status, void *pContext);
+static bool_t wake_Up_SIM(SIM800_t *pSIM, uint8_t nCommands);
+static bool_t compile_Keywords_SIM(void);
+static void poll_Link_SIM(SIM800_t *pSIM);
+static void complete_Step_Link_SIM(atResult_t result, const atView_t *pResponse, void *pContext);
+static void finish_Link_SIM(SIM800_t *pSIM, uint8_t status);
+static linkStepSIM_t get_First_Step_Link_SIM(SIM800_t *pSIM, ipStateSIM_t state);
+static ipStateSIM_t parse_IP_State_SIM(const atView_t *pResponse);
+static void closed_Link_SIM(const uint8_t *pLine, uint8_t length, void *pContext);
+static void deactivated_Link_SIM(const uint8_t *pLine, uint8_t length, void *pContext);
+static void poll_Stream_SIM(SIM800_t *pSIM);
+static void connected_Stream_SIM(atResult_t result, const atView_t *pResponse, void *pContext);
+static void finish_Stream_SIM(SIM800_t *pSIM, streamStateSIM_t state, atResult_t result);
+static uint8_t send_Packet_SIM(SIM800_t *pSIM, const uint8_t *data, uint16_t length);
+static uint8_t wait_Window_SIM(SIM800_t *pSIM, uint16_t length);
+static void connected_Socket_SIM(atResult_t result, const atView_t *pResponse, void *pContext);
+static void closed_Socket_SIM(const uint8_t *pLine, uint8_t length, void *pContext);
+static void received_Socket_SIM(const uint8_t *pLine, uint8_t length, void *pContext);
+static void store_Socket_SIM(const uint8_t *pData, uint16_t length, void *pContext);
 
 /**
  * @brief	Configures the UART, powerKey and reset pins all user-defined.
+ * @note	If the RTS/CTS flow control is requested, the UART starts without it and SIM800_Init() enables it
+ * 			after configuring the SIM with AT+IFC=2,2. Only USART1 (PA11/PA12) and USART2 (PA0/PA1) support it.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @param	Pointer to UART_HandleTypeDef UART_Handle structure.
  * @param	GPIO Port for powerKey
  * @param	GPIO Pin for powerKey
  * @param	GPIO Port for reset
  * @param	GPIO Pin for reset
+ * @param	RTS/CTS hardware flow control: true to enable it, false otherwise.
  * @retval	Integer Value: OK(0) - ERROR(1)
  */
-uint8_t SIM800_ConfigHW(UART_HandleTypeDef *uartHandler,Port_t powerKeyPort, uint16_t powerKeyPin,Port_t resetPort, uint16_t resetPin)
+uint8_t SIM800_ConfigHW(SIM800_t *pSIM, UART_HandleTypeDef *uartHandler,Port_t powerKeyPort, uint16_t powerKeyPin,Port_t resetPort, uint16_t resetPin,bool_t flowControl)
 {
 	uint8_t statusConfigSIM = ERROR;
 
-	if(config_UART_SIM(uartHandler) == SUCCESSFUL)
+	if(uartHandler != NULL)
+		uartHandler->Init.HwFlowCtl = UART_HWCONTROL_NONE;
+
+	if(config_UART_SIM(&pSIM->port, uartHandler) == SUCCESSFUL)
 	{
-		initPowerKeyPin(powerKeyPort,powerKeyPin);
-		initResetPin(resetPort,resetPin);
-		statusConfigSIM = OK;
+		initPowerKeyPin(&pSIM->port, powerKeyPort,powerKeyPin);
+		initResetPin(&pSIM->port, resetPort,resetPin);
+		at_Engine_Init(&pSIM->engine, &pSIM->port, pSIM->serialResponseBuffer, SERIAL_RESPONSE_BUFFER_SIZE);
+		pSIM->flowControl = flowControl;
+		pSIM->readyLevel = SIM_READY_NONE;
+		pSIM->timeToReady = 0;
+		pSIM->syncBaudRate = 0;
+		pSIM->syncTime = 0;
+		pSIM->power.state = SIM_POWER_IDLE;
+		pSIM->sleepMode = SIM_SLEEP_DISABLED;
+		pSIM->asleep = false;
+		pSIM->lastActivity = 0;
+		memset(&pSIM->link, 0, sizeof(pSIM->link));
+		memset(&pSIM->stream, 0, sizeof(pSIM->stream));
+		memset(&pSIM->quickSend, 0, sizeof(pSIM->quickSend));
+		pSIM->multiConnection = false;
+		pSIM->socketHandlers = false;
+		memset(pSIM->sockets, 0, sizeof(pSIM->sockets));
+
+		/* Without the keywords the registration and the start-up messages could never be found */
+		if(compile_Keywords_SIM() == true)
+			statusConfigSIM = OK;
 	}
 
 	return statusConfigSIM;
@@ -44,15 +249,36 @@ uint8_t SIM800_ConfigHW(UART_HandleTypeDef *uartHandler,Port_t powerKeyPort, uin
 /**
  * @brief	Configures the UART and powerKey and reset pins by default.
  * @note	The UART1 is used by default.
- * @param	Pointer to structure UART_HandleTypeDef
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	Integer Value: OK(0) - ERROR(1)
  */
-uint8_t SIM800_Default_ConfigHW()
+uint8_t SIM800_Default_ConfigHW(SIM800_t *pSIM)
 {
 	uint8_t statusConfigSIM = ERROR;
 
-	if(config_Default_SIM() == SUCCESSFUL)
-		statusConfigSIM = OK;
+	if(config_Default_SIM(&pSIM->port) == SUCCESSFUL)
+	{
+		at_Engine_Init(&pSIM->engine, &pSIM->port, pSIM->serialResponseBuffer, SERIAL_RESPONSE_BUFFER_SIZE);
+		pSIM->flowControl = false;
+		pSIM->readyLevel = SIM_READY_NONE;
+		pSIM->timeToReady = 0;
+		pSIM->syncBaudRate = 0;
+		pSIM->syncTime = 0;
+		pSIM->power.state = SIM_POWER_IDLE;
+		pSIM->sleepMode = SIM_SLEEP_DISABLED;
+		pSIM->asleep = false;
+		pSIM->lastActivity = 0;
+		memset(&pSIM->link, 0, sizeof(pSIM->link));
+		memset(&pSIM->stream, 0, sizeof(pSIM->stream));
+		memset(&pSIM->quickSend, 0, sizeof(pSIM->quickSend));
+		pSIM->multiConnection = false;
+		pSIM->socketHandlers = false;
+		memset(pSIM->sockets, 0, sizeof(pSIM->sockets));
+
+		/* Without the keywords the registration and the start-up messages could never be found */
+		if(compile_Keywords_SIM() == true)
+			statusConfigSIM = OK;
+	}
 
 	return statusConfigSIM;
 }
@@ -64,152 +290,692 @@ uint8_t SIM800_Default_ConfigHW()
  * 		The AT commands that are executed in this function are:
  * 			1. AT+IPR=9600	-	Set baud rate to 9600
  * 			2. AT+CMGF=1	-	Set the message system to text mode
- * @param	None
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval Integer Value: OK(0) - ERROR(1)
  */
-uint8_t SIM800_Init()
+uint8_t SIM800_Init(SIM800_t *pSIM)
 {
-	uint8_t iterTest;
-	uint8_t counterOK = 0;
-	uint8_t statusInit;
-	uint8_t nTimesAT = 5;
+	return SIM800_Init_Baud(pSIM, DEFAULT_BAUD_RATE);
+}
+
+/**
+ * @brief	Configure the SIM to work in text mode and negotiate the baud rate passed as a parameter.
+ * @note	The echo of the commands is disabled and the indication of new messages is not changed.
+ * 		See SIM800_Init_Profile().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Baud rate: 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400 or 460800.
+ * @retval Integer Value: OK(0) - ERROR(1)
+ */
+uint8_t SIM800_Init_Baud(SIM800_t *pSIM, uint32_t baudRate)
+{
+	profileSIM_t profile = {baudRate, false, NULL};
 
-	memset(&serialResponseBuffer, 0,SERIAL_RESPONSE_BUFFER_SIZE);
+	return SIM800_Init_Profile(pSIM, &profile);
+}
+
+/**
+ * @brief	Synchronizes the SIM and applies a configuration profile saved in its non-volatile memory.
+ * @note	The synchronization is done at the current baud rate of the UART (9600 after the hardware configuration):
+ * 		"AT" is sent up to N_SYNC_ATTEMPTS times and N_SYNC_OK consecutive OK validate the link. If the SIM
+ * 		does not answer, it may have a different baud rate fixed, so the supported baud rates are scanned.
+ * 		The baud rate found and the time of the synchronization are read with SIM800_Get_Sync_Baud_Rate()
+ * 		and SIM800_Get_Sync_Time().
+ * 		Then the profile saved in the SIM is verified with a single command line:
+ * 			AT+CMGF?;+IFC?;+CNMI?;+IPR?
+ * 		If every setting matches, nothing is written. Otherwise the profile is written and saved with AT&W,
+ * 		so it is only written in the first start-up or after a change of the profile:
+ * 			1. ATE<echo>	-	Enable or disable the echo of the commands
+ * 			2. AT+CMGF=1;+IFC=<flow control>;+CNMI=<indication>;+IPR=<baudRate>	-	Text mode, flow control,
+ * 			indication of new messages and baud rate
+ * 			3. AT&W	-	Save the profile
+ * 		The UART switches to the requested baud rate and the link is verified. If the SIM does not answer at
+ * 		the new baud rate, the UART falls back to the current one, which is fixed in the SIM, and the
+ * 		initialization is still successful. A baud rate that is not supported keeps the current one.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the profile.
+ * @retval Integer Value: OK(0) - ERROR(1)
+ */
+uint8_t SIM800_Init_Profile(SIM800_t *pSIM, const profileSIM_t *pProfile)
+{
+	uint8_t statusInit = ERROR;
+	uint32_t tickStart = HAL_GetTick();
+	profileSIM_t profile = *pProfile;
 
-	/* Auto-bauding routine
-	 * To allow the baud rate to be synchronized, simply issue an "AT" string.
-	 * In this case we send 5 times "AT" and check if the SIM response is OK.
-	 * In case we get at least 4 correct answers, we validate the communication successfully.
-	 * */
-	for(iterTest = 0; iterTest < nTimesAT; iterTest++)
+	/* Auto-bauding routine: the SIM detects the baud rate from the "AT" string */
+	if((probe_Communication_SIM(pSIM, N_SYNC_ATTEMPTS) == OK) || (scan_Baud_Rate_SIM(pSIM) == OK))
 	{
-		send_Test_Read_AT_CMD((uint8_t *)AT_CHECK_COMM);
-		read_Response_SIM(&serialResponseBuffer);
+		pSIM->syncBaudRate = get_Baud_Rate_UART(&pSIM->port);
+		pSIM->syncTime = HAL_GetTick() - tickStart;
 
-		if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
-			counterOK++;
-		HAL_Delay(100);
+		if(is_Baud_Rate_Supported_SIM(profile.baudRate) == false)
+			profile.baudRate = pSIM->syncBaudRate;
+
+		/* The saved profile is only valid if the SIM already answers at its baud rate */
+		if((profile.baudRate == pSIM->syncBaudRate) && (verify_Profile_SIM(pSIM, &profile) == OK))
+		{
+			if((pSIM->flowControl == false) || (config_Flow_Control_UART(&pSIM->port, true) == SUCCESSFUL))
+				statusInit = OK;
+		}
+		else
+			statusInit = write_Profile_SIM(pSIM, &profile, pSIM->syncBaudRate);
 	}
 
-	if(counterOK >= nTimesAT-1)
+	return statusInit;
+}
+
+/**
+ * @brief	Verifies the profile saved in the SIM with a single command line: AT+CMGF?;+IFC?;+CNMI?;+IPR?
+ * @note	The echo is verified in the same response: it has the command line only if the echo is enabled.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the profile, with a supported baud rate.
+ * @retval	Integer Value:
+ * 			OK(0) - Every setting of the SIM matches the profile.
+ * 			ERROR(1) - A setting is different or the SIM did not answer.
+ */
+static uint8_t verify_Profile_SIM(SIM800_t *pSIM, const profileSIM_t *pProfile)
+{
+	uint8_t statusProfile = ERROR;
+	uint8_t expected[LEN_PROFILE_INFO];
+	atBatch_t batch;
+	atView_t response;
+	bool_t match;
+
+	at_Batch_Init(&batch);
+	SIM800_Batch_Add(&batch, SIM_CMD_CMGF_READ, NULL);
+	SIM800_Batch_Add(&batch, SIM_CMD_IFC_READ, NULL);
+	SIM800_Batch_Add(&batch, SIM_CMD_CNMI_READ, NULL);
+	SIM800_Batch_Add(&batch, SIM_CMD_IPR_READ, NULL);
+
+	if(SIM800_Execute_Batch(pSIM, &batch) == OK)
 	{
-		send_Write_Execution_AT_CMD((uint8_t *)AT_CMD_TEXT_MODE,(uint8_t *)TEXT_MODE);
-		read_Response_SIM(&serialResponseBuffer);
+		response.pData = pSIM->serialResponseBuffer;
+		response.length = pSIM->engine.responseLength;
+		match = (at_View_Contains(&response, commandsSIM[SIM_CMD_CMGF_READ].pSyntax) == pProfile->echo);
+
+		snprintf((char *)expected, sizeof(expected), "+CMGF: %s", TEXT_MODE);
+		match = match && at_View_Equals(&batch.info[0], (char *)expected);
+
+		snprintf((char *)expected, sizeof(expected), "+IFC: %s",
+				(pSIM->flowControl == true) ? FLOW_CONTROL_RTS_CTS : FLOW_CONTROL_NONE);
+		match = match && at_View_Equals(&batch.info[1], (char *)expected);
 
-		if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
+		if(pProfile->pNewMessageIndication != NULL)
 		{
-			send_Write_Execution_AT_CMD((uint8_t *)AT_CMD_CONFIG_BAUD,(uint8_t *)DEFAULT_BAUD_RATE_SIM);
-			read_Response_SIM(&serialResponseBuffer);
+			snprintf((char *)expected, sizeof(expected), "+CNMI: %s", pProfile->pNewMessageIndication);
+			match = match && at_View_Equals(&batch.info[2], (char *)expected);
+		}
 
-			if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
-				statusInit = OK;
+		snprintf((char *)expected, sizeof(expected), "+IPR: %lu", (unsigned long)pProfile->baudRate);
+		match = match && at_View_Equals(&batch.info[3], (char *)expected);
+
+		if(match == true)
+			statusProfile = OK;
+	}
+
+	return statusProfile;
+}
+
+/**
+ * @brief	Writes the profile in the SIM, switches the baud rate and saves the profile with AT&W.
+ * @note	The SIM answers OK before applying the flow control and the baud rate.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the profile, with a supported baud rate.
+ * @param	Baud rate at which the SIM is synchronized.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+static uint8_t write_Profile_SIM(SIM800_t *pSIM, const profileSIM_t *pProfile, uint32_t currentBaudRate)
+{
+	uint8_t statusProfile = ERROR;
+	uint8_t valueBaud[LEN_AT_CMD_CONFIG];
+	atCommand_t command;
+	atBatch_t batch;
+
+	build_AT_CMD(&command, SIM_CMD_ATE, (pProfile->echo == true) ? (uint8_t *)ECHO_ON : (uint8_t *)ECHO_OFF);
+
+	if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+	{
+		sprintf((char *)valueBaud,"%lu",(unsigned long)pProfile->baudRate);
+		at_Batch_Init(&batch);
+		SIM800_Batch_Add(&batch, SIM_CMD_CMGF, (uint8_t *)TEXT_MODE);
+		SIM800_Batch_Add(&batch, SIM_CMD_IFC,
+				(pSIM->flowControl == true) ? (uint8_t *)FLOW_CONTROL_RTS_CTS : (uint8_t *)FLOW_CONTROL_NONE);
+		if(pProfile->pNewMessageIndication != NULL)
+			SIM800_Batch_Add(&batch, SIM_CMD_CNMI, (const uint8_t *)pProfile->pNewMessageIndication);
+		SIM800_Batch_Add(&batch, SIM_CMD_IPR, valueBaud);
+
+		if((SIM800_Execute_Batch(pSIM, &batch) == OK)
+				&& ((pSIM->flowControl == false) || (config_Flow_Control_UART(&pSIM->port, true) == SUCCESSFUL)))
+		{
+			if((pProfile->baudRate == currentBaudRate)
+					|| (switch_Baud_Rate_SIM(pSIM, pProfile->baudRate, currentBaudRate) == OK))
+				statusProfile = OK;
 			else
-				statusInit = ERROR;
+			{
+				/* Keep the current baud rate fixed in the SIM */
+				sprintf((char *)valueBaud,"%lu",(unsigned long)currentBaudRate);
+				build_AT_CMD(&command, SIM_CMD_IPR, valueBaud);
+
+				if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+					statusProfile = OK;
+			}
 		}
 	}
+
+	if(statusProfile == OK)
+	{
+		build_AT_CMD(&command, SIM_CMD_ATW, NULL);
+
+		if(execute_AT_CMD(pSIM, &command) != AT_RESULT_OK)
+			statusProfile = ERROR;
+	}
+
+	return statusProfile;
+}
+
+/**
+ * @brief	Changes the baud rate of the SIM and of the UART.
+ * @note	The sequence is as follows:
+ * 			1. AT+IPR=<baudRate> is sent at the current baud rate, the SIM answers OK before switching.
+ * 			2. The UART is reconfigured to the new baud rate (with oversampling by 8 if the clock requires it).
+ * 			3. The link is verified sending "AT" up to N_SYNC_PROBES times.
+ * 			4. If the SIM does not answer, the UART goes back to the previous baud rate and the link is verified again.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Baud rate: 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400 or 460800.
+ * @retval	Integer Value:
+ * 			OK(0) - SIM and UART working at the new baud rate.
+ * 			ERROR(1) - Baud rate not supported or link not verified, the previous baud rate is kept.
+ */
+uint8_t SIM800_Set_Baud_Rate(SIM800_t *pSIM, uint32_t baudRate)
+{
+	uint8_t statusBaud = ERROR;
+	uint8_t valueBaud[LEN_AT_CMD_CONFIG];
+	uint32_t previousBaudRate = get_Baud_Rate_UART(&pSIM->port);
+	atCommand_t command;
+
+	if(is_Baud_Rate_Supported_SIM(baudRate) == true)
+	{
+		sprintf((char *)valueBaud,"%lu",(unsigned long)baudRate);
+		build_AT_CMD(&command, SIM_CMD_IPR, valueBaud);
+
+		if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+			statusBaud = switch_Baud_Rate_SIM(pSIM, baudRate, previousBaudRate);
+	}
+
+	return statusBaud;
+}
+
+/**
+ * @brief	Checks if the baud rate is supported by the SIM and by the UART.
+ * @param	Baud rate.
+ * @retval	Returns true if the baud rate is supported, otherwise false.
+ */
+static bool_t is_Baud_Rate_Supported_SIM(uint32_t baudRate)
+{
+	static const uint32_t baudRatesSIM[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400, 460800};
+	bool_t supported = false;
+	uint8_t i;
+
+	for(i = 0; i < sizeof(baudRatesSIM)/sizeof(baudRatesSIM[0]); i++)
+	{
+		if(baudRatesSIM[i] == baudRate)
+			supported = (baudRate <= MAX_BAUD_RATE);
+	}
+
+	return supported;
+}
+
+/**
+ * @brief	Switches the UART to the baud rate already set in the SIM with AT+IPR and verifies the link.
+ * @note	If the SIM does not answer, the UART goes back to the previous baud rate and the link is verified again.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	New baud rate.
+ * @param	Previous baud rate.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+static uint8_t switch_Baud_Rate_SIM(SIM800_t *pSIM, uint32_t baudRate, uint32_t previousBaudRate)
+{
+	uint8_t statusBaud = ERROR;
+
+	if((set_Baud_Rate_UART(&pSIM->port, baudRate) == SUCCESSFUL) && (probe_Communication_SIM(pSIM, N_SYNC_PROBES) == OK))
+		statusBaud = OK;
 	else
-		statusInit = ERROR;
+	{
+		/* The SIM did not answer at the new baud rate: fall back to the previous one */
+		set_Baud_Rate_UART(&pSIM->port, previousBaudRate);
+		probe_Communication_SIM(pSIM, N_SYNC_PROBES);
+	}
 
-	return statusInit;
+	return statusBaud;
+}
+
+/**
+ * @brief	Verifies the communication with the SIM at the current baud rate.
+ * @note	"AT" is sent until N_SYNC_OK consecutive OK are received, so the function stops as soon as the link
+ * 			is stable. Each "AT" waits at most TIMEOUT_SYNC. It gives up when the remaining attempts can no longer
+ * 			complete the consecutive OK.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Maximum number of "AT" sent.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+static uint8_t probe_Communication_SIM(SIM800_t *pSIM, uint8_t attempts)
+{
+	uint8_t statusProbe = ERROR;
+	uint8_t iterProbe;
+	uint8_t counterOK = 0;
+	atCommand_t command;
+
+	at_Engine_Flush(&pSIM->engine);
+
+	for(iterProbe = 0; (iterProbe < attempts) && (counterOK < N_SYNC_OK)
+			&& ((attempts - iterProbe) >= (N_SYNC_OK - counterOK)); iterProbe++)
+	{
+		build_AT_CMD(&command, SIM_CMD_AT, NULL);
+		command.timeout = TIMEOUT_SYNC;
+
+		if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+			counterOK++;
+		else
+			counterOK = 0;
+	}
+
+	if(counterOK >= N_SYNC_OK)
+		statusProbe = OK;
+
+	return statusProbe;
+}
+
+/**
+ * @brief	Searches the baud rate fixed in the SIM when it does not answer at the current baud rate.
+ * @note	The supported baud rates are tried from the most used ones, the UART is left at the baud rate
+ * 			where the link is verified, or at the initial one if the SIM does not answer at any of them.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+static uint8_t scan_Baud_Rate_SIM(SIM800_t *pSIM)
+{
+	static const uint32_t scanBaudRates[] = {115200, 9600, 57600, 38400, 19200, 230400, 460800, 4800, 2400, 1200};
+	uint8_t statusScan = ERROR;
+	uint32_t initialBaudRate = get_Baud_Rate_UART(&pSIM->port);
+	uint8_t i;
+
+	for(i = 0; (i < sizeof(scanBaudRates)/sizeof(scanBaudRates[0])) && (statusScan == ERROR); i++)
+	{
+		if((scanBaudRates[i] != initialBaudRate) && (is_Baud_Rate_Supported_SIM(scanBaudRates[i]) == true)
+				&& (set_Baud_Rate_UART(&pSIM->port, scanBaudRates[i]) == SUCCESSFUL))
+			statusScan = probe_Communication_SIM(pSIM, N_SYNC_PROBES);
+	}
+
+	if(statusScan == ERROR)
+		set_Baud_Rate_UART(&pSIM->port, initialBaudRate);
+
+	return statusScan;
 }
 
 /**
- * @brief	Sends via the UART the AT command that arrives as a parameter.
- * @note	This function is used for AT commands that query the current value of the parameter(s)
- * 			or to query the list of parameters and value ranges set with the corresponding write command.
- * 			Command format: AT+<command>=? or AT+<command>?
- * @param	Pointer of type uint8_t containing the AT command
+ * @brief	Builds an AT command from its descriptor and its parameters.
+ * @note	Command format: <syntax><parameters>, for example AT+CMGF=1 or AT+CREG?
+ * 			The command gets the maximum response time and the final result codes of its descriptor,
+ * 			it has no payload and no callback.
+ * @param	Pointer to the command to build.
+ * @param	Command of the table of descriptors.
+ * @param	Pointer of type uint8_t containing the parameters, or NULL if the command has no parameters.
  * @retval 	None
  */
-static void send_Test_Read_AT_CMD( uint8_t* command)
+static void build_AT_CMD(atCommand_t *pCommand, commandSIM_t command, const uint8_t *parameters)
+{
+	at_Command_Init(pCommand, &commandsSIM[command], parameters);
+}
+
+/**
+ * @brief	Sends a command and waits for its final result code.
+ * @note	The command is queued in the engine behind the asynchronous commands already queued, and the engine
+ * 			is polled until it is completed. The response remains in the response buffer of the SIM until the
+ * 			next call to the engine.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the command, its callback is replaced.
+ * @retval	Final result code, AT_RESULT_NONE if the command could not be queued or timed out.
+ */
+static atResult_t execute_AT_CMD(SIM800_t *pSIM, atCommand_t *pCommand)
+{
+	commandStatus_t status = {false, AT_RESULT_NONE};
+
+	pCommand->callback = store_Result_SIM;
+	pCommand->pContext = &status;
+
+	/* A held response would stop the engine while this function waits */
+	at_Engine_Release_Response(&pSIM->engine);
+
+	if((wake_Up_SIM(pSIM, 1U) == true) && (at_Engine_Send(&pSIM->engine, pCommand) == true))
+		wait_Command_SIM(pSIM, &status);
+
+	return status.result;
+}
+
+/**
+ * @brief	Polls the engine until the command of the status passed as a parameter is completed.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the status filled in by store_Result_SIM().
+ * @retval	None
+ */
+static void wait_Command_SIM(SIM800_t *pSIM, commandStatus_t *pStatus)
+{
+	while(pStatus->done == false)
+		at_Engine_Poll(&pSIM->engine);
+}
+
+/**
+ * @brief	Completion callback of the commands executed by the blocking functions.
+ * @param	Final result code.
+ * @param	Pointer to the response, not used.
+ * @param	Pointer to the commandStatus_t of the command.
+ * @retval	None
+ */
+static void store_Result_SIM(atResult_t result, const atView_t *pResponse, void *pContext)
+{
+	commandStatus_t *pStatus = (commandStatus_t *)pContext;
+
+	pStatus->result = result;
+	pStatus->done = true;
+}
+
+/**
+ * @brief	Advances the exchange with the SIM of the queued commands, the power sequence and the opening of
+ * 			the connection, without blocking.
+ * @note	It must be called from the main loop while SIM800_Is_Busy() or SIM800_Is_Power_Busy() returns true,
+ * 			or while the connection is being opened. The completion callbacks of the asynchronous functions
+ * 			are called from this function.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None
+ */
+void SIM800_Poll(SIM800_t *pSIM)
 {
-    write_Data_UART(command);
-    write_Data_UART((uint8_t *)"\r");
+	at_Engine_Poll(&pSIM->engine);
+	poll_Power_SIM(pSIM);
+	poll_Link_SIM(pSIM);
+	poll_Stream_SIM(pSIM);
 }
 
 /**
- * @brief	It sends over the UART the AT command together with the configuration parameter.
- * @note 	This function is used for AT commands that sets the user-definable parameter values or when
- * 			execution command reads non-variable parameters.
- * 			Command format: AT+<command>=<value> or AT+<command>
- * @param	Pointer of type uint8_t containing the AT command
- * @param	Pointer of type uint8_t containing the parameter.
+ * @brief	Gets the response of the last completed command without copying it, and holds it.
+ * @note	While the response is held the queued commands are not sent, so it must be released with
+ * 			SIM800_Release_Response() as soon as it is processed. The blocking functions of the driver
+ * 			release it before sending their command. The lines are split with at_View_Next_Line().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the view where the response is stored.
  * @retval	None
  */
-static void send_Write_Execution_AT_CMD( uint8_t* command, uint8_t* value)
+void SIM800_Get_Response(SIM800_t *pSIM, atView_t *pResponse)
+{
+	at_Engine_Get_Response(&pSIM->engine, pResponse);
+}
+
+/**
+ * @brief	Releases the response held by SIM800_Get_Response(), its views are no longer valid.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None
+ */
+void SIM800_Release_Response(SIM800_t *pSIM)
+{
+	at_Engine_Release_Response(&pSIM->engine);
+}
+
+/**
+ * @brief	Checks if there are commands in progress or waiting to be sent.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Returns true while there are commands pending, otherwise false.
+ */
+bool_t SIM800_Is_Busy(SIM800_t *pSIM)
+{
+	return at_Engine_Is_Busy(&pSIM->engine);
+}
+
+/**
+ * @brief	Queues a command of the table of descriptors, the callback is called from SIM800_Poll() with its
+ * 			final result code.
+ * @note	The command waits for the final result codes and the maximum response time of its descriptor.
+ * 			Example: SIM800_Send_Command(&sim800, SIM_CMD_CIICR, NULL, connected, NULL).
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Command of the table of descriptors.
+ * @param	Pointer of type uint8_t containing the parameters, or NULL if the command has no parameters.
+ * @param	Function called when the command is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Command queued.
+ * 			ERROR(1) - Queue full or parameters too long.
+ */
+uint8_t SIM800_Send_Command(SIM800_t *pSIM, commandSIM_t command, const uint8_t *parameters, atCallback_t callback, void *pContext)
+{
+	uint8_t statusQueue = ERROR;
+	atCommand_t atCommand;
+
+	if((command < N_SIM_COMMANDS) && (at_Command_Init(&atCommand, &commandsSIM[command], parameters) == true))
+	{
+		atCommand.callback = callback;
+		atCommand.pContext = pContext;
+
+		if((wake_Up_SIM(pSIM, 1U) == true) && (at_Engine_Send(&pSIM->engine, &atCommand) == true))
+			statusQueue = OK;
+	}
+
+	return statusQueue;
+}
+
+/**
+ * @brief	Queues an AT command, the callback is called from SIM800_Poll() with its final result code.
+ * @note	The command is completed by OK or an error. Example: "AT+GSN".
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer of type uint8_t containing the whole AT command, without the <CR> terminator.
+ * @param	Maximum time to wait for the final result code, in milliseconds.
+ * @param	Function called when the command is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Command queued.
+ * 			ERROR(1) - Queue full or command too long.
+ */
+uint8_t SIM800_Send_AT_Command(SIM800_t *pSIM, const uint8_t *command, uint32_t timeout, atCallback_t callback, void *pContext)
+{
+	uint8_t statusQueue = ERROR;
+	atCommand_t atCommand;
+
+	build_AT_CMD(&atCommand, SIM_CMD_GENERIC, command);
+	atCommand.timeout = timeout;
+	atCommand.callback = callback;
+	atCommand.pContext = pContext;
+
+	if((wake_Up_SIM(pSIM, 1U) == true) && (at_Engine_Send(&pSIM->engine, &atCommand) == true))
+		statusQueue = OK;
+
+	return statusQueue;
+}
+
+/**
+ * @brief	Registers a handler for the unsolicited result codes (URC) that start with the prefix.
+ * @note	The handler is called from SIM800_Poll() or from any blocking function of the driver as soon as the
+ * 			line arrives, also in the middle of the response of another command, which does not receive the line.
+ * 			The handlers must be registered after SIM800_ConfigHW() or SIM800_Default_ConfigHW().
+ * 			Example: SIM800_Register_URC(&sim800, (uint8_t *)URC_NEW_SMS, newSMS, NULL).
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer of type uint8_t containing the prefix: URC_NEW_SMS, URC_RING, URC_CLOSED, URC_PDP_DEACT,
+ * 			URC_CALL_READY, URC_SMS_READY, URC_UNDER_VOLTAGE or another one. It must remain valid.
+ * @param	Function called with each line that starts with the prefix.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Handler registered.
+ * 			ERROR(1) - No free handler.
+ */
+uint8_t SIM800_Register_URC(SIM800_t *pSIM, const uint8_t *prefix, atUrcCallback_t callback, void *pContext)
+{
+	uint8_t statusRegister = ERROR;
+
+	if(at_Engine_Register_URC(&pSIM->engine, prefix, callback, pContext) == true)
+		statusRegister = OK;
+
+	return statusRegister;
+}
+
+/**
+ * @brief	Adds a command of the table of descriptors to a batch, initialized with at_Batch_Init().
+ * @note	Only the extended commands completed by OK and without '>' prompt can be joined, for example
+ * 			SIM_CMD_CREG, SIM_CMD_CGATT, SIM_CMD_CSQ, SIM_CMD_CMGF or SIM_CMD_IPR. The commands without
+ * 			information response, such as the write commands, should be added last (see at_Batch_Split()).
+ * @param	Pointer to the batch.
+ * @param	Command of the table of descriptors.
+ * @param	Pointer of type uint8_t containing the parameters, or NULL. It must remain valid until the batch is sent.
+ * @retval	Integer Value:
+ * 			OK(0) - Command added.
+ * 			ERROR(1) - Batch full or command that cannot be joined.
+ */
+uint8_t SIM800_Batch_Add(atBatch_t *pBatch, commandSIM_t command, const uint8_t *parameters)
+{
+	uint8_t statusAdd = ERROR;
+
+	if((command < N_SIM_COMMANDS) && (at_Batch_Add(pBatch, &commandsSIM[command], parameters) == true))
+		statusAdd = OK;
+
+	return statusAdd;
+}
+
+/**
+ * @brief	Sends the commands of the batch in a single command line and waits for the final result code.
+ * @note	The response is split with at_Batch_Split(): the result and the view of the information response
+ * 			of each command are stored in the batch, the views remain valid until the next command.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the batch.
+ * @retval	Integer Value:
+ * 			OK(0) - All the commands answered OK.
+ * 			ERROR(1) - Line too long, timeout or one of the commands failed.
+ */
+uint8_t SIM800_Execute_Batch(SIM800_t *pSIM, atBatch_t *pBatch)
+{
+	uint8_t statusBatch = ERROR;
+	atCommand_t command;
+	atResult_t result = AT_RESULT_NONE;
+	atView_t response;
+
+	if(at_Batch_Build(pBatch, &command) == true)
+	{
+		result = execute_AT_CMD(pSIM, &command);
+		response.pData = pSIM->serialResponseBuffer;
+		response.length = pSIM->engine.responseLength;
+		at_Batch_Split(pBatch, result, &response);
+	}
+
+	if(result == AT_RESULT_OK)
+		statusBatch = OK;
+
+	return statusBatch;
+}
+
+/**
+ * @brief	Queues the commands of the batch in a single command line, without waiting.
+ * @note	The callback receives the final result code of the line and the response, which is split with
+ * 			at_Batch_Split() inside the callback.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the batch, it can be reused as soon as the function returns.
+ * @param	Function called when the line is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Command line queued.
+ * 			ERROR(1) - Queue full or line too long.
+ */
+uint8_t SIM800_Send_Batch(SIM800_t *pSIM, const atBatch_t *pBatch, atCallback_t callback, void *pContext)
 {
-	write_Data_UART((uint8_t *)"AT+");
-	write_Data_UART((uint8_t *)command);
-	write_Data_UART((uint8_t *)"=");
-	write_Data_UART((uint8_t *)value);
-	write_Data_UART((uint8_t *)"\r");
+	uint8_t statusQueue = ERROR;
+	atCommand_t command;
+
+	if(at_Batch_Build(pBatch, &command) == true)
+	{
+		command.callback = callback;
+		command.pContext = pContext;
+
+		if((wake_Up_SIM(pSIM, 1U) == true) && (at_Engine_Send(&pSIM->engine, &command) == true))
+			statusQueue = OK;
+	}
+
+	return statusQueue;
 }
 
 /**
  * @brief	Check if the SIM is registered in the GSM network.
  * @note	AT command used: AT+CREG
- * @param	None.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	Integer Value:
  * 			OK(0) - SIM is registered in the network.
  * 			ERROR(1) - SIM is not registered in the network.
  */
-uint8_t check_Network_Registration(void)
+uint8_t check_Network_Registration(SIM800_t *pSIM)
 {
 	uint8_t statusReg = ERROR;
+	atCommand_t command;
 
-	memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-
-	send_Test_Read_AT_CMD((uint8_t*)AT_CMD_NETWORK_REGISTER);
-    read_Response_SIM(&serialResponseBuffer);
+	build_AT_CMD(&command, SIM_CMD_CREG, NULL);
+	command.pMatcher = &matcherSIM;
 
-    if(strstr((char *)serialResponseBuffer,(char *)NETWORK_REGISTERED))
+    if((execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+    		&& ((at_Engine_Get_Hits(&pSIM->engine) & AT_MATCHER_HIT(KEYWORD_NETWORK_REGISTERED)) != 0))
     	statusReg = OK;
 
     return statusReg;
 }
 
+/**
+ * @brief	Check if the SIM is registered in the GSM network and attached to the GPRS service with a single
+ * 			command line.
+ * @note	AT command used: AT+CREG?;+CGATT?
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Integer Value:
+ * 			OK(0) - SIM registered in the network and attached to the GPRS service.
+ * 			ERROR(1) - SIM not registered or not attached.
+ */
+uint8_t check_Network_GPRS_Registration(SIM800_t *pSIM)
+{
+	uint8_t statusReg = ERROR;
+	atBatch_t batch;
+
+	at_Batch_Init(&batch);
+	SIM800_Batch_Add(&batch, SIM_CMD_CREG, NULL);
+	SIM800_Batch_Add(&batch, SIM_CMD_CGATT, NULL);
+
+	if((SIM800_Execute_Batch(pSIM, &batch) == OK)
+			&& (at_View_Contains(&batch.info[0], NETWORK_REGISTERED) == true)
+			&& (at_View_Contains(&batch.info[1], GPRS_ATTACHED) == true))
+		statusReg = OK;
+
+	return statusReg;
+}
+
 /**
  * @brief	Sends a text message to a user-specified number
  * @note	AT command used: AT+CMGS
+ * 			The text and the Ctrl-Z terminator are written in a single transfer as soon as the SIM returns '>',
+ * 			then the function waits for the final result code of the command.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @parm	Pointer to buffer of type uint8_t containing the cell number to which the message is to be sent.
  * @parm	Pointer to buffer of type uint8_t containing the text to send
  * @retval	Integer Value:
  * 			OK(0) - Message sent
- * 			ERROR(1) - Message not sent
+ * 			ERROR(1) - Message not sent or cell number longer than LEN_FORMAT_CELL_NUMBER allows
  */
-uint8_t send_SMS(uint8_t *cellNumber, uint8_t *message)
+uint8_t send_SMS(SIM800_t *pSIM, uint8_t *cellNumber, uint8_t *message)
 {
     uint8_t statusSendSMS;
+    atCommand_t command;
     uint8_t formatCellNumber[LEN_FORMAT_CELL_NUMBER];
-    uint8_t ctrlz[2];
 
-	if((cellNumber != NULL) && (message != NULL))
+	/* Format the number to add quotation marks: "+xxxxxxxxxxxx", the number that does not fit is not sent truncated */
+	if((cellNumber != NULL) && (message != NULL)
+			&& (snprintf((char *)formatCellNumber, sizeof(formatCellNumber), "\"%s\"", (const char *)cellNumber) < (int)sizeof(formatCellNumber)))
 	{
-        memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
+		build_AT_CMD(&command, SIM_CMD_CMGS, formatCellNumber);
 
-        /* Format the number to add quotation marks: "++xxxxxxxxxxxx" */
-		sprintf((char *)formatCellNumber,"\"%*s\"",sizeof(cellNumber),cellNumber);
-		send_Write_Execution_AT_CMD((uint8_t *)AT_CMD_SEND_SMS,formatCellNumber);
-        read_Response_SIM(&serialResponseBuffer);
+		/* When the SIM returns the '>' character, the text is sent with the ASCII character CTRLZ(0x1A) */
+		command.pPayload = message;
+		command.payloadLength = strlen((char *)message);
+		command.payloadCtrlZ = true;
 
-        /* Checks if the sim returned the '>' character to enter the text to be sent */
-        if(strstr((char *)serialResponseBuffer,(char *)INPUT_DATA))
-        {
-        	memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-
-        	/* Enter the text and send with the ASCII character CTRLZ(0x1A)*/
-        	write_Data_UART((uint8_t *)message);
-        	HAL_Delay(300);
-        	sprintf((char *)ctrlz,"%c",CTRL_Z);
-        	write_Data_UART(ctrlz);
-
-        	/* Verify the SIM response to validate the sending of the message */
-        	read_Response_SIM(&serialResponseBuffer);
-        	if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
-        		statusSendSMS = OK;
-			else
-				statusSendSMS = ERROR;
-        }
+        /* Verify the SIM response to validate the sending of the message */
+        if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+        	statusSendSMS = OK;
         else
         	statusSendSMS = ERROR;
     }
@@ -225,22 +991,70 @@ uint8_t send_SMS(uint8_t *cellNumber, uint8_t *message)
  * 		by the status parameter.
  * @detail	There should only be 1 unread message when using the RECEIVED UNREAD status.
  * 		AT command used: AT+CMGL
+ * 		The listed messages are marked as read, so to search several texts in the same messages use
+ * 		search_Received_SMS(), which searches all of them in a single listing.
+ * 		The matcher of the text is compiled the first time and again only when the text changes, the text
+ * 		must be shorter than AT_MATCHER_STATES characters.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @parm	Pointer to buffer of type uint8_t containing the text to be searched in the SMS message
  * @parm	Pointer to buffer of type uint8_t containing the status parameter - pag.109 AT Command SIM800
  * @retval	Integer Value:
  * 			OK(0) - Message found
  * 			ERROR(1) - Message not found
  */
-uint8_t list_Received_SMS_(const uint8_t *smsToSearch,const uint8_t *status)
+uint8_t list_Received_SMS_(SIM800_t *pSIM, const uint8_t *smsToSearch,const uint8_t *status)
+{
+    uint8_t statusRxSMS = ERROR;
+    const char *keyword[] = {(const char *)smsToSearch};
+    bool_t compiled = false;
+    uint32_t hits = 0;
+
+    if(smsToSearch != NULL)
+    {
+    	if((keywordSMS[0] != '\0') && (strcmp(keywordSMS, (const char *)smsToSearch) == 0))
+    		compiled = true;
+    	else if((strlen((const char *)smsToSearch) < sizeof(keywordSMS)) && (at_Matcher_Compile(&matcherSMS, keyword, 1) == true))
+    	{
+    		strcpy(keywordSMS, (const char *)smsToSearch);
+    		compiled = true;
+    	}
+    	else
+    		keywordSMS[0] = '\0';
+    }
+
+    if((compiled == true) && (search_Received_SMS(pSIM, status, &matcherSMS, &hits) == OK) && (hits != 0))
+    	statusRxSMS = OK;
+
+    return statusRxSMS;
+}
+
+/**
+ * @brief	Lists the messages with the status passed as a parameter and searches several keywords in them.
+ * @note	AT command used: AT+CMGL
+ * 			The keywords are searched once, as the listing arrives, so they are found even in the messages that
+ * 			do not fit in the response buffer. The matcher is compiled once with at_Matcher_Compile().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to buffer of type uint8_t containing the status parameter: RECEIVED_UNREAD, RECEIVED_READ, ALL...
+ * @param	Pointer to the compiled keywords.
+ * @param	Pointer where the mask of the keywords found is stored, the keyword i is the bit AT_MATCHER_HIT(i).
+ * @retval	Integer Value:
+ * 			OK(0) - Messages listed, the mask can be 0 if no keyword was found.
+ * 			ERROR(1) - Error listing the messages.
+ */
+uint8_t search_Received_SMS(SIM800_t *pSIM, const uint8_t *status, const atMatcher_t *pKeywords, uint32_t *pHits)
 {
     uint8_t statusRxSMS = ERROR;
-	memset(&serialResponseBuffer, 0,SERIAL_RESPONSE_BUFFER_SIZE);
+    atCommand_t command;
 
-    send_Write_Execution_AT_CMD((uint8_t *)AT_CMD_LIST_SMS,(uint8_t *)status);
-    read_Response_SIM(&serialResponseBuffer);
+    build_AT_CMD(&command, SIM_CMD_CMGL, status);
+    command.pMatcher = pKeywords;
 
-    if(strstr((char *)serialResponseBuffer,(char *)smsToSearch))
+    *pHits = 0;
+    if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+    {
+    	*pHits = at_Engine_Get_Hits(&pSIM->engine);
     	statusRxSMS = OK;
+    }
 
     return statusRxSMS;
 }
@@ -248,26 +1062,23 @@ uint8_t list_Received_SMS_(const uint8_t *smsToSearch,const uint8_t *status)
 /**
  * @brief	Delete SMS Message from preferred message storage.
  * @note	AT command used: AT+CMGD
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @parm	Integer value of type uint8_t indicating the position of the message to be deleted.
  * @parm	Integer value of type uint8_t indicating the indicating the criteria for deleting messages.
  * @retval	Integer Value:
  * 			OK(0) - Message deleted
  * 			ERROR(1) - Error deleting message
  */
-uint8_t delete_SMS(uint8_t index,uint8_t flag)
+uint8_t delete_SMS(SIM800_t *pSIM, uint8_t index,uint8_t flag)
 {
 	uint8_t statusDeleteSMS = ERROR;
-	uint8_t value[4];
-
-	memset(&value, 0,sizeof(value));
-	memset(&serialResponseBuffer, 0,SERIAL_RESPONSE_BUFFER_SIZE);
+	atCommand_t command;
+	uint8_t value[LEN_AT_CMD_CONFIG];
 
+	snprintf((char *)value,sizeof(value),"%u,%u",index,flag);
+	build_AT_CMD(&command, SIM_CMD_CMGD, value);
 
-	sprintf((char *)value,"%i,%i",index,flag);
-	send_Write_Execution_AT_CMD((uint8_t *)AT_CMD_DELETE_SMS,(uint8_t *)value);
-	read_Response_SIM(&serialResponseBuffer);
-
-	if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
+	if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
 		statusDeleteSMS = OK;
 
 	return statusDeleteSMS;
@@ -276,27 +1087,26 @@ uint8_t delete_SMS(uint8_t index,uint8_t flag)
 /**
  * @brief	Starts a voice call to the number specified by the parameter cellNumber
  * @note	AT command used: ATD
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @param	Pointer to buffer of type uint8_t containing the cell number
  * @retval	Integer Value:
  * 			OK(0) - Call started
  * 			ERROR(1) - Error starting call
  */
-uint8_t call(uint8_t *cellNumber)
+uint8_t call(SIM800_t *pSIM, uint8_t *cellNumber)
 {
     uint8_t bufferAuxCall[LEN_BUFFER_AUX_CALL];
     uint8_t statusCall = ERROR;
+    atCommand_t command;
 
     /* checks that cellNumber is not null*/
     if(cellNumber != NULL)
     {
-    	memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-
     	/* Form AT command for call: ATD+xxxxxxxxxxxx;*/
-    	sprintf((char *)bufferAuxCall,"%*s%*s;",sizeof(AT_CMD_CALL),AT_CMD_CALL,sizeof(cellNumber),cellNumber);
-        send_Test_Read_AT_CMD(&bufferAuxCall);
-        read_Response_SIM(&serialResponseBuffer);
+    	snprintf((char *)bufferAuxCall,sizeof(bufferAuxCall),"%s;",cellNumber);
+        build_AT_CMD(&command, SIM_CMD_ATD, bufferAuxCall);
 
-        if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
+        if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
         	statusCall = OK;
     }
 
@@ -306,21 +1116,19 @@ uint8_t call(uint8_t *cellNumber)
 /**
  * @brief	Ends a voice call in progress
  * @note	AT command used: ATH
- * @param	None.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	Integer Value:
  * 			OK(0) - Call ended
  * 			ERROR(1) - Error ending call
  */
-uint8_t endCall(void)
+uint8_t endCall(SIM800_t *pSIM)
 {
 
 	uint8_t statusEndCall=ERROR;
+	atCommand_t command;
 
-	memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-
-	send_Test_Read_AT_CMD((uint8_t *)AT_CMD_END_CALL);
-    read_Response_SIM(&serialResponseBuffer);
-    if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
+	build_AT_CMD(&command, SIM_CMD_ATH, NULL);
+    if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
     	statusEndCall = OK;
 
     return statusEndCall;
@@ -329,22 +1137,22 @@ uint8_t endCall(void)
 /**
  * @brief	Check if the SIM is connected to the GPRS service.
  * @note	AT command used: AT+CGATT
- * @param	None.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	Integer Value:
  * 			OK(0) - Connected to GPRS service.
  * 			ERROR(1) - Disconnected to GPRS service.
  */
-uint8_t check_GPRS_Connection(void){
+uint8_t check_GPRS_Connection(SIM800_t *pSIM){
 
 	uint8_t statusGPRS=ERROR;
+	atCommand_t command;
 
-	memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-
-    send_Test_Read_AT_CMD((uint8_t *)AT_CMD_GPRS_SERVICE);
-    read_Response_SIM(&serialResponseBuffer);
+    build_AT_CMD(&command, SIM_CMD_CGATT, NULL);
+    command.pMatcher = &matcherSIM;
 
-    /* Search for text "CGATT: 1" in serialResponseBuffer */
-    if(strstr((char *)serialResponseBuffer,(char *)GPRS_ATTACHED))
+    /* Search for text "CGATT: 1" in the response */
+    if((execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+    		&& ((at_Engine_Get_Hits(&pSIM->engine) & AT_MATCHER_HIT(KEYWORD_GPRS_ATTACHED)) != 0))
     	statusGPRS = OK;
 
     return statusGPRS;
@@ -354,21 +1162,19 @@ uint8_t check_GPRS_Connection(void){
  * @brief	Deactivate GPRS PDP(Packet Data Protocol) context.
  * @note	After it is closed, the status is IP INITIAL
  * 			AT command used: AT+CIPSHUT
- * @param	None.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	Integer Value:
  * 			OK(0) - IP logging successfully disabled.
  * 			ERROR(1) - Error when trying to disable context.
  */
-uint8_t disable_GPRS_PDP_Context(void) {
+uint8_t disable_GPRS_PDP_Context(SIM800_t *pSIM) {
     uint8_t statusShut = ERROR;
+    atCommand_t command;
 
-    memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
+    build_AT_CMD(&command, SIM_CMD_CIPSHUT, NULL);
 
-    send_Test_Read_AT_CMD((uint8_t*)AT_CMD_DESACT_GPRS_CONTEXT);
-    read_Response_SIM(&serialResponseBuffer);
-
-    /* Search for text "CLOSE OK" in serialResponseBuffer */
-    if(strstr((char *)serialResponseBuffer,(char *)SHUT_OK))
+    /* The SIM answers "SHUT OK" */
+    if(execute_AT_CMD(pSIM, &command) == AT_RESULT_SHUT_OK)
     	statusShut = OK;
 
     return statusShut;
@@ -380,24 +1186,27 @@ uint8_t disable_GPRS_PDP_Context(void) {
  * 			so the use of AT commands is not allowed.
  * 			In case you want to enable AT commands use the function enable_AT_CMD_In_Transparent_Mode().
  * 			AT command used: AT+CIPMODE
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @param	Application mode: COMMAND or TRANSPARENT.
  * @retval	Integer Value:
  * 			OK(0) - Application mode configured correctly.
  * 			ERROR(1) - Error while trying to configure the application mode.
  */
-uint8_t set_Application_Mode_TCPUDP(uint8_t tcpip_appMode) {
+uint8_t set_Application_Mode_TCPUDP(SIM800_t *pSIM, uint8_t tcpip_appMode) {
 
     uint8_t  statusCmdMode = ERROR;
+    atCommand_t command;
+    atResult_t result = AT_RESULT_NONE;
 
     if(tcpip_appMode == COMMAND_MODE){
-    	send_Write_Execution_AT_CMD((uint8_t*)CIPMODE,(uint8_t*)"0");
-        read_Response_SIM(&serialResponseBuffer);
+    	build_AT_CMD(&command, SIM_CMD_CIPMODE, (uint8_t*)"0");
+        result = execute_AT_CMD(pSIM, &command);
     }
     else if(tcpip_appMode == TRANSPARENT_MODE){
-    	send_Write_Execution_AT_CMD((uint8_t*)CIPMODE,(uint8_t*)"1");
-        read_Response_SIM(&serialResponseBuffer);
+    	build_AT_CMD(&command, SIM_CMD_CIPMODE, (uint8_t*)"1");
+        result = execute_AT_CMD(pSIM, &command);
     }
-    if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
+    if(result == AT_RESULT_OK)
     	statusCmdMode = OK;
 
     return statusCmdMode;
@@ -410,26 +1219,27 @@ uint8_t set_Application_Mode_TCPUDP(uint8_t tcpip_appMode) {
  * 			state of IP INITIAL. So it is necessary to execute the function disable_GPRS_PDP_Context()
  * 			before user establishes a TCP/UDP connection with this command when the state is not IP INITIAL or IP STATUS.
  * 			After this command is executed, the state will be changed to IP START.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @param	Pointer to buffer of type uint8_t containing the APN of the mobile operator.
  * 			The max length is 50 bytes for APN
  * @retval	Integer Value:
  * 			OK(0) - APN configured correctly.
- * 			ERROR(1) - Error when configuring APN.
+ * 			ERROR(1) - Error when configuring APN or APN longer than 50 bytes.
  */
-uint8_t setAPN(uint8_t *apn) {
+uint8_t setAPN(SIM800_t *pSIM, uint8_t *apn) {
 
-    uint8_t formatAPN[LEN_FORMAT_CELL_NUMBER];
+    uint8_t formatAPN[LEN_FORMAT_APN];
     uint8_t statusAPN = ERROR;
+    atCommand_t command;
 
-    memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-
-    /* Format the APN to add quotation marks: "APN" */
-    sprintf((char *)formatAPN,"\"%*s\"",strlen(apn),apn);
-    send_Write_Execution_AT_CMD((uint8_t*)CSTT,formatAPN);
-    read_Response_SIM(&serialResponseBuffer);
+    /* Format the APN to add quotation marks: "APN", the APN that does not fit is not sent truncated */
+    if(snprintf((char *)formatAPN, sizeof(formatAPN), "\"%s\"", (const char *)apn) < (int)sizeof(formatAPN))
+    {
+    	build_AT_CMD(&command, SIM_CMD_CSTT, formatAPN);
 
-    if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
-    	statusAPN = OK;
+    	if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+    		statusAPN = OK;
+    }
 
     return statusAPN;
 }
@@ -440,26 +1250,40 @@ uint8_t setAPN(uint8_t *apn) {
  * 			AT+CIICR will change to IP CONFIG status, only if the status was previously IP START (APN configured).
  * 			After module accepts the activated operation, if it is activated successfully,
  * 			module state will be changed to IP GPRSACT, and it responds OK, otherwise it will respond ERROR.
- * @param	None.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	Integer Value:
  * 			OK(0) - wireless connection successful.
  * 			ERROR(1) - Error connecting.
  */
-uint8_t bring_Up_Wireless_Connection(void){
+uint8_t bring_Up_Wireless_Connection(SIM800_t *pSIM){
 
     uint8_t  statusGprsConnection =  ERROR;
+    atCommand_t command;
 
-    memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
+    build_AT_CMD(&command, SIM_CMD_CIICR, NULL);
 
-    send_Test_Read_AT_CMD((uint8_t *)AT_CMD_BRING_UP_GPRS_CONEXION);
-    read_Response_SIM(&serialResponseBuffer);
-
-    if(strstr((char *)serialResponseBuffer,(char *)OK_RESPONSE))
+    if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
     	statusGprsConnection = OK;
 
     return statusGprsConnection;
 }
 
+/**
+ * @brief	Queues the command to bring up the wireless connection, without waiting for it.
+ * @note	AT command used: AT+CIICR
+ * 			The callback is called from SIM800_Poll() with AT_RESULT_OK when the module state is IP GPRSACT.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Function called when the command is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Command queued.
+ * 			ERROR(1) - Queue full.
+ */
+uint8_t bring_Up_Wireless_Connection_Async(SIM800_t *pSIM, atCallback_t callback, void *pContext)
+{
+	return SIM800_Send_Command(pSIM, SIM_CMD_CIICR, NULL, callback, pContext);
+}
+
 /**
  * @brief	Get Local IP Address and Start Up TCP/UDP Connection.
  * @note	AT command used: AT+CIFSR
@@ -467,7 +1291,8 @@ uint8_t bring_Up_Wireless_Connection(void){
 			this command, otherwise it will respond ERROR.
  * 			AT command used: AT+CIPSTAR
  * 			This command allows establishment of a TCP/UDP connection only when there is a local IP address.
- * 			To check the status you can use the function send_Test_Read_AT_CMD and send as parameter "CIPSTATUS".
+ * 			To check the status you can use the function get_IP_State().
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @param	Pointer of type uint8_t containing the connection type: TCP  or UDP.
  * @param	Pointer to buffer of type uint8_t containing the remote server IP address
  * @param	Pointer of type uint8_t containing the remote server port
@@ -475,221 +1300,1936 @@ uint8_t bring_Up_Wireless_Connection(void){
  * 			OK(0) - TCP/UDP connection successful.
  * 			ERROR(1) - Error connecting.
  */
-uint8_t start_Up_TCPUDP_Connection(uint8_t *connection, uint8_t *ip_address, uint8_t *port)
+uint8_t start_Up_TCPUDP_Connection(SIM800_t *pSIM, uint8_t *connection, uint8_t *ip_address, uint8_t *port)
 {
-
-    uint8_t stringAux[40];
     uint8_t statusTcpUdpConnection=ERROR;
+    commandStatus_t status = {false, AT_RESULT_NONE};
 
-    memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
+    at_Engine_Release_Response(&pSIM->engine);
 
-    /* Get local IP address*/
-    send_Test_Read_AT_CMD((uint8_t*)AT_CMD_GET_LOCAL_IP);
+    if(queue_TCPUDP_Connection(pSIM, SIM_CMD_CIPSTART, connection, ip_address, port, store_Result_SIM, &status) == OK)
+    {
+    	wait_Command_SIM(pSIM, &status);
+
+    	if(status.result == AT_RESULT_CONNECT_OK)
+    		statusTcpUdpConnection = OK;
+    }
+
+    return statusTcpUdpConnection;
+}
+
+/**
+ * @brief	Queues the commands to get the local IP address and start up the TCP/UDP connection, without waiting.
+ * @note	AT commands used: AT+CIFSR and AT+CIPSTART
+ * 			The callback is called from SIM800_Poll() with AT_RESULT_CONNECT_OK, AT_RESULT_ALREADY_CONNECT or an error.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer of type uint8_t containing the connection type: TCP  or UDP.
+ * @param	Pointer to buffer of type uint8_t containing the remote server IP address
+ * @param	Pointer of type uint8_t containing the remote server port
+ * @param	Function called when the connection is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Commands queued.
+ * 			ERROR(1) - Queue full or parameters too long.
+ */
+uint8_t start_Up_TCPUDP_Connection_Async(SIM800_t *pSIM, uint8_t *connection, uint8_t *ip_address, uint8_t *port, atCallback_t callback, void *pContext)
+{
+	return queue_TCPUDP_Connection(pSIM, SIM_CMD_CIPSTART, connection, ip_address, port, callback, pContext);
+}
 
-    memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-    memset(&stringAux,0,sizeof(stringAux));
+/**
+ * @brief	Queues AT+CIFSR and AT+CIPSTART with the callback of the connection.
+ * @note	AT+CIFSR is completed by the line with the local IP address, it has no OK.
+ * 			AT+CIPSTART answers OK when the command is accepted and CONNECT OK, CONNECT FAIL or ALREADY CONNECT
+ * 			when the connection ends, so the OK is skipped and the result is waited up to its maximum response time.
+ * 			In transparent mode the connection ends with CONNECT instead, see SIM_CMD_CIPSTART_TRANSPARENT.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	SIM_CMD_CIPSTART or SIM_CMD_CIPSTART_TRANSPARENT.
+ * @param	Pointer of type uint8_t containing the connection type: TCP  or UDP.
+ * @param	Pointer to buffer of type uint8_t containing the remote server IP address
+ * @param	Pointer of type uint8_t containing the remote server port
+ * @param	Function called when the connection is completed.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+static uint8_t queue_TCPUDP_Connection(SIM800_t *pSIM, commandSIM_t startCommand, uint8_t *connection, uint8_t *ip_address, uint8_t *port, atCallback_t callback, void *pContext)
+{
+    uint8_t stringAux[LEN_FORMAT_CONNECTION];
+    uint8_t statusQueue = ERROR;
+    atCommand_t localIP;
+    atCommand_t command;
 
-    sprintf((char *)stringAux,"\"%*s\",\"%*s\",\"%*s\"",strlen(connection),connection,strlen(ip_address),ip_address,strlen(port),port);
-    send_Write_Execution_AT_CMD((uint8_t*)AT_CMD_START_TCPUDP_CONEXION,stringAux);
+    /* Get local IP address*/
+    build_AT_CMD(&localIP, SIM_CMD_CIFSR, NULL);
 
-    read_Response_AT_Command_CIPSTART(&serialResponseBuffer);
+    snprintf((char *)stringAux,sizeof(stringAux),"\"%s\",\"%s\",\"%s\"",connection,ip_address,port);
+    build_AT_CMD(&command, startCommand, stringAux);
+    command.callback = callback;
+    command.pContext = pContext;
 
-    if(strstr((char *)serialResponseBuffer,(char *)CONNECT_OK))
-    	statusTcpUdpConnection = OK;
+    /* Both commands are queued or none */
+    if((wake_Up_SIM(pSIM, 2U) == true)
+    		&& (at_Engine_Send(&pSIM->engine, &localIP) == true) && (at_Engine_Send(&pSIM->engine, &command) == true))
+    	statusQueue = OK;
 
-    return statusTcpUdpConnection;
+    return statusQueue;
 }
 
 /**
  * @brief	Close TCP or UDP connection.
  * @note	AT command used: AT+CIPCLOSE
  * 			This command only closes connection at corresponding status of TCP/UDP stack.
- * @param	None.
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	Integer Value:
  * 			OK(0) - Close successful.
  * 			ERROR(1) - Close fail.
  */
-uint8_t close_TCPUDP_Connection(void)
+uint8_t close_TCPUDP_Connection(SIM800_t *pSIM)
 {
 
     uint8_t statusCloseConnection = ERROR;
+    atCommand_t command;
 
-    memset(&serialResponseBuffer,0,SERIAL_RESPONSE_BUFFER_SIZE);
-    send_Test_Read_AT_CMD((uint8_t*)AT_CMD_CLOSE_TCPUDP_CONEXION);
-    read_Response_SIM(&serialResponseBuffer);
+    build_AT_CMD(&command, SIM_CMD_CIPCLOSE, NULL);
 
-    if(strstr((char*)serialResponseBuffer,(char*)CLOSE_OK))
+    if(execute_AT_CMD(pSIM, &command) == AT_RESULT_CLOSE_OK)
     	statusCloseConnection = OK;
 
     return statusCloseConnection;
 }
 
+/**
+ * @brief	Gets the state of the TCP/IP stack of the SIM.
+ * @note	AT command used: AT+CIPSTATUS
+ * 			The SIM answers OK followed by the line "STATE: <state>", the command is completed by that line.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	State of the TCP/IP stack, SIM_IP_UNKNOWN if the SIM did not answer.
+ */
+ipStateSIM_t get_IP_State(SIM800_t *pSIM)
+{
+	ipStateSIM_t state = SIM_IP_UNKNOWN;
+	atCommand_t command;
+	atView_t response;
+
+	build_AT_CMD(&command, SIM_CMD_CIPSTATUS, NULL);
+
+	if(execute_AT_CMD(pSIM, &command) == AT_RESULT_STATE)
+	{
+		response.pData = pSIM->serialResponseBuffer;
+		response.length = pSIM->engine.responseLength;
+		state = parse_IP_State_SIM(&response);
+	}
+
+	return state;
+}
+
 /**
  * @brief	Send data through TCP or UDP connection to the server.
- * @note	AT command used: AT+CIPSEND
+ * @note	AT command used: AT+CIPSEND=<length>
+ * 			In command mode the length of the data is given in the command, so the data is sent as soon as the
+ * 			SIM returns '>' without the Ctrl-Z terminator, and the data can contain any byte. Up to
+ * 			MAX_LENGTH_SEND_DATA bytes are sent at a time. In quick send mode the send is completed by
+ * 			DATA ACCEPT instead of SEND OK, see set_Quick_Send_TCPUDP().
+ * 			In transparent mode the data is written to the stream opened with SIM800_Stream_Open_Async(), see
+ * 			SIM800_Stream_Write().
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @param	Pointer to buffer of type uint8_t containing the data to send
  * @param	Integer value that specifies the application mode: COMMAND MODE(0) or TRANSPARENT MODE(1)
  * @retval	Integer Value:
  * 			OK(0) - Data successfully sent.
  * 			ERROR(1) - Error sending data.
  */
-uint8_t send_Data_TCPUDP(uint8_t *data, uint8_t tcpip_appMode)
+uint8_t send_Data_TCPUDP(SIM800_t *pSIM, uint8_t *data, uint8_t tcpip_appMode)
 {
-    uint8_t serialRespBufferSIM800[256];
-    uint8_t ctrlz[2];
     uint8_t statusSendData = ERROR;
+    size_t lengthData = strlen((char *)data);
 
-    memset(&serialRespBufferSIM800, 0,sizeof(serialRespBufferSIM800));
-    if(tcpip_appMode == COMMAND_MODE)
-    {
-        send_Test_Read_AT_CMD((uint8_t*)AT_CMD_SEND_DATA_TCPUDP);
-        read_Response_SIM(&serialRespBufferSIM800);
+    if((tcpip_appMode == COMMAND_MODE) && (lengthData > 0) && (lengthData <= MAX_LENGTH_SEND_DATA))
+    	statusSendData = send_Packet_SIM(pSIM, data, (uint16_t)lengthData);
+    else if((tcpip_appMode == TRANSPARENT_MODE) && (lengthData > 0) && (lengthData <= UINT16_MAX))
+    	statusSendData = SIM800_Stream_Write(pSIM, data, (uint16_t)lengthData);
 
-        /* Checks if the SIM returned the '>' character to enter the data to be sent */
-        if(strstr((char *)serialRespBufferSIM800,(char *)INPUT_DATA))
-        {
-        	memset(&serialRespBufferSIM800, 0,sizeof(serialRespBufferSIM800));
+    return statusSendData;
+}
 
-        	/* Enter the data and send with the ASCII character CTRLZ(0x1A)*/
-        	write_Data_UART(data);
-        	HAL_Delay(300);
-        	sprintf((char *)ctrlz,"%c",CTRL_Z);
-        	write_Data_UART(ctrlz);
+/**
+ * @brief	Enables or disables the quick send mode of the connections in command mode.
+ * @note	AT command used: AT+CIPQSEND=<mode>
+ * 			In normal mode AT+CIPSEND is completed by SEND OK, which the SIM only sends when the server has
+ * 			acknowledged the data, so each send costs a round trip of the network. In quick send mode it is
+ * 			completed by DATA ACCEPT as soon as the SIM takes the data, so several sends are in flight at the
+ * 			same time. The bytes not yet acknowledged are limited to window: when a send would exceed it, the
+ * 			driver queries AT+CIPACK every QUICK_SEND_ACK_TIME until the server acknowledges enough data, at
+ * 			most QUICK_SEND_TIMEOUT. It must be set before the connection is opened.
+ * 			It cannot be enabled in multi-connection mode, SIM800_Socket_Send() always waits for SEND OK.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	true to enable the quick send mode, false to wait for SEND OK.
+ * @param	Maximum number of bytes not yet acknowledged. Default QUICK_SEND_WINDOW.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+uint8_t set_Quick_Send_TCPUDP(SIM800_t *pSIM, bool_t enable, uint16_t window)
+{
+	uint8_t statusQuick = ERROR;
+	atCommand_t command;
 
-        	read_Response_SIM(&serialRespBufferSIM800);
+	build_AT_CMD(&command, SIM_CMD_CIPQSEND, (enable == true) ? (const uint8_t *)"1" : (const uint8_t *)"0");
 
-        	if(strstr((char*)serialRespBufferSIM800,(char*)SEND_OK))
-        		statusSendData = OK;
-        }
-    }
-    else if(tcpip_appMode == TRANSPARENT_MODE)
-    {
-    	write_Data_UART(data);
-    	statusSendData = OK;
-    }
+	if((window > 0) && ((enable == false) || (pSIM->multiConnection == false))
+			&& (execute_AT_CMD(pSIM, &command) == AT_RESULT_OK))
+	{
+		pSIM->quickSend.enabled = enable;
+		pSIM->quickSend.window = window;
+		pSIM->quickSend.inFlight = 0;
+		statusQuick = OK;
+	}
 
-    return statusSendData;
+	return statusQuick;
+}
+
+/**
+ * @brief	Gets the number of bytes sent through the connection and not yet acknowledged by the server.
+ * @note	AT command used: AT+CIPACK
+ * 			The SIM answers "+CIPACK: <txlen>,<acklen>,<nacklen>" followed by OK, the result is <nacklen>.
+ * 			It also refreshes the bytes in flight of the quick send mode.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer where the number of bytes is stored.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+uint8_t get_Unacked_Data_TCPUDP(SIM800_t *pSIM, uint32_t *pUnacked)
+{
+	uint8_t statusAck = ERROR;
+	atCommand_t command;
+	atView_t response;
+	atView_t line;
+	uint32_t values[3] = {0, 0, 0};
+	uint8_t nValues = 0;
+	uint16_t i;
+
+	build_AT_CMD(&command, SIM_CMD_CIPACK, NULL);
+
+	if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+	{
+		response.pData = pSIM->serialResponseBuffer;
+		response.length = pSIM->engine.responseLength;
+
+		while((statusAck == ERROR) && (at_View_Next_Line(&response, &line) == true))
+		{
+			if(at_View_Starts_With(&line, CIPACK_RESPONSE) == true)
+			{
+				for(i = strlen(CIPACK_RESPONSE); (i < line.length) && (nValues < 3U); i++)
+				{
+					if((line.pData[i] >= '0') && (line.pData[i] <= '9'))
+						values[nValues] = (values[nValues] * 10U) + (line.pData[i] - '0');
+					else if(line.pData[i] == ',')
+						nValues++;
+				}
+
+				if(nValues == 2U)
+				{
+					*pUnacked = values[2];
+					pSIM->quickSend.inFlight = values[2];
+					statusAck = OK;
+				}
+			}
+		}
+	}
+
+	return statusAck;
 }
 
 /**
  * @brief	Temporarily enable AT commands in transparent mode.
- * @note	AT command used: AT+CIPCLOSE
- * @param	None.
+ * @note	It sends the escape sequence and waits until the SIM is in command mode, at least twice
+ * 			GUARD_TIME_ESCAPE. See SIM800_Stream_Escape_Async() to do it without waiting.
+ * 			The connection is resumed with SIM800_Stream_Resume_Async().
+ * @param	Pointer to the SIM800_t structure of the modem.
  * @retval	None
  */
-void enable_AT_CMD_In_Transparent_Mode(void)
+void enable_AT_CMD_In_Transparent_Mode(SIM800_t *pSIM)
 {
-    uint8_t i;
+	commandStatus_t status = {false, AT_RESULT_NONE};
 
-    for(i = 0; i<3; i++){
-        write_Data_UART((uint8_t *)"+");
-        HAL_Delay(1000);
-    }
+	if(SIM800_Stream_Escape_Async(pSIM, store_Result_SIM, &status) == OK)
+	{
+		while(status.done == false)
+			SIM800_Poll(pSIM);
+	}
 }
 
 /**
- * @brief	Reads the UART receive buffer and stores the response to AT commands.
- * @note	The reading is done by polling.
- * @param	Pointer to the buffer of type uint8_t where the SIM response is stored.
- * @retval	None
+ * @brief	Configures the packing of the data of the transparent connections.
+ * @note	AT command used: AT+CIPCCFG=<NmRetry>,<WaitTm>,<SendSz>,1
+ * 			The SIM sends a packet when it has sendSize bytes or when no byte arrives for waitTime, so a short
+ * 			waitTime lowers the latency of small writes and a sendSize close to the writes of the application
+ * 			avoids splitting them. The escape sequence is enabled. It must be set before the connection is opened.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of retransmissions of a packet, from 3 to 8. Default TRANSPARENT_RETRIES.
+ * @param	Time to wait for more data, in units of 100 ms, from 1 to 10. Default TRANSPARENT_WAIT_TIME.
+ * @param	Bytes that fill a packet, from 1 to 1460. Default TRANSPARENT_SEND_SIZE.
+ * @retval	Integer Value: OK(0) - ERROR(1)
  */
-static void read_Response_SIM(uint8_t *pBuffer)
+uint8_t set_Transparent_Config_TCPUDP(SIM800_t *pSIM, uint8_t retries, uint8_t waitTime, uint16_t sendSize)
 {
-  uint8_t data[1];
+	uint8_t statusConfig = ERROR;
+	uint8_t parameters[LEN_AT_CMD_CONFIG];
+	atCommand_t command;
+
+	snprintf((char *)parameters, sizeof(parameters), "%u,%u,%u,1", (unsigned int)retries, (unsigned int)waitTime,
+			(unsigned int)sendSize);
+	build_AT_CMD(&command, SIM_CMD_CIPCCFG, parameters);
 
-  do
-  {
-	  /* Get a character from the USART and save Buffer*/
-	  data[0] = read_Data_UART();
-	  *pBuffer = data[0];
+	if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+		statusConfig = OK;
+
+	return statusConfig;
+}
 
-	  /*Verify if the SIM response is the character for data entry*/
-	  if (*pBuffer == (uint8_t)INPUT_DATA)
-		  break;
+/**
+ * @brief	Opens a transparent connection, without waiting: once it is open the data is written and read as a
+ * 			stream, without AT commands.
+ * @note	AT commands used: AT+CIFSR and AT+CIPSTART
+ * 			The application mode must be TRANSPARENT_MODE, see set_Application_Mode_TCPUDP(). The callback is
+ * 			called from SIM800_Poll() with AT_RESULT_CONNECT when the SIM is in data mode, or with an error.
+ * 			In data mode the driver does not read the UART, the received data is read with SIM800_Stream_Read()
+ * 			and no AT command is accepted until the escape sequence, see SIM800_Stream_Escape_Async(): the
+ * 			functions of the driver that send commands return ERROR in the meantime.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer of type uint8_t containing the connection type: TCP  or UDP.
+ * @param	Pointer to buffer of type uint8_t containing the remote server IP address
+ * @param	Pointer of type uint8_t containing the remote server port
+ * @param	Function called when the connection is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Commands queued.
+ * 			ERROR(1) - A transparent connection is open, queue full or parameters too long.
+ */
+uint8_t SIM800_Stream_Open_Async(SIM800_t *pSIM, uint8_t *connection, uint8_t *ip_address, uint8_t *port, atCallback_t callback, void *pContext)
+{
+	uint8_t statusStream = ERROR;
 
-	  /**
-	   * Commands are usually followed by a response that includes <CR><LF><response><CR><LF>.
-	   * In this case check if the response is OK.
-	   * */
-	  else if((*pBuffer == 'K') && (*(pBuffer - 1) == 'O'))
-	  {
-		  /* This sequence is used to read the last <CR><LF> without buffering them */
-		  ++pBuffer;
-		  read_Data_UART();
+	if((pSIM->stream.state == SIM_STREAM_CLOSED)
+			&& (queue_TCPUDP_Connection(pSIM, SIM_CMD_CIPSTART_TRANSPARENT, connection, ip_address, port, connected_Stream_SIM, pSIM) == OK))
+	{
+		pSIM->stream.callback = callback;
+		pSIM->stream.pContext = pContext;
+		statusStream = OK;
+	}
 
-		  ++pBuffer;
-		  read_Data_UART();
+	return statusStream;
+}
 
-		  break;
-	  }
+/**
+ * @brief	Writes data to the transparent connection, without waiting.
+ * @note	The SIM packs the data as configured with set_Transparent_Config_TCPUDP(). In TX_MODE_DMA the data is
+ * 			not copied, it must remain valid until is_TX_Busy_UART() returns false.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the data, it can contain any byte.
+ * @param	Number of bytes.
+ * @retval	Integer Value:
+ * 			OK(0) - Data written or queued.
+ * 			ERROR(1) - The connection is not in data mode or the transmission queue is full.
+ */
+uint8_t SIM800_Stream_Write(SIM800_t *pSIM, const uint8_t *data, uint16_t length)
+{
+	uint8_t statusWrite = ERROR;
 
-  }while(pBuffer++);
+	if((pSIM->stream.state == SIM_STREAM_DATA) && (write_Data_UART_len(&pSIM->port, data, length) == SUCCESSFUL))
+	{
+		pSIM->stream.lastWrite = HAL_GetTick();
+		statusWrite = OK;
+	}
 
+	return statusWrite;
 }
 
 /**
- * @brief	Reads the UART receive buffer and stores the response of the "AT+CIPSTART" command only.
- * @note	The reading is done by polling. This function is only called by start_Up_TCPUDP_Connection() function.
- * @param	Pointer to the buffer of type uint8_t where the SIM response is stored.
- * @retval	None
+ * @brief	Reads the data received from the transparent connection, without waiting.
+ * @note	If the server closes the connection the SIM sends "CLOSED" among the data and returns to command
+ * 			mode, then the application must call SIM800_Stream_Close().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the buffer where the data is copied.
+ * @param	Size of the buffer.
+ * @retval	Number of bytes read, 0 if there is no data or the connection is not in data mode.
  */
-static void read_Response_AT_Command_CIPSTART(uint8_t *pBuffer)
+uint16_t SIM800_Stream_Read(SIM800_t *pSIM, uint8_t *data, uint16_t size)
 {
-  uint8_t data[1];
+	uint16_t length = 0;
 
-    do
-    {
-          data[0] = read_Data_UART();
-          *pBuffer = data[0];
+	if(at_Engine_Is_Data_Mode(&pSIM->engine) == true)
+		length = read_Buffer_UART(&pSIM->port, data, size);
+
+	return length;
+}
 
-          /**
-           * The response to a successful connection is <CR><LF>CONNECT OK<CR><LF>.
-           * In this case we only search for the character sequence "T OK" as successful confirmation.
-           * */
-          if((*pBuffer == 'K') && (*(pBuffer - 1) == 'O') && (*(pBuffer - 2) == ' ') && (*(pBuffer - 3) == 'T'))
-          {
-        	/* This sequence is used to read the last <CR><LF> without buffering them */
-        	++pBuffer;
-          	read_Data_UART();
+/**
+ * @brief	Gets the number of bytes received from the transparent connection and not yet read.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Number of bytes, 0 if the connection is not in data mode.
+ */
+uint16_t SIM800_Stream_Available(SIM800_t *pSIM)
+{
+	uint16_t length = 0;
+
+	if(at_Engine_Is_Data_Mode(&pSIM->engine) == true)
+		length = available_Data_UART(&pSIM->port);
 
-          	++pBuffer;
-          	read_Data_UART();
+	return length;
+}
 
-          	break;
-          }
+/**
+ * @brief	Switches the transparent connection to command mode with the escape sequence, without waiting.
+ * @note	SIM800_Poll() sends ESCAPE_SEQUENCE when nothing has been written for GUARD_TIME_ESCAPE, and calls
+ * 			the callback with AT_RESULT_OK GUARD_TIME_ESCAPE later, when the SIM accepts AT commands. Nothing
+ * 			can be written in the meantime. The connection remains open, see SIM800_Stream_Resume_Async().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Function called when the SIM is in command mode, it can be NULL. The response is empty.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Escape sequence started.
+ * 			ERROR(1) - The connection is not in data mode.
+ */
+uint8_t SIM800_Stream_Escape_Async(SIM800_t *pSIM, atCallback_t callback, void *pContext)
+{
+	uint8_t statusEscape = ERROR;
 
-    }while(pBuffer++);
+	if(pSIM->stream.state == SIM_STREAM_DATA)
+	{
+		pSIM->stream.callback = callback;
+		pSIM->stream.pContext = pContext;
+		pSIM->stream.state = SIM_STREAM_GUARD_BEFORE;
+		statusEscape = OK;
+	}
 
+	return statusEscape;
 }
 
 /**
- * @brief	Turn on SIM.
- * @param	None.
- * @retval	None.
+ * @brief	Returns the transparent connection to data mode after the escape sequence, without waiting.
+ * @note	AT command used: ATO
+ * 			The callback is called from SIM800_Poll() with AT_RESULT_CONNECT when the SIM is in data mode.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Function called when the command is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Command queued.
+ * 			ERROR(1) - The connection is not in command mode or the queue is full.
  */
-void SIM800_On()
+uint8_t SIM800_Stream_Resume_Async(SIM800_t *pSIM, atCallback_t callback, void *pContext)
 {
-	exit_Reset_SIM();
-	power_On_SIM();
+	uint8_t statusResume = ERROR;
+
+	if((pSIM->stream.state == SIM_STREAM_COMMAND)
+			&& (SIM800_Send_Command(pSIM, SIM_CMD_ATO, NULL, connected_Stream_SIM, pSIM) == OK))
+	{
+		pSIM->stream.callback = callback;
+		pSIM->stream.pContext = pContext;
+		statusResume = OK;
+	}
+
+	return statusResume;
 }
 
 /**
- * @brief	Turn off SIM.
- * @param	None.
- * @retval	None.
+ * @brief	Closes the transparent connection.
+ * @note	AT command used: AT+CIPCLOSE
+ * 			In command mode the connection is closed with AT+CIPCLOSE. In data mode the SIM must have already
+ * 			left it, because the server closed the connection, otherwise the escape sequence must be sent first.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Integer Value:
+ * 			OK(0) - Connection closed.
+ * 			ERROR(1) - The escape sequence is in progress or AT+CIPCLOSE failed.
+ */
+uint8_t SIM800_Stream_Close(SIM800_t *pSIM)
+{
+	uint8_t statusClose = ERROR;
+
+	if(pSIM->stream.state == SIM_STREAM_COMMAND)
+		statusClose = close_TCPUDP_Connection(pSIM);
+	else if((pSIM->stream.state == SIM_STREAM_DATA) || (pSIM->stream.state == SIM_STREAM_CLOSED))
+		statusClose = OK;
+
+	if(statusClose == OK)
+	{
+		at_Engine_Set_Data_Mode(&pSIM->engine, false);
+		pSIM->stream.state = SIM_STREAM_CLOSED;
+	}
+
+	return statusClose;
+}
+
+/**
+ * @brief	Gets the state of the transparent connection.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	State of the transparent connection.
  */
-void SIM800_Off(void)
+streamStateSIM_t SIM800_Get_Stream_State(SIM800_t *pSIM)
 {
-	power_Down_SIM();
-	keep_Reset_SIM();
+	return pSIM->stream.state;
 }
 
 /**
- * @brief	Restart SIM.
- * @param	None.
- * @retval	None.
+ * @brief	Enables the multi-connection mode and activates the PDP context, so up to N_SOCKETS_SIM connections
+ * 			can be open at the same time.
+ * @note	AT commands used: AT+CIPSHUT, AT+CIPMUX=1, AT+CSTT, AT+CIICR and AT+CIFSR
+ * 			The handlers of the URCs "<n>, CLOSED" and URC_RECEIVE are registered the first time. The data
+ * 			received by each connection is stored in the buffer given to SIM800_Socket_Open() and read with
+ * 			SIM800_Socket_Read(), the buffers of the previous connections are released.
+ * 			In multi-connection mode the functions of the single connection, the transparent mode and the
+ * 			connection manager must not be used. The quick send mode is disabled, see set_Quick_Send_TCPUDP().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to buffer of type uint8_t containing the APN of the mobile operator.
+ * @retval	Integer Value:
+ * 			OK(0) - Multi-connection mode enabled and PDP context active.
+ * 			ERROR(1) - No free URC handler or one of the commands failed.
+ */
+uint8_t SIM800_Socket_Init(SIM800_t *pSIM, uint8_t *apn)
+{
+	uint8_t statusInit = ERROR;
+	atCommand_t command;
+	uint8_t i;
+
+	if(pSIM->socketHandlers == false)
+	{
+		pSIM->socketHandlers = (at_Engine_Register_URC(&pSIM->engine, (const uint8_t *)URC_RECEIVE, received_Socket_SIM, pSIM) == true);
+
+		for(i = 0; (i < N_SOCKETS_SIM) && (pSIM->socketHandlers == true); i++)
+			pSIM->socketHandlers = (at_Engine_Register_URC(&pSIM->engine, (const uint8_t *)closedSocketsSIM[i], closed_Socket_SIM, &pSIM->sockets[i]) == true);
+	}
+
+	for(i = 0; i < N_SOCKETS_SIM; i++)
+	{
+		pSIM->sockets[i].state = SIM_SOCKET_CLOSED;
+		pSIM->sockets[i].dropped = 0;
+		memset(&pSIM->sockets[i].rxBuffer, 0, sizeof(pSIM->sockets[i].rxBuffer));
+	}
+
+	pSIM->multiConnection = false;
+
+	if((pSIM->socketHandlers == true) && (disable_GPRS_PDP_Context(pSIM) == OK)
+			&& ((pSIM->quickSend.enabled == false) || (set_Quick_Send_TCPUDP(pSIM, false, QUICK_SEND_WINDOW) == OK)))
+	{
+		build_AT_CMD(&command, SIM_CMD_CIPMUX, (const uint8_t *)MULTI_CONNECTION);
+
+		if((execute_AT_CMD(pSIM, &command) == AT_RESULT_OK) && (setAPN(pSIM, apn) == OK)
+				&& (bring_Up_Wireless_Connection(pSIM) == OK))
+		{
+			build_AT_CMD(&command, SIM_CMD_CIFSR, NULL);
+
+			if(execute_AT_CMD(pSIM, &command) == AT_RESULT_IP_ADDRESS)
+			{
+				pSIM->multiConnection = true;
+				statusInit = OK;
+			}
+		}
+	}
+
+	return statusInit;
+}
+
+/**
+ * @brief	Opens a connection of the multi-connection mode and waits until it is open.
+ * @note	See SIM800_Socket_Open_Async().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @param	Pointer of type uint8_t containing the connection type: TCP  or UDP.
+ * @param	Pointer to buffer of type uint8_t containing the remote server IP address
+ * @param	Pointer of type uint8_t containing the remote server port
+ * @param	Pointer to the buffer where the data received by the connection is stored, see SOCKET_BUFFER_SIZE.
+ * @param	Size of the buffer, a power of two.
+ * @retval	Integer Value:
+ * 			OK(0) - Connection open.
+ * 			ERROR(1) - Error connecting.
+ */
+uint8_t SIM800_Socket_Open(SIM800_t *pSIM, uint8_t socket, uint8_t *connection, uint8_t *ip_address, uint8_t *port, uint8_t *rxStorage, uint16_t rxSize)
+{
+	uint8_t statusOpen = ERROR;
+	commandStatus_t status = {false, AT_RESULT_NONE};
+
+	at_Engine_Release_Response(&pSIM->engine);
+
+	if(SIM800_Socket_Open_Async(pSIM, socket, connection, ip_address, port, rxStorage, rxSize, store_Result_SIM, &status) == OK)
+	{
+		wait_Command_SIM(pSIM, &status);
+
+		if(pSIM->sockets[socket].state == SIM_SOCKET_CONNECTED)
+			statusOpen = OK;
+	}
+
+	return statusOpen;
+}
+
+/**
+ * @brief	Opens a connection of the multi-connection mode, without waiting.
+ * @note	AT command used: AT+CIPSTART=<n>,<type>,<address>,<port>
+ * 			The SIM answers OK and then "<n>, CONNECT OK", "<n>, ALREADY CONNECT" or "<n>, CONNECT FAIL", which
+ * 			complete the command as the results of the single connection. The callback is called from
+ * 			SIM800_Poll() with AT_RESULT_CONNECT_OK, AT_RESULT_ALREADY_CONNECT or an error.
+ * 			The data received is stored in rxStorage, which must remain valid until the connection is opened
+ * 			again or SIM800_Socket_Init() is called. The data not read is discarded when it is opened.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @param	Pointer of type uint8_t containing the connection type: TCP  or UDP.
+ * @param	Pointer to buffer of type uint8_t containing the remote server IP address
+ * @param	Pointer of type uint8_t containing the remote server port
+ * @param	Pointer to the buffer where the data received by the connection is stored, see SOCKET_BUFFER_SIZE.
+ * @param	Size of the buffer, a power of two.
+ * @param	Function called when the connection is completed, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Command queued.
+ * 			ERROR(1) - Multi-connection mode not enabled, connection not closed, invalid buffer or queue full.
+ */
+uint8_t SIM800_Socket_Open_Async(SIM800_t *pSIM, uint8_t socket, uint8_t *connection, uint8_t *ip_address, uint8_t *port, uint8_t *rxStorage, uint16_t rxSize, atCallback_t callback, void *pContext)
+{
+	uint8_t statusOpen = ERROR;
+	uint8_t stringAux[LEN_FORMAT_CONNECTION];
+	socketSIM_t *pSocket;
+	atCommand_t command;
+
+	if((pSIM->multiConnection == true) && (socket < N_SOCKETS_SIM) && (pSIM->sockets[socket].state == SIM_SOCKET_CLOSED)
+			&& (ring_Buffer_Init(&pSIM->sockets[socket].rxBuffer, rxStorage, rxSize) == true))
+	{
+		pSocket = &pSIM->sockets[socket];
+
+		snprintf((char *)stringAux, sizeof(stringAux), "%u,\"%s\",\"%s\",\"%s\"", (unsigned int)socket, connection, ip_address, port);
+		build_AT_CMD(&command, SIM_CMD_CIPSTART, stringAux);
+		command.callback = connected_Socket_SIM;
+		command.pContext = pSocket;
+
+		if((wake_Up_SIM(pSIM, 1U) == true) && (at_Engine_Send(&pSIM->engine, &command) == true))
+		{
+			pSocket->state = SIM_SOCKET_CONNECTING;
+			pSocket->callback = callback;
+			pSocket->pContext = pContext;
+			statusOpen = OK;
+		}
+	}
+
+	return statusOpen;
+}
+
+/**
+ * @brief	Sends data through a connection of the multi-connection mode.
+ * @note	AT command used: AT+CIPSEND=<n>,<length>
+ * 			The send is completed by "<n>, SEND OK". The connection is only marked as closed when the SIM
+ * 			answers SEND FAIL or reports "<n>, CLOSED"; after a timeout or an ERROR its state is kept, the
+ * 			application can close it with SIM800_Socket_Close().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @param	Pointer to the data, it can contain any byte.
+ * @param	Number of bytes, up to MAX_LENGTH_SEND_DATA.
+ * @retval	Integer Value:
+ * 			OK(0) - Data sent, the SIM answered SEND OK.
+ * 			ERROR(1) - Connection not open or error sending data.
+ */
+uint8_t SIM800_Socket_Send(SIM800_t *pSIM, uint8_t socket, const uint8_t *data, uint16_t length)
+{
+	uint8_t statusSend = ERROR;
+	uint8_t parameters[LEN_AT_CMD_CONFIG];
+	atCommand_t command;
+	atResult_t result;
+
+	if((socket < N_SOCKETS_SIM) && (pSIM->sockets[socket].state == SIM_SOCKET_CONNECTED)
+			&& (length > 0) && (length <= MAX_LENGTH_SEND_DATA))
+	{
+		snprintf((char *)parameters, sizeof(parameters), "%u,%u", (unsigned int)socket, (unsigned int)length);
+		build_AT_CMD(&command, SIM_CMD_CIPSEND, parameters);
+		command.pPayload = data;
+		command.payloadLength = length;
+
+		result = execute_AT_CMD(pSIM, &command);
+
+		if(result == AT_RESULT_SEND_OK)
+			statusSend = OK;
+		else if(result == AT_RESULT_SEND_FAIL)
+			pSIM->sockets[socket].state = SIM_SOCKET_CLOSED;
+	}
+
+	return statusSend;
+}
+
+/**
+ * @brief	Reads the data received by a connection of the multi-connection mode, without waiting.
+ * @note	The data received after the server closed the connection can still be read, until it is opened again.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @param	Pointer to the buffer where the data is copied.
+ * @param	Size of the buffer.
+ * @retval	Number of bytes read, 0 if there is no data.
+ */
+uint16_t SIM800_Socket_Read(SIM800_t *pSIM, uint8_t socket, uint8_t *data, uint16_t size)
+{
+	uint16_t length = 0;
+
+	if((pSIM->multiConnection == true) && (socket < N_SOCKETS_SIM))
+		length = ring_Buffer_Read(&pSIM->sockets[socket].rxBuffer, data, size);
+
+	return length;
+}
+
+/**
+ * @brief	Gets the number of bytes received by a connection of the multi-connection mode and not yet read.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @retval	Number of bytes.
+ */
+uint16_t SIM800_Socket_Available(SIM800_t *pSIM, uint8_t socket)
+{
+	uint16_t length = 0;
+
+	if((pSIM->multiConnection == true) && (socket < N_SOCKETS_SIM))
+		length = ring_Buffer_Count(&pSIM->sockets[socket].rxBuffer);
+
+	return length;
+}
+
+/**
+ * @brief	Gets the number of bytes received by a connection of the multi-connection mode and discarded because
+ * 			its buffer was full, and clears it.
+ * @note	The data of the connection is lost, the application must read it more often or give it a larger buffer.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @retval	Number of bytes discarded since the last call.
+ */
+uint32_t SIM800_Socket_Get_Dropped(SIM800_t *pSIM, uint8_t socket)
+{
+	uint32_t dropped = 0;
+
+	if(socket < N_SOCKETS_SIM)
+	{
+		dropped = pSIM->sockets[socket].dropped;
+		pSIM->sockets[socket].dropped = 0;
+	}
+
+	return dropped;
+}
+
+/**
+ * @brief	Closes a connection of the multi-connection mode, the other connections remain open.
+ * @note	AT command used: AT+CIPCLOSE=<n>
+ * 			The SIM answers "<n>, CLOSE OK". A connection already closed by the server is not closed again.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @retval	Integer Value:
+ * 			OK(0) - Connection closed.
+ * 			ERROR(1) - Invalid connection, connection being opened or close fail.
+ */
+uint8_t SIM800_Socket_Close(SIM800_t *pSIM, uint8_t socket)
+{
+	uint8_t statusClose = ERROR;
+	uint8_t parameters[LEN_AT_CMD_CONFIG];
+	atCommand_t command;
+
+	if((socket < N_SOCKETS_SIM) && (pSIM->sockets[socket].state == SIM_SOCKET_CONNECTED))
+	{
+		snprintf((char *)parameters, sizeof(parameters), "%u", (unsigned int)socket);
+		build_AT_CMD(&command, SIM_CMD_CIPCLOSE_MUX, parameters);
+
+		if(execute_AT_CMD(pSIM, &command) == AT_RESULT_CLOSE_OK)
+		{
+			pSIM->sockets[socket].state = SIM_SOCKET_CLOSED;
+			statusClose = OK;
+		}
+	}
+	else if((socket < N_SOCKETS_SIM) && (pSIM->sockets[socket].state == SIM_SOCKET_CLOSED))
+		statusClose = OK;
+
+	return statusClose;
+}
+
+/**
+ * @brief	Gets the state of a connection of the multi-connection mode.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of the connection, from 0 to N_SOCKETS_SIM - 1.
+ * @retval	State of the connection, SIM_SOCKET_CLOSED for an invalid number.
+ */
+socketStateSIM_t SIM800_Get_Socket_State(SIM800_t *pSIM, uint8_t socket)
+{
+	socketStateSIM_t state = SIM_SOCKET_CLOSED;
+
+	if(socket < N_SOCKETS_SIM)
+		state = pSIM->sockets[socket].state;
+
+	return state;
+}
+
+/**
+ * @brief	Configures the connection kept open by the connection manager.
+ * @note	The connection manager keeps the PDP context and the TCP/UDP connection open between sends, so the
+ * 			data is sent with a single AT+CIPSEND instead of opening and closing the connection each time.
+ * 			The handlers of URC_CLOSED and URC_PDP_DEACT are registered the first time, so the connection is
+ * 			marked as closed as soon as the SIM reports it, and it is opened again by the next send.
+ * 			It must be called after SIM800_ConfigHW() or SIM800_Default_ConfigHW(), with the connection closed.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the configuration of the connection, it must remain valid.
+ * @retval	Integer Value:
+ * 			OK(0) - Connection configured.
+ * 			ERROR(1) - No free URC handler or the connection is being opened.
  */
-void SIM800_restart(void)
+uint8_t SIM800_Link_Config(SIM800_t *pSIM, const linkConfigSIM_t *pConfig)
 {
-	restart_SIM();
+	uint8_t statusConfig = ERROR;
+
+	if((pConfig != NULL) && (pSIM->link.state != SIM_LINK_CONNECTING))
+	{
+		if(pSIM->link.pConfig != NULL)
+			statusConfig = OK;
+		else if((at_Engine_Register_URC(&pSIM->engine, (const uint8_t *)URC_CLOSED, closed_Link_SIM, pSIM) == true)
+				&& (at_Engine_Register_URC(&pSIM->engine, (const uint8_t *)URC_PDP_DEACT, deactivated_Link_SIM, pSIM) == true))
+			statusConfig = OK;
+
+		if(statusConfig == OK)
+		{
+			pSIM->link.pConfig = pConfig;
+			pSIM->link.state = SIM_LINK_DOWN;
+			pSIM->link.bearerUp = false;
+		}
+	}
+
+	return statusConfig;
+}
+
+/**
+ * @brief	Opens the connection configured with SIM800_Link_Config() and waits until it is open.
+ * @note	See SIM800_Link_Connect_Async().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Integer Value:
+ * 			OK(0) - Connection open.
+ * 			ERROR(1) - Connection not configured or failed.
+ */
+uint8_t SIM800_Link_Connect(SIM800_t *pSIM)
+{
+	powerStatus_t status = {false, ERROR};
+
+	at_Engine_Release_Response(&pSIM->engine);
+
+	if(SIM800_Link_Connect_Async(pSIM, store_Power_SIM, &status) == OK)
+		wait_Power_SIM(pSIM, &status);
+
+	return status.status;
+}
+
+/**
+ * @brief	Starts the opening of the connection configured with SIM800_Link_Config(), without waiting.
+ * @note	AT commands used: AT+CIPSTATUS, AT+CIPSHUT, AT+CIPMODE=0, AT+CSTT, AT+CIICR, AT+CIFSR, AT+CIPTKA
+ * 			and AT+CIPSTART
+ * 			The commands are queued one at a time from SIM800_Poll(). The state reported by AT+CIPSTATUS selects
+ * 			the first step, so only the missing transitions are run: for example in IP GPRSACT the PDP context
+ * 			is kept and the sequence starts at AT+CIFSR, and in IP INITIAL AT+CIPSHUT is skipped. The transient
+ * 			states (IP CONFIG, CONNECTING, CLOSING) and PDP DEACT start again from AT+CIPSHUT. If the PDP context
+ * 			is known to be active, only AT+CIPSTART is sent. The SIM firmwares without AT+CIPTKA answer ERROR,
+ * 			the connection is opened anyway without keepalive. If the connection is already open the callback is called before
+ * 			the function returns.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Function called with OK(0) when the connection is open or ERROR(1) when it fails, it can be NULL.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Opening started.
+ * 			ERROR(1) - Connection not configured or already being opened.
+ */
+uint8_t SIM800_Link_Connect_Async(SIM800_t *pSIM, linkCallback_t callback, void *pContext)
+{
+	uint8_t statusLink = ERROR;
+	linkSIM_t *pLink = &pSIM->link;
+
+	if((pLink->pConfig != NULL) && (pLink->state != SIM_LINK_CONNECTING))
+	{
+		pLink->callback = callback;
+		pLink->pContext = pContext;
+		statusLink = OK;
+
+		if(pLink->state == SIM_LINK_UP)
+		{
+			if(callback != NULL)
+				callback(OK, pContext);
+		}
+		else
+		{
+			pLink->state = SIM_LINK_CONNECTING;
+			pLink->step = (pLink->bearerUp == true) ? SIM_LINK_STEP_START : SIM_LINK_STEP_STATUS;
+			pLink->stepQueued = false;
+			poll_Link_SIM(pSIM);
+		}
+	}
+
+	return statusLink;
+}
+
+/**
+ * @brief	Sends data through the connection kept open by the connection manager.
+ * @note	AT command used: AT+CIPSEND=<length>
+ * 			If the connection is closed, it is opened first and the function waits for it. If the send fails
+ * 			the connection is marked as closed, so the next send opens it again. In quick send mode the send
+ * 			is completed by DATA ACCEPT, see set_Quick_Send_TCPUDP().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the data, it can contain any byte.
+ * @param	Number of bytes, up to MAX_LENGTH_SEND_DATA.
+ * @retval	Integer Value:
+ * 			OK(0) - Data sent, the SIM answered SEND OK or DATA ACCEPT.
+ * 			ERROR(1) - Connection failed or error sending data.
+ */
+uint8_t SIM800_Link_Send(SIM800_t *pSIM, const uint8_t *data, uint16_t length)
+{
+	uint8_t statusSend = ERROR;
+	bool_t reused = (pSIM->link.state == SIM_LINK_UP);
+
+	if((length > 0) && (length <= MAX_LENGTH_SEND_DATA)
+			&& ((reused == true) || (SIM800_Link_Connect(pSIM) == OK)))
+	{
+		if(send_Packet_SIM(pSIM, data, length) == OK)
+		{
+			if(reused == true)
+				pSIM->link.stats.reuses++;
+
+			statusSend = OK;
+		}
+		else if(pSIM->link.state == SIM_LINK_UP)
+		{
+			pSIM->link.state = SIM_LINK_DOWN;
+			pSIM->link.stats.drops++;
+		}
+	}
+
+	return statusSend;
+}
+
+/**
+ * @brief	Closes the connection kept open by the connection manager and deactivates the PDP context.
+ * @note	AT commands used: AT+CIPCLOSE and AT+CIPSHUT
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Integer Value:
+ * 			OK(0) - PDP context deactivated.
+ * 			ERROR(1) - The connection is being opened or AT+CIPSHUT failed.
+ */
+uint8_t SIM800_Link_Close(SIM800_t *pSIM)
+{
+	uint8_t statusClose = ERROR;
+
+	if(pSIM->link.state != SIM_LINK_CONNECTING)
+	{
+		if(pSIM->link.state == SIM_LINK_UP)
+			close_TCPUDP_Connection(pSIM);
+
+		pSIM->link.state = SIM_LINK_DOWN;
+		pSIM->link.bearerUp = false;
+		statusClose = disable_GPRS_PDP_Context(pSIM);
+	}
+
+	return statusClose;
+}
+
+/**
+ * @brief	Gets the state of the connection kept open by the connection manager.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	State of the connection.
+ */
+linkStateSIM_t SIM800_Get_Link_State(SIM800_t *pSIM)
+{
+	return pSIM->link.state;
+}
+
+/**
+ * @brief	Gets the statistics of the connection manager since the hardware configuration.
+ * @note	The ratio between reuses and connections shows how many sends saved the opening of the connection.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer where the statistics are copied.
+ * @retval	None.
+ */
+void SIM800_Get_Link_Stats(SIM800_t *pSIM, linkStatsSIM_t *pStats)
+{
+	*pStats = pSIM->link.stats;
+}
+
+/**
+ * @brief	Turn on SIM.
+ * @note	It waits until the SIM is ready to send SMS, at most DELAY_ENTRY_ACTIVE.
+ * 			See SIM800_On_Ready().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+void SIM800_On(SIM800_t *pSIM)
+{
+	SIM800_On_Ready(pSIM, SIM_READY_SMS, DELAY_ENTRY_ACTIVE);
+}
+
+/**
+ * @brief	Turn on SIM and wait until it reaches a readiness level.
+ * @note	The messages that the SIM sends during its start-up are searched as they arrive, so the function
+ * 			returns as soon as the message of the level is received instead of waiting a fixed time.
+ * 			With autobauding the SIM does not send these messages until it receives the first AT command,
+ * 			so the wait lasts the whole timeout; a baud rate fixed with AT+IPR gives the fastest start-up.
+ * 			The messages must not be registered as URCs with SIM800_Register_URC(), or they are not searched.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Readiness level to wait for.
+ * @param	Maximum time in milliseconds since the power on.
+ * @retval	Integer Value:
+ * 			OK(0) - The SIM reached the readiness level.
+ * 			ERROR(1) - The timeout expired, SIM800_Get_Ready_Level() returns the level reached.
+ */
+uint8_t SIM800_On_Ready(SIM800_t *pSIM, readySIM_t level, uint32_t timeout)
+{
+	powerStatus_t status = {false, ERROR};
+
+	if(SIM800_On_Async(pSIM, level, timeout, store_Power_SIM, &status) == OK)
+		wait_Power_SIM(pSIM, &status);
+
+	return status.status;
+}
+
+/**
+ * @brief	Starts the power on of the SIM, without waiting.
+ * @note	The sequence advances in SIM800_Poll(): the powerKey is held DELAY_POWER_ON, then the start-up
+ * 			messages of the SIM are searched until the readiness level is reached or the timeout expires.
+ * 			See SIM800_On_Ready(). No command must be queued until the callback is called.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Readiness level to wait for.
+ * @param	Maximum time in milliseconds since the power on.
+ * @param	Function called with OK(0) when the SIM reaches the readiness level, or ERROR(1) when the timeout expires.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Sequence started.
+ * 			ERROR(1) - A power sequence or a command is in progress.
+ */
+uint8_t SIM800_On_Async(SIM800_t *pSIM, readySIM_t level, uint32_t timeout, powerCallback_t callback, void *pContext)
+{
+	uint8_t statusPower = ERROR;
+
+	if((pSIM->power.state == SIM_POWER_IDLE) && (at_Engine_Watch(&pSIM->engine, &matcherSIM) == true))
+	{
+		pSIM->power.tickStart = HAL_GetTick();
+		pSIM->power.level = level;
+		pSIM->power.timeout = timeout;
+		pSIM->power.callback = callback;
+		pSIM->power.pContext = pContext;
+		pSIM->readyLevel = SIM_READY_NONE;
+
+		/* Only the messages of this start-up are searched */
+		at_Engine_Flush(&pSIM->engine);
+		exit_Reset_SIM(&pSIM->port);
+		set_Power_Key_SIM(&pSIM->port, true);
+		start_Step_Power_SIM(pSIM, SIM_POWER_KEY_ON, DELAY_POWER_ON);
+		statusPower = OK;
+	}
+
+	return statusPower;
+}
+
+/**
+ * @brief	Gets the readiness level reached by the SIM in the last power on.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Readiness level, SIM_READY_NONE if the SIM sent no start-up message.
+ */
+readySIM_t SIM800_Get_Ready_Level(SIM800_t *pSIM)
+{
+	return pSIM->readyLevel;
+}
+
+/**
+ * @brief	Gets the time that the last power on took.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Time in milliseconds from the power on until the requested readiness level was reached,
+ * 			or until the timeout expired.
+ */
+uint32_t SIM800_Get_Time_To_Ready(SIM800_t *pSIM)
+{
+	return pSIM->timeToReady;
+}
+
+/**
+ * @brief	Gets the baud rate at which the SIM answered in the last initialization.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Baud rate, 0 if the SIM has not been synchronized.
+ */
+uint32_t SIM800_Get_Sync_Baud_Rate(SIM800_t *pSIM)
+{
+	return pSIM->syncBaudRate;
+}
+
+/**
+ * @brief	Gets the time that the synchronization of the last initialization took, including the scan.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Time in milliseconds.
+ */
+uint32_t SIM800_Get_Sync_Time(SIM800_t *pSIM)
+{
+	return pSIM->syncTime;
+}
+
+/**
+ * @brief	Turn off SIM.
+ * @note	It waits until the sequence of SIM800_Off_Async() is completed.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+void SIM800_Off(SIM800_t *pSIM)
+{
+	powerStatus_t status = {false, ERROR};
+
+	if(SIM800_Off_Async(pSIM, store_Power_SIM, &status) == OK)
+		wait_Power_SIM(pSIM, &status);
+}
+
+/**
+ * @brief	Starts the power down of the SIM, without waiting.
+ * @note	The sequence advances in SIM800_Poll(): the powerKey is held DELAY_POWER_DOWN, then the SIM is given
+ * 			DELAY_ENTRY_IDLE to shut down and is kept in reset.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Function called with OK(0) when the SIM is off.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Sequence started.
+ * 			ERROR(1) - A power sequence is in progress.
+ */
+uint8_t SIM800_Off_Async(SIM800_t *pSIM, powerCallback_t callback, void *pContext)
+{
+	uint8_t statusPower = ERROR;
+
+	if(pSIM->power.state == SIM_POWER_IDLE)
+	{
+		pSIM->power.tickStart = HAL_GetTick();
+		pSIM->power.level = SIM_READY_NONE;
+		pSIM->power.callback = callback;
+		pSIM->power.pContext = pContext;
+
+		set_Power_Key_SIM(&pSIM->port, true);
+		start_Step_Power_SIM(pSIM, SIM_POWER_KEY_DOWN, DELAY_POWER_DOWN);
+		statusPower = OK;
+	}
+
+	return statusPower;
+}
+
+/**
+ * @brief	Restart SIM.
+ * @note	It waits until the reset pulse is completed, not until the SIM is ready.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+void SIM800_restart(SIM800_t *pSIM)
+{
+	powerStatus_t status = {false, ERROR};
+
+	if(SIM800_Restart_Async(pSIM, SIM_READY_NONE, 0, store_Power_SIM, &status) == OK)
+		wait_Power_SIM(pSIM, &status);
+}
+
+/**
+ * @brief	Starts the restart of the SIM, without waiting.
+ * @note	The sequence advances in SIM800_Poll(): the reset pin is held DELAY_RESET, then, if the level is
+ * 			not SIM_READY_NONE, the start-up messages are searched as in SIM800_On_Async().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Readiness level to wait for, SIM_READY_NONE to complete after the reset pulse.
+ * @param	Maximum time in milliseconds since the reset.
+ * @param	Function called with OK(0) when the SIM is restarted, or ERROR(1) when the timeout expires.
+ * @param	Pointer passed to the callback.
+ * @retval	Integer Value:
+ * 			OK(0) - Sequence started.
+ * 			ERROR(1) - A power sequence or a command is in progress.
+ */
+uint8_t SIM800_Restart_Async(SIM800_t *pSIM, readySIM_t level, uint32_t timeout, powerCallback_t callback, void *pContext)
+{
+	uint8_t statusPower = ERROR;
+
+	if((pSIM->power.state == SIM_POWER_IDLE)
+			&& ((level == SIM_READY_NONE) || (at_Engine_Watch(&pSIM->engine, &matcherSIM) == true)))
+	{
+		pSIM->power.tickStart = HAL_GetTick();
+		pSIM->power.level = level;
+		pSIM->power.timeout = timeout;
+		pSIM->power.callback = callback;
+		pSIM->power.pContext = pContext;
+		pSIM->readyLevel = SIM_READY_NONE;
+
+		at_Engine_Flush(&pSIM->engine);
+		keep_Reset_SIM(&pSIM->port);
+		start_Step_Power_SIM(pSIM, SIM_POWER_RESET, DELAY_RESET);
+		statusPower = OK;
+	}
+
+	return statusPower;
+}
+
+/**
+ * @brief	Checks if a power sequence is in progress.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Returns true if a power sequence is in progress, otherwise false.
+ */
+bool_t SIM800_Is_Power_Busy(SIM800_t *pSIM)
+{
+	return (pSIM->power.state != SIM_POWER_IDLE);
+}
+
+/**
+ * @brief	Configures the pins used by the sleep mode: DTR controls the sleep mode 1 and RI wakes the MCU up.
+ * @note	The RI pin is an external interrupt, see initRIPin(). It must be called after the hardware configuration.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	GPIO Port for DTR
+ * @param	GPIO Pin for DTR
+ * @param	GPIO Port for RI
+ * @param	GPIO Pin for RI
+ * @retval	None.
+ */
+void SIM800_Config_Sleep_Pins(SIM800_t *pSIM, Port_t dtrPort, uint16_t dtrPin, Port_t riPort, uint16_t riPin)
+{
+	initDTRPin(&pSIM->port, dtrPort, dtrPin);
+	initRIPin(&pSIM->port, riPort, riPin);
+}
+
+/**
+ * @brief	Sets the sleep mode of the SIM.
+ * @note	AT command used: AT+CSCLK=<mode>
+ * 			Once the sleep mode is set, the driver wakes the SIM up before each command: in SIM_SLEEP_DTR it sets
+ * 			the DTR pin low and delays the command DELAY_WAKE_UP, in SIM_SLEEP_AUTO it sends "AT" first because
+ * 			the characters that wake the SIM up are lost.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Sleep mode. SIM_SLEEP_DTR requires the DTR pin, see SIM800_Config_Sleep_Pins().
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+uint8_t SIM800_Set_Sleep_Mode(SIM800_t *pSIM, sleepModeSIM_t mode)
+{
+	uint8_t statusSleep = ERROR;
+	uint8_t value[LEN_AT_CMD_CONFIG];
+	atCommand_t command;
+
+	if((mode != SIM_SLEEP_DTR) || (has_DTR_SIM(&pSIM->port) == true))
+	{
+		snprintf((char *)value, sizeof(value), "%u", (unsigned int)mode);
+		build_AT_CMD(&command, SIM_CMD_CSCLK, value);
+
+		if(execute_AT_CMD(pSIM, &command) == AT_RESULT_OK)
+		{
+			pSIM->sleepMode = mode;
+			statusSleep = OK;
+		}
+	}
+
+	return statusSleep;
+}
+
+/**
+ * @brief	Lets the SIM enter the sleep mode until the next command.
+ * @note	In SIM_SLEEP_DTR the DTR pin is set high, in SIM_SLEEP_AUTO the SIM sleeps by itself when the UART
+ * 			has no activity for TIME_AUTO_SLEEP. The SIM still receives SMS, calls and data while it sleeps
+ * 			and reports them with the RI pin, see SIM800_Is_Ring_Indicated().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Integer Value:
+ * 			OK(0) - The SIM can sleep.
+ * 			ERROR(1) - The sleep mode is disabled or there are commands in progress.
+ */
+uint8_t SIM800_Sleep(SIM800_t *pSIM)
+{
+	uint8_t statusSleep = ERROR;
+
+	if((pSIM->sleepMode != SIM_SLEEP_DISABLED) && (at_Engine_Is_Busy(&pSIM->engine) == false))
+	{
+		if(pSIM->sleepMode == SIM_SLEEP_DTR)
+			set_DTR_SIM(&pSIM->port, true);
+
+		pSIM->asleep = true;
+		statusSleep = OK;
+	}
+
+	return statusSleep;
+}
+
+/**
+ * @brief	Checks if the SIM pulled the RI pin low since the last call, because it received an SMS, a call or data.
+ * @note	The RI interrupt also wakes the MCU up from a low-power mode entered with __WFI().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	Returns true if the RI pin was pulled low, otherwise false.
+ */
+bool_t SIM800_Is_Ring_Indicated(SIM800_t *pSIM)
+{
+	return get_Ring_Indication_SIM(&pSIM->port);
+}
+
+/**
+ * @brief	Advances the power sequence in progress, called from SIM800_Poll().
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void poll_Power_SIM(SIM800_t *pSIM)
+{
+	powerSIM_t *pPower = &pSIM->power;
+	uint32_t now = HAL_GetTick();
+	bool_t elapsed = ((now - pPower->startTime) >= pPower->duration);
+
+	switch(pPower->state)
+	{
+		case SIM_POWER_KEY_ON:
+			if(elapsed == true)
+			{
+				set_Power_Key_SIM(&pSIM->port, false);
+				start_Step_Power_SIM(pSIM, SIM_POWER_WAIT_READY, 0);
+			}
+			break;
+
+		case SIM_POWER_WAIT_READY:
+			pSIM->readyLevel = get_Ready_Level_SIM(at_Engine_Get_Hits(&pSIM->engine));
+
+			if(pSIM->readyLevel >= pPower->level)
+				finish_Power_SIM(pSIM, OK);
+			else if((now - pPower->tickStart) >= pPower->timeout)
+				finish_Power_SIM(pSIM, ERROR);
+			break;
+
+		case SIM_POWER_KEY_DOWN:
+			if(elapsed == true)
+			{
+				set_Power_Key_SIM(&pSIM->port, false);
+				start_Step_Power_SIM(pSIM, SIM_POWER_WAIT_IDLE, DELAY_ENTRY_IDLE);
+			}
+			break;
+
+		case SIM_POWER_WAIT_IDLE:
+			if(elapsed == true)
+			{
+				keep_Reset_SIM(&pSIM->port);
+				finish_Power_SIM(pSIM, OK);
+			}
+			break;
+
+		case SIM_POWER_RESET:
+			if(elapsed == true)
+			{
+				exit_Reset_SIM(&pSIM->port);
+
+				if(pPower->level == SIM_READY_NONE)
+					finish_Power_SIM(pSIM, OK);
+				else
+					start_Step_Power_SIM(pSIM, SIM_POWER_WAIT_READY, 0);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief	Starts a step of the power sequence.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Step.
+ * @param	Duration of the step in milliseconds.
+ * @retval	None.
+ */
+static void start_Step_Power_SIM(SIM800_t *pSIM, powerStateSIM_t state, uint32_t duration)
+{
+	pSIM->power.state = state;
+	pSIM->power.startTime = HAL_GetTick();
+	pSIM->power.duration = duration;
+}
+
+/**
+ * @brief	Ends the power sequence and calls its callback.
+ * @note	The time to ready is measured since the beginning of the sequence.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	OK(0) or ERROR(1).
+ * @retval	None.
+ */
+static void finish_Power_SIM(SIM800_t *pSIM, uint8_t status)
+{
+	if(pSIM->power.level != SIM_READY_NONE)
+	{
+		pSIM->timeToReady = HAL_GetTick() - pSIM->power.tickStart;
+		at_Engine_Watch(&pSIM->engine, NULL);
+	}
+
+	pSIM->power.state = SIM_POWER_IDLE;
+
+	if(pSIM->power.callback != NULL)
+		pSIM->power.callback(status, pSIM->power.pContext);
+}
+
+/**
+ * @brief	Waits until a power sequence started by a blocking function is completed.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the completion of the sequence.
+ * @retval	None.
+ */
+static void wait_Power_SIM(SIM800_t *pSIM, powerStatus_t *pStatus)
+{
+	while(pStatus->done == false)
+		SIM800_Poll(pSIM);
+}
+
+/**
+ * @brief	Stores the result of a power sequence started by a blocking function.
+ * @param	OK(0) or ERROR(1).
+ * @param	Pointer to the completion of the sequence.
+ * @retval	None.
+ */
+static void store_Power_SIM(uint8_t status, void *pContext)
+{
+	powerStatus_t *pStatus = (powerStatus_t *)pContext;
+
+	pStatus->status = status;
+	pStatus->done = true;
+}
+
+/**
+ * @brief	Wakes the SIM up before commands are queued, according to the sleep mode.
+ * @note	In SIM_SLEEP_AUTO the SIM may be sleeping if the UART had no activity for TIME_AUTO_SLEEP, the time is
+ * 			measured since the last command was queued, so a long command can cause an unnecessary "AT".
+ * 			The "AT" that wakes the SIM up takes a place in the queue, so the free places are checked for it
+ * 			and for the commands of the caller before it is queued. If they do not fit, the SIM is not woken up.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of commands that the caller queues after this call.
+ * @retval	Returns true if the SIM was woken up and the commands of the caller fit in the queue, otherwise false.
+ */
+static bool_t wake_Up_SIM(SIM800_t *pSIM, uint8_t nCommands)
+{
+	atCommand_t command;
+	uint32_t now = HAL_GetTick();
+	bool_t wakeCommand = (pSIM->sleepMode == SIM_SLEEP_AUTO)
+			&& ((pSIM->asleep == true) || ((now - pSIM->lastActivity) >= TIME_AUTO_SLEEP));
+	bool_t statusWake = false;
+
+	if(at_Engine_Free_Slots(&pSIM->engine) >= (nCommands + ((wakeCommand == true) ? 1U : 0U)))
+	{
+		if((pSIM->sleepMode == SIM_SLEEP_DTR) && (pSIM->asleep == true))
+		{
+			set_DTR_SIM(&pSIM->port, false);
+			at_Engine_Hold_Off(&pSIM->engine, DELAY_WAKE_UP);
+		}
+		else if(wakeCommand == true)
+		{
+			/* The result is not checked, the "AT" only wakes the SIM up */
+			build_AT_CMD(&command, SIM_CMD_AT, NULL);
+			command.timeout = TIMEOUT_SYNC;
+			at_Engine_Send(&pSIM->engine, &command);
+		}
+
+		pSIM->asleep = false;
+		pSIM->lastActivity = now;
+		statusWake = true;
+	}
+
+	return statusWake;
+}
+
+/**
+ * @brief	Queues the command of the current step of the opening of the connection, called from SIM800_Poll().
+ * @note	If the queue is full, the command is queued in a later call.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void poll_Link_SIM(SIM800_t *pSIM)
+{
+	linkSIM_t *pLink = &pSIM->link;
+	uint8_t parameters[LEN_FORMAT_CONNECTION];
+	commandSIM_t commandStep;
+	atCommand_t command;
+
+	if((pLink->state == SIM_LINK_CONNECTING) && (pLink->stepQueued == false))
+	{
+		parameters[0] = '\0';
+
+		switch(pLink->step)
+		{
+			case SIM_LINK_STEP_STATUS:
+				commandStep = SIM_CMD_CIPSTATUS;
+				break;
+
+			case SIM_LINK_STEP_SHUT:
+				commandStep = SIM_CMD_CIPSHUT;
+				break;
+
+			case SIM_LINK_STEP_MODE:
+				commandStep = SIM_CMD_CIPMODE;
+				snprintf((char *)parameters, sizeof(parameters), "%u", (unsigned int)COMMAND_MODE);
+				break;
+
+			case SIM_LINK_STEP_APN:
+				commandStep = SIM_CMD_CSTT;
+				snprintf((char *)parameters, sizeof(parameters), "\"%s\"", pLink->pConfig->pApn);
+				break;
+
+			case SIM_LINK_STEP_BEARER:
+				commandStep = SIM_CMD_CIICR;
+				break;
+
+			case SIM_LINK_STEP_LOCAL_IP:
+				commandStep = SIM_CMD_CIFSR;
+				break;
+
+			case SIM_LINK_STEP_KEEP_ALIVE:
+				commandStep = SIM_CMD_CIPTKA;
+				snprintf((char *)parameters, sizeof(parameters), "1,%u,%u,%u", (unsigned int)pLink->pConfig->keepAliveTime,
+						(unsigned int)KEEP_ALIVE_INTERVAL, (unsigned int)KEEP_ALIVE_PROBES);
+				break;
+
+			default:
+				commandStep = SIM_CMD_CIPSTART;
+				snprintf((char *)parameters, sizeof(parameters), "\"%s\",\"%s\",\"%s\"",
+						pLink->pConfig->pType, pLink->pConfig->pAddress, pLink->pConfig->pPort);
+				break;
+		}
+
+		build_AT_CMD(&command, commandStep, parameters);
+		command.callback = complete_Step_Link_SIM;
+		command.pContext = pSIM;
+
+		if((wake_Up_SIM(pSIM, 1U) == true) && (at_Engine_Send(&pSIM->engine, &command) == true))
+			pLink->stepQueued = true;
+	}
+}
+
+/**
+ * @brief	Completion callback of the commands of the opening of the connection: it moves to the next step.
+ * @param	Final result code.
+ * @param	Pointer to the response, the state of the TCP/IP stack is read from the answer of AT+CIPSTATUS.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void complete_Step_Link_SIM(atResult_t result, const atView_t *pResponse, void *pContext)
+{
+	SIM800_t *pSIM = (SIM800_t *)pContext;
+	linkSIM_t *pLink = &pSIM->link;
+	bool_t success = (result == AT_RESULT_OK);
+	linkStepSIM_t next = (linkStepSIM_t)(pLink->step + 1);
+
+	pLink->stepQueued = false;
+
+	switch(pLink->step)
+	{
+		case SIM_LINK_STEP_STATUS:
+			/* Without answer the whole sequence is run */
+			success = true;
+			next = get_First_Step_Link_SIM(pSIM, (result == AT_RESULT_STATE) ? parse_IP_State_SIM(pResponse) : SIM_IP_UNKNOWN);
+			break;
+
+		case SIM_LINK_STEP_SHUT:
+			success = (result == AT_RESULT_SHUT_OK);
+			break;
+
+		case SIM_LINK_STEP_BEARER:
+			if(success == true)
+			{
+				pLink->bearerUp = true;
+				pLink->stats.activations++;
+			}
+			break;
+
+		case SIM_LINK_STEP_LOCAL_IP:
+			success = (result == AT_RESULT_IP_ADDRESS);
+			if(pLink->pConfig->keepAliveTime == 0)
+				next = SIM_LINK_STEP_START;
+			break;
+
+		case SIM_LINK_STEP_KEEP_ALIVE:
+			/* The connection works without keepalive */
+			success = true;
+			break;
+
+		case SIM_LINK_STEP_START:
+			success = ((result == AT_RESULT_CONNECT_OK) || (result == AT_RESULT_ALREADY_CONNECT));
+			break;
+
+		default:
+			break;
+	}
+
+	if(success == false)
+		finish_Link_SIM(pSIM, ERROR);
+	else if(pLink->step == SIM_LINK_STEP_START)
+		finish_Link_SIM(pSIM, OK);
+	else
+		pLink->step = next;
+}
+
+/**
+ * @brief	Ends the opening of the connection and calls its callback.
+ * @note	If it failed, the PDP context is activated again in the next opening.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	OK(0) or ERROR(1).
+ * @retval	None.
+ */
+static void finish_Link_SIM(SIM800_t *pSIM, uint8_t status)
+{
+	linkSIM_t *pLink = &pSIM->link;
+
+	if(status == OK)
+	{
+		pLink->state = SIM_LINK_UP;
+		pLink->stats.connections++;
+	}
+	else
+	{
+		pLink->state = SIM_LINK_DOWN;
+		pLink->bearerUp = false;
+		pLink->stats.failures++;
+	}
+
+	if(pLink->callback != NULL)
+		pLink->callback(status, pLink->pContext);
+}
+
+/**
+ * @brief	Selects the first step of the opening of the connection from the state of the TCP/IP stack.
+ * @note	In the states where the PDP context is active, bearerUp is set, so a later opening skips AT+CIPSTATUS.
+ * 			The SIM answers ALREADY CONNECT to AT+CIPSTART if the connection is still open.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	State of the TCP/IP stack.
+ * @retval	First step.
+ */
+static linkStepSIM_t get_First_Step_Link_SIM(SIM800_t *pSIM, ipStateSIM_t state)
+{
+	linkStepSIM_t step = SIM_LINK_STEP_SHUT;
+	linkStepSIM_t connectStep = (pSIM->link.pConfig->keepAliveTime != 0) ? SIM_LINK_STEP_KEEP_ALIVE : SIM_LINK_STEP_START;
+
+	switch(state)
+	{
+		case SIM_IP_INITIAL:
+			step = SIM_LINK_STEP_MODE;
+			break;
+
+		case SIM_IP_START:
+			step = SIM_LINK_STEP_BEARER;
+			break;
+
+		case SIM_IP_GPRSACT:
+			step = SIM_LINK_STEP_LOCAL_IP;
+			pSIM->link.bearerUp = true;
+			break;
+
+		case SIM_IP_STATUS:
+		case SIM_IP_CLOSED:
+			step = connectStep;
+			pSIM->link.bearerUp = true;
+			break;
+
+		case SIM_IP_CONNECTED:
+			step = SIM_LINK_STEP_START;
+			pSIM->link.bearerUp = true;
+			break;
+
+		default:
+			break;
+	}
+
+	return step;
+}
+
+/**
+ * @brief	Gets the state of the TCP/IP stack from the answer of AT+CIPSTATUS.
+ * @param	Pointer to the response, it contains the line "STATE: <state>".
+ * @retval	State of the TCP/IP stack, SIM_IP_UNKNOWN if the text is not recognized.
+ */
+static ipStateSIM_t parse_IP_State_SIM(const atView_t *pResponse)
+{
+	ipStateSIM_t state = SIM_IP_UNKNOWN;
+	uint8_t i;
+
+	for(i = SIM_IP_INITIAL; (i < N_IP_STATES) && (state == SIM_IP_UNKNOWN); i++)
+	{
+		if(at_View_Contains(pResponse, ipStatesSIM[i]) == true)
+			state = (ipStateSIM_t)i;
+	}
+
+	return state;
+}
+
+/**
+ * @brief	Handler of URC_CLOSED: the server or the keepalive closed the connection.
+ * @param	Pointer to the line, not used.
+ * @param	Length of the line, not used.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void closed_Link_SIM(const uint8_t *pLine, uint8_t length, void *pContext)
+{
+	SIM800_t *pSIM = (SIM800_t *)pContext;
+
+	if(pSIM->link.state == SIM_LINK_UP)
+	{
+		pSIM->link.state = SIM_LINK_DOWN;
+		pSIM->link.stats.drops++;
+	}
+}
+
+/**
+ * @brief	Handler of URC_PDP_DEACT: the network deactivated the PDP context, so the connection is also closed.
+ * @param	Pointer to the line.
+ * @param	Length of the line.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void deactivated_Link_SIM(const uint8_t *pLine, uint8_t length, void *pContext)
+{
+	SIM800_t *pSIM = (SIM800_t *)pContext;
+
+	pSIM->link.bearerUp = false;
+	closed_Link_SIM(pLine, length, pContext);
+}
+
+/**
+ * @brief	Sends the escape sequence of the transparent connection once the guard time has elapsed, called from
+ * 			SIM800_Poll().
+ * @note	The guard time before the sequence restarts while the UART is still transmitting the last data.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void poll_Stream_SIM(SIM800_t *pSIM)
+{
+	streamSIM_t *pStream = &pSIM->stream;
+	uint32_t now = HAL_GetTick();
+	bool_t elapsed = ((now - pStream->lastWrite) >= GUARD_TIME_ESCAPE);
+
+	if((pStream->state == SIM_STREAM_GUARD_BEFORE) || (pStream->state == SIM_STREAM_GUARD_AFTER))
+	{
+		if(is_TX_Busy_UART(&pSIM->port) == true)
+			pStream->lastWrite = now;
+		else if((elapsed == true) && (pStream->state == SIM_STREAM_GUARD_AFTER))
+		{
+			at_Engine_Set_Data_Mode(&pSIM->engine, false);
+			finish_Stream_SIM(pSIM, SIM_STREAM_COMMAND, AT_RESULT_OK);
+		}
+		else if(elapsed == true)
+		{
+			if(write_Data_UART_len(&pSIM->port, (const uint8_t *)ESCAPE_SEQUENCE, strlen(ESCAPE_SEQUENCE)) == SUCCESSFUL)
+			{
+				pStream->lastWrite = now;
+				pStream->state = SIM_STREAM_GUARD_AFTER;
+			}
+			else
+				finish_Stream_SIM(pSIM, SIM_STREAM_DATA, AT_RESULT_ERROR);
+		}
+	}
+}
+
+/**
+ * @brief	Completion callback of AT+CIPSTART and ATO of the transparent connection: with CONNECT the SIM
+ * 			is in data mode, so the engine stops reading the UART.
+ * @param	Final result code.
+ * @param	Pointer to the response, passed to the callback of the application.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void connected_Stream_SIM(atResult_t result, const atView_t *pResponse, void *pContext)
+{
+	SIM800_t *pSIM = (SIM800_t *)pContext;
+	streamSIM_t *pStream = &pSIM->stream;
+
+	if(result == AT_RESULT_CONNECT)
+	{
+		at_Engine_Set_Data_Mode(&pSIM->engine, true);
+		pStream->state = SIM_STREAM_DATA;
+		pStream->lastWrite = HAL_GetTick();
+	}
+
+	if(pStream->callback != NULL)
+		pStream->callback(result, pResponse, pStream->pContext);
+}
+
+/**
+ * @brief	Ends the escape sequence and calls its callback with an empty response.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	New state of the transparent connection.
+ * @param	Result passed to the callback.
+ * @retval	None.
+ */
+static void finish_Stream_SIM(SIM800_t *pSIM, streamStateSIM_t state, atResult_t result)
+{
+	atView_t response = {NULL, 0};
+
+	pSIM->stream.state = state;
+
+	if(pSIM->stream.callback != NULL)
+		pSIM->stream.callback(result, &response, pSIM->stream.pContext);
+}
+
+/**
+ * @brief	Sends a packet through the connection in command mode, with AT+CIPSEND=<length>.
+ * @note	In quick send mode it first waits for room in the window, then the send is completed by DATA ACCEPT
+ * 			and the bytes are counted in flight until AT+CIPACK reports them as acknowledged.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Pointer to the data, it can contain any byte.
+ * @param	Number of bytes, up to MAX_LENGTH_SEND_DATA.
+ * @retval	Integer Value: OK(0) - ERROR(1)
+ */
+static uint8_t send_Packet_SIM(SIM800_t *pSIM, const uint8_t *data, uint16_t length)
+{
+	uint8_t statusSend = ERROR;
+	uint8_t lengthText[LEN_AT_CMD_CONFIG];
+	atCommand_t command;
+
+	snprintf((char *)lengthText, sizeof(lengthText), "%u", (unsigned int)length);
+
+	if(pSIM->quickSend.enabled == false)
+	{
+		build_AT_CMD(&command, SIM_CMD_CIPSEND, lengthText);
+		command.pPayload = data;
+		command.payloadLength = length;
+
+		if(execute_AT_CMD(pSIM, &command) == AT_RESULT_SEND_OK)
+			statusSend = OK;
+	}
+	else if(wait_Window_SIM(pSIM, length) == OK)
+	{
+		build_AT_CMD(&command, SIM_CMD_CIPSEND_QUICK, lengthText);
+		command.pPayload = data;
+		command.payloadLength = length;
+
+		if(execute_AT_CMD(pSIM, &command) == AT_RESULT_DATA_ACCEPT)
+		{
+			pSIM->quickSend.inFlight += length;
+			statusSend = OK;
+		}
+	}
+
+	return statusSend;
+}
+
+/**
+ * @brief	Waits until a packet fits in the window of the quick send mode.
+ * @note	The bytes in flight are refreshed with AT+CIPACK every QUICK_SEND_ACK_TIME, at most QUICK_SEND_TIMEOUT.
+ * 			A packet larger than the window waits until every byte is acknowledged.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @param	Number of bytes of the packet.
+ * @retval	Integer Value:
+ * 			OK(0) - The packet fits in the window.
+ * 			ERROR(1) - AT+CIPACK failed or the server did not acknowledge the data in time.
+ */
+static uint8_t wait_Window_SIM(SIM800_t *pSIM, uint16_t length)
+{
+	uint8_t statusWindow = NO_RESPONSE;
+	quickSendSIM_t *pQuick = &pSIM->quickSend;
+	uint32_t tickStart = HAL_GetTick();
+	uint32_t tickQuery;
+	uint32_t unacked;
+
+	while(statusWindow == NO_RESPONSE)
+	{
+		if((pQuick->inFlight == 0) || ((pQuick->inFlight + length) <= pQuick->window))
+			statusWindow = OK;
+		else if((HAL_GetTick() - tickStart) >= QUICK_SEND_TIMEOUT)
+			statusWindow = ERROR;
+		else if(get_Unacked_Data_TCPUDP(pSIM, &unacked) == ERROR)
+			statusWindow = ERROR;
+		else if((unacked != 0) && ((unacked + length) > pQuick->window))
+		{
+			tickQuery = HAL_GetTick();
+			while((HAL_GetTick() - tickQuery) < QUICK_SEND_ACK_TIME)
+				SIM800_Poll(pSIM);
+		}
+	}
+
+	return statusWindow;
+}
+
+/**
+ * @brief	Completion callback of AT+CIPSTART of a connection of the multi-connection mode.
+ * @param	Final result code.
+ * @param	Pointer to the response, passed to the callback of the application.
+ * @param	Pointer to the socketSIM_t structure of the connection.
+ * @retval	None.
+ */
+static void connected_Socket_SIM(atResult_t result, const atView_t *pResponse, void *pContext)
+{
+	socketSIM_t *pSocket = (socketSIM_t *)pContext;
+
+	if((result == AT_RESULT_CONNECT_OK) || (result == AT_RESULT_ALREADY_CONNECT))
+		pSocket->state = SIM_SOCKET_CONNECTED;
+	else
+		pSocket->state = SIM_SOCKET_CLOSED;
+
+	if(pSocket->callback != NULL)
+		pSocket->callback(result, pResponse, pSocket->pContext);
+}
+
+/**
+ * @brief	Handler of the URC "<n>, CLOSED": the server closed the connection.
+ * @param	Pointer to the line, not used.
+ * @param	Length of the line, not used.
+ * @param	Pointer to the socketSIM_t structure of the connection.
+ * @retval	None.
+ */
+static void closed_Socket_SIM(const uint8_t *pLine, uint8_t length, void *pContext)
+{
+	socketSIM_t *pSocket = (socketSIM_t *)pContext;
+
+	pSocket->state = SIM_SOCKET_CLOSED;
+}
+
+/**
+ * @brief	Handler of URC_RECEIVE: +RECEIVE,<n>,<length>: announces the data received by a connection, the
+ * 			next length bytes are stored in the buffer of the connection instead of being tokenized.
+ * @param	Pointer to the line.
+ * @param	Length of the line.
+ * @param	Pointer to the SIM800_t structure of the modem.
+ * @retval	None.
+ */
+static void received_Socket_SIM(const uint8_t *pLine, uint8_t length, void *pContext)
+{
+	SIM800_t *pSIM = (SIM800_t *)pContext;
+	uint8_t i = (uint8_t)strlen(URC_RECEIVE);
+	uint8_t socket = N_SOCKETS_SIM;
+	uint16_t dataLength = 0;
+
+	if((i + 2U < length) && (pLine[i] >= '0') && (pLine[i] <= '9') && (pLine[i + 1U] == ','))
+		socket = pLine[i] - '0';
+
+	for(i += 2U; (i < length) && (pLine[i] >= '0') && (pLine[i] <= '9'); i++)
+		dataLength = (dataLength * 10U) + (pLine[i] - '0');
+
+	/* The data of an unknown connection is tokenized and discarded */
+	if(socket < N_SOCKETS_SIM)
+		at_Engine_Read_Data(&pSIM->engine, dataLength, store_Socket_SIM, &pSIM->sockets[socket]);
+}
+
+/**
+ * @brief	Stores the data received by a connection of the multi-connection mode in its buffer.
+ * @note	The data of a connection that was never opened has no buffer and is counted as discarded.
+ * @param	Pointer to the data.
+ * @param	Number of bytes.
+ * @param	Pointer to the socketSIM_t structure of the connection.
+ * @retval	None.
+ */
+static void store_Socket_SIM(const uint8_t *pData, uint16_t length, void *pContext)
+{
+	socketSIM_t *pSocket = (socketSIM_t *)pContext;
+	uint16_t i;
+
+	for(i = 0; i < length; i++)
+	{
+		if((pSocket->rxBuffer.pStorage == NULL) || (ring_Buffer_Put(&pSocket->rxBuffer, pData[i]) == false))
+			pSocket->dropped++;
+	}
+}
+
+/**
+ * @brief	Compiles the automaton of the keywords of the driver the first time it is called.
+ * @note	A compiled automaton has more states than the root, so the next calls do not compile it again.
+ * 			It fails if the keywords need more than AT_MATCHER_STATES states.
+ * @retval	Returns true if the automaton is compiled, otherwise false.
+ */
+static bool_t compile_Keywords_SIM(void)
+{
+	bool_t compiled = (matcherSIM.nStates > 1U);
+
+	if(compiled == false)
+		compiled = at_Matcher_Compile(&matcherSIM, keywordsSIM, N_KEYWORDS_SIM);
+
+	return compiled;
+}
+
+/**
+ * @brief	Gets the readiness level from the start-up messages found.
+ * @note	The levels follow the order of the keywords, from KEYWORD_RDY to KEYWORD_SMS_READY.
+ * @param	Mask of the keywords found.
+ * @retval	Highest readiness level whose message was found.
+ */
+static readySIM_t get_Ready_Level_SIM(uint32_t hits)
+{
+	readySIM_t level = SIM_READY_NONE;
+	uint8_t i;
+
+	for(i = SIM_READY_UART; i <= SIM_READY_SMS; i++)
+	{
+		if((hits & AT_MATCHER_HIT(KEYWORD_RDY + i - SIM_READY_UART)) != 0)
+			level = (readySIM_t)i;
+	}
+
+	return level;
 }
@@ -0,0 +1,679 @@
+/**
+ * @file 	at_engine.c
+ * @brief	This file presents the source code for the implementation of each function prototype
+ * 			described in the at_engine.h file.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include "at_engine.h"
+
+/**
+ * @brief	Descriptor of the command line built by at_Batch_Build(). The batch only joins commands that are
+ * 			completed by OK, so the whole line is completed by OK or by the error of one of them.
+ * */
+static const atCommandDescriptor_t batchDescriptor = {"", AT_SUCCESS_DEFAULT, AT_FAILURE_DEFAULT, TIMEOUT, false};
+
+/**
+ * @brief	Terminator of the payloads, static because the DMA sends it after process_Result_Engine() returns.
+ * */
+static const uint8_t ctrlZPayload = AT_CTRL_Z;
+
+/*--------------------- Prototypes of private functions ----------------------*/
+static void start_Command_Engine(atEngine_t *pEngine);
+static void process_Result_Engine(atEngine_t *pEngine, atResult_t result);
+static void finish_Command_Engine(atEngine_t *pEngine, atResult_t result);
+static bool_t dispatch_URC_Engine(const uint8_t *pLine, uint8_t length, void *pContext);
+static uint8_t get_Name_Length_Batch(const atCommandDescriptor_t *pDescriptor);
+static void find_Info_Batch(atBatch_t *pBatch, const atView_t *pLine);
+
+/**
+ * @brief	Initializes the engine over the port of the SIM.
+ * @param	Pointer to the engine.
+ * @param	Pointer to the port of the SIM.
+ * @param	Pointer to the buffer where the response of each command is copied.
+ * @param	Size of the buffer, including the '\0' terminator.
+ * @retval 	None.
+ */
+void at_Engine_Init(atEngine_t *pEngine, portSIM_t *pPort, uint8_t *pResponse, uint16_t responseSize)
+{
+	pEngine->pPort = pPort;
+	pEngine->queueHead = 0;
+	pEngine->queueTail = 0;
+	pEngine->state = AT_ENGINE_IDLE;
+	pEngine->pResponse = pResponse;
+	pEngine->responseSize = responseSize;
+	pEngine->responseLength = 0;
+	pEngine->responseHeld = false;
+	pEngine->holdOffStart = 0;
+	pEngine->holdOffTime = 0;
+	pEngine->dataMode = false;
+	pEngine->rawLength = 0;
+	pEngine->rawCallback = NULL;
+	pEngine->pRawContext = NULL;
+	pEngine->tickStart = 0;
+	pEngine->txFailures = 0;
+	pEngine->nUrcHandlers = 0;
+	pEngine->hits = 0;
+
+	/* Without a command in progress the lines are only tokenized to find the URCs */
+	at_Tokenizer_Init(&pEngine->tokenizer, NULL, 0);
+	at_Tokenizer_Set_Filter(&pEngine->tokenizer, dispatch_URC_Engine, pEngine);
+}
+
+/**
+ * @brief	Initializes a command from its descriptor and its parameters.
+ * @note	The text of the command is the syntax of the descriptor followed by the parameters, the <CR>
+ * 			terminator is added when it is sent. The timeout is the maximum response time of the descriptor.
+ * 			The command has no payload, no matcher and no callback.
+ * @param	Pointer to the command.
+ * @param 	Pointer to the descriptor, it must remain valid until the command is completed.
+ * @param 	Pointer to the parameters terminated with '\0', or NULL if the command has no parameters.
+ * @retval 	Returns true if the text fits in AT_COMMAND_SIZE, otherwise false and the text is left empty.
+ */
+bool_t at_Command_Init(atCommand_t *pCommand, const atCommandDescriptor_t *pDescriptor, const uint8_t *pParameters)
+{
+	bool_t statusText = false;
+	uint16_t syntaxLength = strlen(pDescriptor->pSyntax);
+	uint16_t parametersLength = (pParameters != NULL) ? strlen((const char *)pParameters) : 0U;
+
+	pCommand->textLength = 0;
+	if(syntaxLength + parametersLength <= AT_COMMAND_SIZE)
+	{
+		memcpy(pCommand->text, pDescriptor->pSyntax, syntaxLength);
+		if(parametersLength != 0)
+			memcpy(&pCommand->text[syntaxLength], pParameters, parametersLength);
+		pCommand->textLength = (uint8_t)(syntaxLength + parametersLength);
+		statusText = true;
+	}
+
+	pCommand->pDescriptor = pDescriptor;
+	pCommand->pPayload = NULL;
+	pCommand->payloadLength = 0;
+	pCommand->payloadCtrlZ = false;
+	pCommand->timeout = pDescriptor->maxResponseTime;
+	pCommand->pMatcher = NULL;
+	pCommand->callback = NULL;
+	pCommand->pContext = NULL;
+
+	return statusText;
+}
+
+/**
+ * @brief	Queues a command, it is sent by at_Engine_Poll() when the previous commands are completed.
+ * @param	Pointer to the engine.
+ * @param	Pointer to the command, it is copied to the queue.
+ * @note	In data mode no command is accepted, the SIM would take it as data of the connection.
+ * @retval 	Returns true if the command was queued, false if the queue is full, the text is empty or the
+ * 			engine is in data mode.
+ */
+bool_t at_Engine_Send(atEngine_t *pEngine, const atCommand_t *pCommand)
+{
+	bool_t statusSend = false;
+
+	if((pCommand->textLength != 0) && (pEngine->dataMode == false)
+			&& ((uint8_t)(pEngine->queueHead - pEngine->queueTail) < AT_QUEUE_SIZE))
+	{
+		pEngine->queue[pEngine->queueHead & (AT_QUEUE_SIZE - 1U)] = *pCommand;
+		pEngine->queueHead++;
+		statusSend = true;
+	}
+
+	return statusSend;
+}
+
+/**
+ * @brief	Advances the exchange with the SIM without blocking.
+ * @note	It must be called periodically from the main loop. Each call sends the next queued command when the
+ * 			engine is idle, feeds the tokenizer with the bytes received so far and checks the timeout of the
+ * 			command in progress. The callbacks are called from this function and at most one command is
+ * 			completed in each call.
+ * 			The URCs are dispatched as their lines are completed, also in the middle of a command. The other
+ * 			bytes received while no command is in progress are discarded, except the ones requested by a URC
+ * 			handler with at_Engine_Read_Data().
+ * 			In data mode it does not read the port, the commands queued before the data mode cannot be sent
+ * 			and each one is completed with AT_RESULT_NONE after its timeout.
+ * @param	Pointer to the engine.
+ * @retval 	None.
+ */
+void at_Engine_Poll(atEngine_t *pEngine)
+{
+	atResult_t result;
+	const uint8_t *pData;
+	uint16_t length;
+	uint16_t consumed;
+	bool_t pendingData = (pEngine->dataMode == false);
+
+	while(pendingData == true)
+	{
+		if((pEngine->state == AT_ENGINE_IDLE) && (pEngine->queueHead != pEngine->queueTail)
+				&& (pEngine->responseHeld == false) && ((HAL_GetTick() - pEngine->holdOffStart) >= pEngine->holdOffTime))
+			start_Command_Engine(pEngine);
+
+		length = peek_Buffer_UART(pEngine->pPort, &pData);
+
+		if(length == 0)
+			pendingData = false;
+		else if(pEngine->rawLength != 0)
+		{
+			if(length > pEngine->rawLength)
+				length = pEngine->rawLength;
+
+			pEngine->rawCallback(pData, length, pEngine->pRawContext);
+			release_Buffer_UART(pEngine->pPort, length);
+			pEngine->rawLength -= length;
+		}
+		else
+		{
+			result = at_Tokenizer_Feed(&pEngine->tokenizer, pData, length, &consumed);
+			release_Buffer_UART(pEngine->pPort, consumed);
+
+			if(pEngine->state == AT_ENGINE_WAIT_RESPONSE)
+			{
+				if(result != AT_RESULT_NONE)
+					process_Result_Engine(pEngine, result);
+
+				/* The response stays in the buffer until the next call, the next command is sent then */
+				if(pEngine->state == AT_ENGINE_IDLE)
+					pendingData = false;
+			}
+			else if(pEngine->tokenizer.pMatcher != NULL)
+				pEngine->hits = pEngine->tokenizer.hits;
+		}
+	}
+
+	/* A DMA transmission refused after the command was queued in the port fails the command without waiting */
+	if((pEngine->state == AT_ENGINE_WAIT_RESPONSE) && (pEngine->dataMode == false)
+			&& (((HAL_GetTick() - pEngine->tickStart) >= pEngine->queue[pEngine->queueTail & (AT_QUEUE_SIZE - 1U)].timeout)
+			|| (get_TX_Failures_UART(pEngine->pPort) != pEngine->txFailures)))
+		finish_Command_Engine(pEngine, AT_RESULT_NONE);
+	else if((pEngine->dataMode == true) && (pEngine->queueHead != pEngine->queueTail)
+			&& ((HAL_GetTick() - pEngine->tickStart) >= pEngine->queue[pEngine->queueTail & (AT_QUEUE_SIZE - 1U)].timeout))
+	{
+		finish_Command_Engine(pEngine, AT_RESULT_NONE);
+		pEngine->tickStart = HAL_GetTick();
+	}
+}
+
+/**
+ * @brief	Checks if there is a command in progress or waiting in the queue.
+ * @param	Pointer to the engine.
+ * @retval 	Returns true while there are commands pending, otherwise false.
+ */
+bool_t at_Engine_Is_Busy(const atEngine_t *pEngine)
+{
+	return (pEngine->state != AT_ENGINE_IDLE) || (pEngine->queueHead != pEngine->queueTail);
+}
+
+/**
+ * @brief	Gets the number of commands that can still be queued.
+ * @param	Pointer to the engine.
+ * @retval 	Number of free entries of the queue.
+ */
+uint8_t at_Engine_Free_Slots(const atEngine_t *pEngine)
+{
+	return (uint8_t)(AT_QUEUE_SIZE - (uint8_t)(pEngine->queueHead - pEngine->queueTail));
+}
+
+/**
+ * @brief	Gets the view of the response of the last completed command and holds it.
+ * @note	The response is seen in place in the response buffer, without copy. While it is held, the queued
+ * 			commands are not started, so it must be released with at_Engine_Release_Response() as soon as
+ * 			it is no longer used.
+ * @param	Pointer to the engine.
+ * @param	Pointer to the view where the response is stored.
+ * @retval 	None.
+ */
+void at_Engine_Get_Response(atEngine_t *pEngine, atView_t *pView)
+{
+	pView->pData = (pEngine->responseLength != 0) ? pEngine->pResponse : NULL;
+	pView->length = pEngine->responseLength;
+	pEngine->responseHeld = true;
+}
+
+/**
+ * @brief	Releases the response held by at_Engine_Get_Response(), so the next command can be started.
+ * @note	The views of the response are no longer valid.
+ * @param	Pointer to the engine.
+ * @retval 	None.
+ */
+void at_Engine_Release_Response(atEngine_t *pEngine)
+{
+	pEngine->responseHeld = false;
+}
+
+/**
+ * @brief	Delays the start of the next command, for example while the SIM wakes up.
+ * @note	The command in progress is not affected, the queued commands are sent when the time elapses.
+ * @param	Pointer to the engine.
+ * @param	Time in milliseconds from now.
+ * @retval 	None.
+ */
+void at_Engine_Hold_Off(atEngine_t *pEngine, uint32_t time)
+{
+	pEngine->holdOffStart = HAL_GetTick();
+	pEngine->holdOffTime = time;
+}
+
+/**
+ * @brief	Enters or leaves the data mode, in which the SIM sends and receives raw data instead of AT commands,
+ * 			for example after the CONNECT of a transparent connection.
+ * @note	It must be called with no command in progress, for example from the callback of the command that
+ * 			switched the SIM to data mode. The bytes received after that command are left in the port. When the
+ * 			data mode ends, the partial line of the tokenizer is discarded, the queued commands are started again.
+ * 			The commands still queued when it starts expire one after another, each after its own timeout, so
+ * 			a blocking function waiting for one of them returns.
+ * @param	Pointer to the engine.
+ * @param	true to enter the data mode, false to leave it.
+ * @retval 	None.
+ */
+void at_Engine_Set_Data_Mode(atEngine_t *pEngine, bool_t enable)
+{
+	if((enable == false) && (pEngine->dataMode == true))
+	{
+		at_Tokenizer_Init(&pEngine->tokenizer, NULL, 0);
+		at_Tokenizer_Set_Filter(&pEngine->tokenizer, dispatch_URC_Engine, pEngine);
+	}
+	else if((enable == true) && (pEngine->dataMode == false))
+		pEngine->tickStart = HAL_GetTick();
+
+	pEngine->dataMode = enable;
+}
+
+/**
+ * @brief	Checks if the engine is in data mode.
+ * @param	Pointer to the engine.
+ * @retval 	Returns true in data mode, otherwise false.
+ */
+bool_t at_Engine_Is_Data_Mode(const atEngine_t *pEngine)
+{
+	return pEngine->dataMode;
+}
+
+/**
+ * @brief	Passes the next bytes received to a callback instead of the tokenizer, for example the data
+ * 			announced by the URC "+RECEIVE,<n>,<length>:".
+ * @note	It must be called from a URC handler, the bytes after the line of the URC are not tokenized.
+ * 			The data is not part of the response of the command in progress, if any.
+ * @param	Pointer to the engine.
+ * @param	Number of bytes.
+ * @param	Function called with the bytes as they arrive.
+ * @param	Pointer passed to the callback.
+ * @retval 	None.
+ */
+void at_Engine_Read_Data(atEngine_t *pEngine, uint16_t length, atDataCallback_t callback, void *pContext)
+{
+	if((length != 0) && (callback != NULL))
+	{
+		pEngine->rawLength = length;
+		pEngine->rawCallback = callback;
+		pEngine->pRawContext = pContext;
+		at_Tokenizer_Stop(&pEngine->tokenizer);
+	}
+}
+
+/**
+ * @brief	Gets the keywords of the matcher of the last completed command found in its response.
+ * @note	The hits are valid in the callback of the command and until the next command is started.
+ * @param	Pointer to the engine.
+ * @retval 	Mask with the bits AT_MATCHER_HIT() of the keywords found, 0 if the command had no matcher.
+ */
+uint32_t at_Engine_Get_Hits(const atEngine_t *pEngine)
+{
+	return pEngine->hits;
+}
+
+/**
+ * @brief	Searches keywords in the lines received while no command is in progress, for example the
+ * 			messages sent by the SIM when it starts.
+ * @note	The hits are accumulated and read with at_Engine_Get_Hits(). The watch ends when the next command
+ * 			is started or when it is called with a NULL matcher. The lines taken by a URC handler are not searched.
+ * @param	Pointer to the engine.
+ * @param	Pointer to the compiled keywords, or NULL to end the watch.
+ * @retval 	Returns true if the watch was started, false if there are commands in progress or waiting.
+ */
+bool_t at_Engine_Watch(atEngine_t *pEngine, const atMatcher_t *pMatcher)
+{
+	bool_t statusWatch = false;
+
+	if((pEngine->state == AT_ENGINE_IDLE) && (pEngine->queueHead == pEngine->queueTail))
+	{
+		at_Tokenizer_Set_Matcher(&pEngine->tokenizer, pMatcher);
+		pEngine->hits = 0;
+		statusWatch = true;
+	}
+
+	return statusWatch;
+}
+
+/**
+ * @brief	Discards the bytes received and not yet processed in the port, including the data requested
+ * 			with at_Engine_Read_Data().
+ * @param	Pointer to the engine.
+ * @retval 	None.
+ */
+void at_Engine_Flush(atEngine_t *pEngine)
+{
+	flush_Data_UART(pEngine->pPort);
+	pEngine->rawLength = 0;
+}
+
+/**
+ * @brief	Registers a handler for the unsolicited result codes that start with the prefix.
+ * @note	The lines are compared with the handlers in the order of registration and only the first match is
+ * 			called. A line that matches a handler is never part of a command response, so the prefix must not
+ * 			be the one of an information response of the commands used, for example "+CREG:".
+ * @param	Pointer to the engine.
+ * @param	Pointer to the prefix, for example "+CMTI:". It is not copied, it must remain valid.
+ * @param	Function called with each line that starts with the prefix.
+ * @param	Pointer passed to the callback.
+ * @retval 	Returns true if the handler was registered, false if there is no free handler.
+ */
+bool_t at_Engine_Register_URC(atEngine_t *pEngine, const uint8_t *pPrefix, atUrcCallback_t callback, void *pContext)
+{
+	bool_t statusRegister = false;
+	atUrcHandler_t *pHandler;
+
+	if((pPrefix != NULL) && (callback != NULL) && (pEngine->nUrcHandlers < AT_URC_HANDLERS))
+	{
+		pHandler = &pEngine->urcHandlers[pEngine->nUrcHandlers];
+		pHandler->pPrefix = pPrefix;
+		pHandler->prefixLength = (uint8_t)strlen((const char *)pPrefix);
+		pHandler->callback = callback;
+		pHandler->pContext = pContext;
+		pEngine->nUrcHandlers++;
+		statusRegister = true;
+	}
+
+	return statusRegister;
+}
+
+/**
+ * @brief	Initializes an empty batch of commands.
+ * @param	Pointer to the batch.
+ * @retval 	None.
+ */
+void at_Batch_Init(atBatch_t *pBatch)
+{
+	uint8_t i;
+
+	pBatch->count = 0;
+
+	for(i = 0; i < AT_BATCH_SIZE; i++)
+	{
+		pBatch->results[i] = AT_RESULT_NONE;
+		pBatch->info[i].pData = NULL;
+		pBatch->info[i].length = 0;
+	}
+}
+
+/**
+ * @brief	Adds a command to the batch.
+ * @note	Only the extended commands "AT+..." completed by OK and without '>' prompt can be joined.
+ * @param	Pointer to the batch.
+ * @param	Pointer to the descriptor of the command, it must remain valid until the batch is split.
+ * @param	Pointer to the parameters terminated with '\0', or NULL. They are not copied, they must remain
+ * 			valid until the batch is built.
+ * @retval 	Returns true if the command was added, false if the batch is full or the command cannot be joined.
+ */
+bool_t at_Batch_Add(atBatch_t *pBatch, const atCommandDescriptor_t *pDescriptor, const uint8_t *pParameters)
+{
+	bool_t statusAdd = false;
+
+	if((pBatch->count < AT_BATCH_SIZE) && (pDescriptor->successMask == AT_SUCCESS_DEFAULT)
+			&& (pDescriptor->prompt == false) && (strncmp(pDescriptor->pSyntax, "AT+", 3) == 0))
+	{
+		pBatch->pDescriptors[pBatch->count] = pDescriptor;
+		pBatch->pParameters[pBatch->count] = pParameters;
+		pBatch->count++;
+		statusAdd = true;
+	}
+
+	return statusAdd;
+}
+
+/**
+ * @brief	Builds the single command line of the batch.
+ * @note	The "AT" prefix is only written for the first command, the other ones are joined with ';'.
+ * 			The timeout is the sum of the maximum response times of the commands.
+ * @param	Pointer to the batch.
+ * @param	Pointer to the command to build, it has no payload and no callback.
+ * @retval 	Returns true if the line fits in AT_COMMAND_SIZE, otherwise false and the text is left empty.
+ */
+bool_t at_Batch_Build(const atBatch_t *pBatch, atCommand_t *pCommand)
+{
+	bool_t statusText = (pBatch->count != 0);
+	uint16_t textLength = 0;
+	uint32_t timeout = 0;
+	uint16_t syntaxLength;
+	uint16_t parametersLength;
+	size_t neededLength;
+	const char *pSyntax;
+	uint8_t i;
+
+	at_Command_Init(pCommand, &batchDescriptor, NULL);
+
+	for(i = 0; (i < pBatch->count) && (statusText == true); i++)
+	{
+		/* "AT+CREG?" is written whole, "AT+CGATT?" is joined as ";+CGATT?" */
+		pSyntax = (i == 0) ? pBatch->pDescriptors[i]->pSyntax : &pBatch->pDescriptors[i]->pSyntax[2];
+		syntaxLength = strlen(pSyntax);
+		parametersLength = (pBatch->pParameters[i] != NULL) ? strlen((const char *)pBatch->pParameters[i]) : 0U;
+
+		neededLength = (size_t)textLength + ((i != 0) ? 1U : 0U) + syntaxLength + parametersLength;
+
+		if(neededLength <= AT_COMMAND_SIZE)
+		{
+			if(i != 0)
+				pCommand->text[textLength++] = ';';
+			memcpy(&pCommand->text[textLength], pSyntax, syntaxLength);
+			textLength += syntaxLength;
+			if(parametersLength != 0)
+				memcpy(&pCommand->text[textLength], pBatch->pParameters[i], parametersLength);
+			textLength += parametersLength;
+			timeout += pBatch->pDescriptors[i]->maxResponseTime;
+		}
+		else
+			statusText = false;
+	}
+
+	pCommand->textLength = (statusText == true) ? (uint8_t)textLength : 0U;
+	pCommand->timeout = timeout;
+
+	return statusText;
+}
+
+/**
+ * @brief	Splits the response of the command line of the batch into the result of each command.
+ * @note	Each information response is assigned to the command with the same name, "+CREG: 0,1" to AT+CREG?.
+ * 			If the line was completed by OK, every command gets AT_RESULT_OK. Otherwise the SIM stopped at the
+ * 			first command that failed: the commands before it get AT_RESULT_OK, that one gets the error and the
+ * 			following ones AT_RESULT_NONE. The failed command is the one after the last command with an
+ * 			information response, so it is only certain when the commands that have no information response
+ * 			are placed last.
+ * @param	Pointer to the batch.
+ * @param	Final result code of the command line.
+ * @param	Pointer to the view of the response, the views of the information responses point into it.
+ * @retval 	None.
+ */
+void at_Batch_Split(atBatch_t *pBatch, atResult_t result, const atView_t *pResponse)
+{
+	atView_t text = *pResponse;
+	atView_t line;
+	uint8_t failed = 0;
+	uint8_t i;
+
+	for(i = 0; i < pBatch->count; i++)
+	{
+		pBatch->info[i].pData = NULL;
+		pBatch->info[i].length = 0;
+	}
+
+	while(at_View_Next_Line(&text, &line) == true)
+		find_Info_Batch(pBatch, &line);
+
+	for(i = 0; i < pBatch->count; i++)
+	{
+		if(pBatch->info[i].pData != NULL)
+			failed = i + 1U;
+	}
+
+	for(i = 0; i < pBatch->count; i++)
+	{
+		if((result == AT_RESULT_OK) || (i < failed))
+			pBatch->results[i] = AT_RESULT_OK;
+		else if(i == failed)
+			pBatch->results[i] = result;
+		else
+			pBatch->results[i] = AT_RESULT_NONE;
+	}
+}
+
+/**
+ * @brief	Sends the command at the tail of the queue and starts waiting for its response.
+ * @param	Pointer to the engine.
+ * @retval 	None.
+ */
+static void start_Command_Engine(atEngine_t *pEngine)
+{
+	atCommand_t *pCommand = &pEngine->queue[pEngine->queueTail & (AT_QUEUE_SIZE - 1U)];
+	ioVector_t commandLine[] = {
+		{pCommand->text, pCommand->textLength},
+		IO_VECTOR_STRING("\r")
+	};
+
+	at_Tokenizer_Set_Buffer(&pEngine->tokenizer, pEngine->pResponse, pEngine->responseSize);
+	at_Tokenizer_Set_Matcher(&pEngine->tokenizer, pCommand->pMatcher);
+	at_Tokenizer_Expect_Prompt(&pEngine->tokenizer, (pCommand->pDescriptor->prompt == true) && (pCommand->pPayload != NULL));
+	pEngine->hits = 0;
+	pEngine->state = AT_ENGINE_WAIT_RESPONSE;
+	pEngine->tickStart = HAL_GetTick();
+	pEngine->txFailures = get_TX_Failures_UART(pEngine->pPort);
+
+	if(write_Vector_UART(pEngine->pPort, commandLine, sizeof(commandLine)/sizeof(commandLine[0])) == UNSUCCESSFUL)
+		finish_Command_Engine(pEngine, AT_RESULT_NONE);
+}
+
+/**
+ * @brief	Processes a result code received for the command in progress.
+ * @note	The '>' prompt of a command with prompt and payload sends the payload and restarts the timeout.
+ * 			The payload is queued without copying it, because it remains valid until the command is completed,
+ * 			so in TX_MODE_DMA SIM800_Poll() does not wait for its transmission.
+ * 			The success and failure results of the descriptor complete the command, the other ones are
+ * 			skipped, for example the OK that AT+CIPSTART sends before CONNECT OK.
+ * @param	Pointer to the engine.
+ * @param	Result code received.
+ * @retval 	None.
+ */
+static void process_Result_Engine(atEngine_t *pEngine, atResult_t result)
+{
+	atCommand_t *pCommand = &pEngine->queue[pEngine->queueTail & (AT_QUEUE_SIZE - 1U)];
+	const atCommandDescriptor_t *pDescriptor = pCommand->pDescriptor;
+	bool_t statusTx;
+
+	if((result == AT_RESULT_PROMPT) && (pDescriptor->prompt == true) && (pCommand->pPayload != NULL))
+	{
+		pEngine->tickStart = HAL_GetTick();
+
+		statusTx = write_Data_UART_len(pEngine->pPort, pCommand->pPayload, pCommand->payloadLength);
+		if((statusTx == SUCCESSFUL) && (pCommand->payloadCtrlZ == true))
+			statusTx = write_Data_UART_len(pEngine->pPort, &ctrlZPayload, 1);
+
+		if(statusTx == UNSUCCESSFUL)
+			finish_Command_Engine(pEngine, AT_RESULT_NONE);
+	}
+	else if(((pDescriptor->successMask | pDescriptor->failureMask) & AT_RESULT_MASK(result)) != 0)
+		finish_Command_Engine(pEngine, result);
+}
+
+/**
+ * @brief	Completes the command in progress and calls its callback.
+ * @note	The command is removed from the queue before the callback, so the callback can queue new commands.
+ * @param	Pointer to the engine.
+ * @param	Final result code, AT_RESULT_NONE if the command timed out.
+ * @retval 	None.
+ */
+static void finish_Command_Engine(atEngine_t *pEngine, atResult_t result)
+{
+	atCommand_t *pCommand = &pEngine->queue[pEngine->queueTail & (AT_QUEUE_SIZE - 1U)];
+	atCallback_t callback = pCommand->callback;
+	void *pContext = pCommand->pContext;
+	atView_t response;
+
+	pEngine->queueTail++;
+	pEngine->state = AT_ENGINE_IDLE;
+	pEngine->hits = pEngine->tokenizer.hits;
+	pEngine->responseLength = pEngine->tokenizer.length;
+	at_Tokenizer_Set_Buffer(&pEngine->tokenizer, NULL, 0);
+	at_Tokenizer_Set_Matcher(&pEngine->tokenizer, NULL);
+	at_Tokenizer_Expect_Prompt(&pEngine->tokenizer, false);
+
+	response.pData = (pEngine->responseLength != 0) ? pEngine->pResponse : NULL;
+	response.length = pEngine->responseLength;
+
+	if(callback != NULL)
+		callback(result, &response, pContext);
+}
+
+/**
+ * @brief	Line filter of the tokenizer: calls the first URC handler whose prefix starts the line.
+ * @param	Pointer to the completed line.
+ * @param	Length of the line.
+ * @param	Pointer to the engine.
+ * @retval 	Returns true if the line was a URC, otherwise false.
+ */
+static bool_t dispatch_URC_Engine(const uint8_t *pLine, uint8_t length, void *pContext)
+{
+	atEngine_t *pEngine = (atEngine_t *)pContext;
+	atUrcHandler_t *pHandler;
+	bool_t isURC = false;
+	uint8_t i;
+
+	for(i = 0; (i < pEngine->nUrcHandlers) && (isURC == false); i++)
+	{
+		pHandler = &pEngine->urcHandlers[i];
+
+		if((length >= pHandler->prefixLength) && (memcmp(pLine, pHandler->pPrefix, pHandler->prefixLength) == 0))
+		{
+			pHandler->callback(pLine, length, pHandler->pContext);
+			isURC = true;
+		}
+	}
+
+	return isURC;
+}
+
+/**
+ * @brief	Gets the length of the name of an extended command, for example 5 for "AT+CREG?" ("+CREG").
+ * @param	Pointer to the descriptor of the command.
+ * @retval 	Length of the name, starting at the '+' character.
+ */
+static uint8_t get_Name_Length_Batch(const atCommandDescriptor_t *pDescriptor)
+{
+	return (uint8_t)strcspn(&pDescriptor->pSyntax[2], "?=");
+}
+
+/**
+ * @brief	Assigns a line of the response to the first command of the batch with the same name.
+ * @param	Pointer to the batch.
+ * @param	Pointer to the view of the line.
+ * @retval 	None.
+ */
+static void find_Info_Batch(atBatch_t *pBatch, const atView_t *pLine)
+{
+	uint8_t nameLength;
+	uint8_t i;
+
+	for(i = 0; i < pBatch->count; i++)
+	{
+		nameLength = get_Name_Length_Batch(pBatch->pDescriptors[i]);
+
+		if((pBatch->info[i].pData == NULL) && (pLine->length > nameLength) && (pLine->pData[nameLength] == ':')
+				&& (memcmp(pLine->pData, &pBatch->pDescriptors[i]->pSyntax[2], nameLength) == 0))
+		{
+			pBatch->info[i] = *pLine;
+			break;
+		}
+	}
+}
@@ -63,6 +63,7 @@ UART_HandleTypeDef huart2;
 uint8_t cellNumber[13]="+51123456789";
 uint8_t sms[60]="HELLO FROM SIM800: THE BUTTON HAS BEEN PRESSED";
 /* USER CODE BEGIN PV */
+SIM800_t sim800;
 
 /* USER CODE END PV */
 
@@ -119,15 +120,15 @@ int main(void)
 
   BSP_LED_On(LED_USER);
   /* USER CODE END 2 */
-  if(SIM800_Default_ConfigHW() == OK)
+  if(SIM800_Default_ConfigHW(&sim800) == OK)
   	  HAL_UART_Transmit(&huart2, (const uint8_t*)"HW SIM OK\r\n", strlen("HW SIM OK\r\n"), 1000);
   else
   	  HAL_UART_Transmit(&huart2, (const uint8_t*)"HW SIM NO CONFIG\r\n", strlen("HW SIM NO CONFIG\r\n"), 1000);
 
-  SIM800_On();
+  SIM800_On(&sim800);
   HAL_UART_Transmit(&huart2, (const uint8_t*)"SIM ACTIVATED\r\n", strlen("SIM ACTIVATED\r\n"), 1000);
 
-  if(SIM800_Init() == OK)
+  if(SIM800_Init(&sim800) == OK)
 	  HAL_UART_Transmit(&huart2, (const uint8_t*)"CONFIGURED\r", strlen("CONFIGURED\r"), 1000);
   else
 	  HAL_UART_Transmit(&huart2, (const uint8_t*)"FAIL\r", strlen("NOK\r"), 1000);
@@ -142,12 +143,12 @@ int main(void)
 	  {
 		  HAL_UART_Transmit(&huart2, (const uint8_t*)"BUTTON PRESSED\r", strlen("BUTTON PRESSED\r"), 1000);
 		  /*Check if we are registered in the network*/
-		  if(check_Network_Registration()== OK)	//
+		  if(check_Network_Registration(&sim800)== OK)	//
 		  {
 			  HAL_UART_Transmit(&huart2, (const uint8_t*)"SIM REGISTERED\r", strlen("SIM REGISTERED\r"), 1000);
 
 			  /* Send text SMS to the indicated number */
-			  if(send_SMS(&cellNumber,&sms) == OK)
+			  if(send_SMS(&sim800, &cellNumber,&sms) == OK)
 				  HAL_UART_Transmit(&huart2, (const uint8_t*)"SMS SENT\r", strlen("SMS SENT\r"), 1000);
 			  else
 				  HAL_UART_Transmit(&huart2, (const uint8_t*)"SMS NOT SENT\r", strlen("SMS NOT SENT\r"), 1000);
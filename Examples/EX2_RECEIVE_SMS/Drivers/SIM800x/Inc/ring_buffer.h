@@ -0,0 +1,59 @@
+/**
+ * @file 	ring_buffer.h
+ * @brief	Lock-free single-producer/single-consumer byte ring buffer used by the port layer
+ * 			to decouple the UART interrupt from the AT command parser.
+ * @note	This module does not depend on the HAL, so it can be compiled and tested on a host
+ * 			by feeding the ring from a simulated interrupt routine.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#ifndef SIM800X_INC_RING_BUFFER_H_
+#define SIM800X_INC_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @typedef	bool_t
+ * @brief	A type definition for bool
+ * */
+typedef bool bool_t;
+
+/**
+ * @def		RING_BUFFER_BARRIER
+ * @brief	Memory barrier placed between the access to the data and the update of the index,
+ * 			so the other side never sees an index that is ahead of the data.
+ * */
+#ifndef RING_BUFFER_BARRIER
+#define RING_BUFFER_BARRIER()						__sync_synchronize()
+#endif
+
+/**
+ * @struct	ringBuffer_t
+ * @brief	Ring buffer control structure.
+ * @note	The size of the storage must be a power of two. The head index is only written by the
+ * 			producer (UART interrupt) and the tail index is only written by the consumer (main loop),
+ * 			so no critical section is required. Both indexes run freely and are masked on access.
+ * */
+typedef struct
+{
+	uint8_t				*pStorage;
+	uint16_t			mask;
+	volatile uint16_t	head;
+	volatile uint16_t	tail;
+}ringBuffer_t;
+
+bool_t		ring_Buffer_Init(ringBuffer_t *pRing, uint8_t *pStorage, uint16_t size);
+bool_t		ring_Buffer_Put(ringBuffer_t *pRing, uint8_t data);
+bool_t		ring_Buffer_Get(ringBuffer_t *pRing, uint8_t *pData);
+uint16_t	ring_Buffer_Read(ringBuffer_t *pRing, uint8_t *pData, uint16_t size);
+uint16_t	ring_Buffer_Peek(const ringBuffer_t *pRing, const uint8_t **ppData);
+void		ring_Buffer_Skip(ringBuffer_t *pRing, uint16_t count);
+uint16_t	ring_Buffer_Count(const ringBuffer_t *pRing);
+uint16_t	ring_Buffer_Free(const ringBuffer_t *pRing);
+void		ring_Buffer_Flush(ringBuffer_t *pRing);
+
+#endif /* SIM800X_INC_RING_BUFFER_H_ */
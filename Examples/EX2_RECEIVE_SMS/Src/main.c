@@ -8,13 +8,19 @@
   * 					  which uses the default UART1 and pins B0 and B1 for powerKey and reset respectively.
   * 					  Otherwise use the SIM800_ConfigHW() function to define the UART and pins.
   * 					  2. Power up the SIM with the SIM800_On() function.
-  * 					  3. Initialize the SIM with the SIM800_Init() function.
-  * 					  This function configures the SIM in text mode for SMS functions and a baud rate of 9600
-  * 					  for communication with the SIM UART.
+  * 					  3. Initialize the SIM with the SIM800_Init_Profile() function.
+  * 					  This function configures the SIM in text mode for SMS functions, a baud rate of 9600
+  * 					  for communication with the SIM UART and the +CMTI indication of new messages. The profile
+  * 					  is saved in the SIM, so the next start-ups only verify it.
   * 				  The sequence to send an SMS text message is as follows:
   * 				  	1. Verify if the SIM800 is registered on the network 2. Use the check_Network_Registration() function.
   * 				  	2. If the SIM is registered, use the function send_SMS(cellNumber,message) and pass as parameters
   * 				  	the cell number to which you want to send the message and as a second parameter the text to send.
+  * 				  The received messages are listed only when the SIM reports a new SMS with the +CMTI URC,
+  * 				  whose handler is registered with SIM800_Register_URC(). SIM800_Poll() dispatches the URCs
+  * 				  while no other command is in progress.
+  * 				  Both keywords are searched in a single listing with search_Received_SMS(), using a matcher
+  * 				  compiled once at startup.
   * @author	:	Yonatan Aguirre - PCSE CESE18 UBA
   ************************************************************************************************************************
   * @attention
@@ -39,12 +45,19 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
+typedef enum
+{
+  SMS_LED_USER_ON = 0,
+  SMS_LED_USER_OFF,
+  N_SMS_KEYWORDS
+}smsKeyword_t;
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 #define LED_USER_ON         			"LED_USER_ON"
 #define LED_USER_OFF        			"LED_USER_OFF"
+#define NEW_SMS_INDICATION				"2,1,0,0,0"
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -58,6 +71,12 @@ UART_HandleTypeDef huart2;
 
 uint8_t index_sms = 1;
 /* USER CODE BEGIN PV */
+SIM800_t sim800;
+bool_t newSMS = false;
+const char * const smsKeywords[N_SMS_KEYWORDS] = {LED_USER_ON, LED_USER_OFF};
+atMatcher_t smsMatcher;
+const profileSIM_t simProfile = {DEFAULT_BAUD_RATE, false, NEW_SMS_INDICATION};
+uint32_t smsHits;
 
 /* USER CODE END PV */
 
@@ -67,12 +86,15 @@ static void MX_GPIO_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_USART1_UART_Init(void);
 /* USER CODE BEGIN PFP */
-
+void newSMSReceived(const uint8_t *pLine, uint8_t length, void *pContext);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-
+void newSMSReceived(const uint8_t *pLine, uint8_t length, void *pContext)
+{
+  newSMS = true;
+}
 /* USER CODE END 0 */
 
 /**
@@ -109,21 +131,24 @@ int main(void)
   BSP_LED_Init(LED_USER);
   BSP_LED_On(LED_USER);
   /* USER CODE END 2 */
-  if(SIM800_Default_ConfigHW() == OK)
+  if(SIM800_Default_ConfigHW(&sim800) == OK)
   	  HAL_UART_Transmit(&huart2, (const uint8_t*)"HW SIM OK\r\n", strlen("HW SIM OK\r\n"), 1000);
   else
   	  HAL_UART_Transmit(&huart2, (const uint8_t*)"HW SIM NO CONFIG\r\n", strlen("HW SIM NO CONFIG\r\n"), 1000);
 
-  SIM800_On();
+  SIM800_Register_URC(&sim800, (const uint8_t*)URC_NEW_SMS, newSMSReceived, NULL);
+  at_Matcher_Compile(&smsMatcher, smsKeywords, N_SMS_KEYWORDS);
+
+  SIM800_On(&sim800);
   HAL_UART_Transmit(&huart2, (const uint8_t*)"SIM ACTIVATED\r\n", strlen("SIM ACTIVATED\r\n"), 1000);
 
-  if(SIM800_Init() == OK)
+  if(SIM800_Init_Profile(&sim800, &simProfile) == OK)
 	  HAL_UART_Transmit(&huart2, (const uint8_t*)"CONFIGURED\r", strlen("CONFIGURED\r"), 1000);
   else
 	  HAL_UART_Transmit(&huart2, (const uint8_t*)"FAIL\r", strlen("FAIL\r"), 1000);
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
-  delete_SMS(index_sms, DELETE_ALL_SMS);
+  delete_SMS(&sim800, index_sms, DELETE_ALL_SMS);
   while (1)
   {
     /* USER CODE END WHILE */
@@ -131,15 +156,25 @@ int main(void)
 	   * List the received unread messages and search in the message body.
 	   * If the string to turn on or off the user led of the board is found
 	   */
-	  if(list_Received_SMS_((const uint8_t*)LED_USER_ON,(const uint8_t*)RECEIVED_UNREAD)== OK)
-	  {
-		  BSP_LED_On(LED_USER);
-		  delete_SMS(index_sms, DELETE_ALL_SMS);
-	  }
-	  else if(list_Received_SMS_((const uint8_t*)LED_USER_OFF,(const uint8_t*)RECEIVED_UNREAD)== OK)
+	  SIM800_Poll(&sim800);
+
+	  if(newSMS == true)
 	  {
-		  BSP_LED_Off(LED_USER);
-		  delete_SMS(index_sms, DELETE_ALL_SMS);
+		  newSMS = false;
+
+		  if(search_Received_SMS(&sim800, (const uint8_t*)RECEIVED_UNREAD, &smsMatcher, &smsHits) == OK)
+		  {
+			  if((smsHits & AT_MATCHER_HIT(SMS_LED_USER_ON)) != 0)
+			  {
+				  BSP_LED_On(LED_USER);
+				  delete_SMS(&sim800, index_sms, DELETE_ALL_SMS);
+			  }
+			  else if((smsHits & AT_MATCHER_HIT(SMS_LED_USER_OFF)) != 0)
+			  {
+				  BSP_LED_Off(LED_USER);
+				  delete_SMS(&sim800, index_sms, DELETE_ALL_SMS);
+			  }
+		  }
 	  }
     /* USER CODE BEGIN 3 */
   }
@@ -0,0 +1,71 @@
+/**
+ * @file 	at_matcher.h
+ * @brief	Multi-pattern matcher (Aho-Corasick automaton) that searches several keywords in the SIM responses
+ * 			in a single pass, one byte at a time, as the bytes arrive.
+ * @note	The automaton is compiled once from the list of keywords, then it is only read, so the same matcher
+ * 			can be shared by several modems. This module does not depend on the HAL, so it can be compiled
+ * 			and tested on a host.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#ifndef SIM800X_INC_AT_MATCHER_H_
+#define SIM800X_INC_AT_MATCHER_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @typedef	bool_t
+ * @brief	A type definition for bool
+ * */
+typedef bool bool_t;
+
+/**
+ * @def		AT_MATCHER_STATES
+ * @brief	Defines the maximum number of states of the automaton: one for the root and at most one for each
+ * 			character of the keywords. It must not exceed 255.
+ *
+ * @def		AT_MATCHER_PATTERNS
+ * @brief	Defines the maximum number of keywords, each one is a bit of the mask of hits.
+ *
+ * @def		AT_MATCHER_HIT
+ * @brief	Builds the bit of a keyword in the mask of hits, from its index in the list of keywords.
+ * */
+#define AT_MATCHER_STATES							64U
+#define AT_MATCHER_PATTERNS							32U
+#define AT_MATCHER_HIT(index)						((uint32_t)1U << (index))
+
+/**
+ * @struct	atMatcherState_t
+ * @brief	State of the automaton. The children of a state are linked by sibling, 0 ends the list because the
+ * 			root is never a child. output has the bits of the keywords that end in this state, including the
+ * 			ones reached through the failure links.
+ * */
+typedef struct
+{
+	uint8_t		character;
+	uint8_t		child;
+	uint8_t		sibling;
+	uint8_t		fail;
+	uint32_t	output;
+}atMatcherState_t;
+
+/**
+ * @struct	atMatcher_t
+ * @brief	Compiled automaton of a list of keywords.
+ * */
+typedef struct
+{
+	atMatcherState_t	states[AT_MATCHER_STATES];
+	uint8_t				nStates;
+}atMatcher_t;
+
+bool_t		at_Matcher_Compile(atMatcher_t *pMatcher, const char * const pPatterns[], uint8_t count);
+uint8_t		at_Matcher_Step(const atMatcher_t *pMatcher, uint8_t state, uint8_t data, uint32_t *pHits);
+uint32_t	at_Matcher_Scan(const atMatcher_t *pMatcher, const uint8_t *pData, uint16_t length);
+
+#endif /* SIM800X_INC_AT_MATCHER_H_ */
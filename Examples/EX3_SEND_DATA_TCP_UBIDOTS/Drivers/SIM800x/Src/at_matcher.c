@@ -0,0 +1,156 @@
+/**
+ * @file 	at_matcher.c
+ * @brief	This file presents the source code for the implementation of each function prototype
+ * 			described in the at_matcher.h file.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include "at_matcher.h"
+
+/*--------------------- Prototypes of private functions ----------------------*/
+static uint8_t find_Child_Matcher(const atMatcher_t *pMatcher, uint8_t state, uint8_t data);
+
+/**
+ * @brief	Compiles the automaton of a list of keywords.
+ * @note	The keywords are inserted in a trie, then the failure links are calculated in breadth-first order,
+ * 			so each state falls back to the longest suffix of its text that is also a prefix of a keyword.
+ * 			The keyword at index i is reported with the bit AT_MATCHER_HIT(i).
+ * @param	Pointer to the matcher.
+ * @param 	Array of keywords terminated with '\0', they are not used after the compilation.
+ * @param 	Number of keywords, up to AT_MATCHER_PATTERNS.
+ * @retval 	Returns true if the automaton was compiled, false if there are too many keywords or characters
+ * 			or a keyword is empty.
+ */
+bool_t at_Matcher_Compile(atMatcher_t *pMatcher, const char * const pPatterns[], uint8_t count)
+{
+	bool_t statusCompile = (count <= AT_MATCHER_PATTERNS);
+	uint8_t queue[AT_MATCHER_STATES];
+	uint8_t queueHead = 0;
+	uint8_t queueTail = 0;
+	uint8_t state;
+	uint8_t child;
+	uint8_t fail;
+	const char *pText;
+	uint8_t i;
+
+	memset(&pMatcher->states[0], 0, sizeof(pMatcher->states[0]));
+	pMatcher->nStates = 1;
+
+	/* Trie of the keywords */
+	for(i = 0; (i < count) && (statusCompile == true); i++)
+	{
+		state = 0;
+		for(pText = pPatterns[i]; (*pText != '\0') && (statusCompile == true); pText++)
+		{
+			child = find_Child_Matcher(pMatcher, state, (uint8_t)*pText);
+
+			if((child == 0) && (pMatcher->nStates < AT_MATCHER_STATES))
+			{
+				child = pMatcher->nStates++;
+				pMatcher->states[child].character = (uint8_t)*pText;
+				pMatcher->states[child].child = 0;
+				pMatcher->states[child].sibling = pMatcher->states[state].child;
+				pMatcher->states[child].fail = 0;
+				pMatcher->states[child].output = 0;
+				pMatcher->states[state].child = child;
+			}
+			else if(child == 0)
+				statusCompile = false;
+
+			state = child;
+		}
+
+		/* An empty keyword would match at every byte */
+		if(state != 0)
+			pMatcher->states[state].output |= AT_MATCHER_HIT(i);
+		else
+			statusCompile = false;
+	}
+
+	/* Failure links, the children of the root fall back to the root */
+	for(child = pMatcher->states[0].child; (child != 0) && (statusCompile == true); child = pMatcher->states[child].sibling)
+		queue[queueTail++] = child;
+
+	while((queueHead != queueTail) && (statusCompile == true))
+	{
+		state = queue[queueHead++];
+
+		for(child = pMatcher->states[state].child; child != 0; child = pMatcher->states[child].sibling)
+		{
+			fail = pMatcher->states[state].fail;
+			while((fail != 0) && (find_Child_Matcher(pMatcher, fail, pMatcher->states[child].character) == 0))
+				fail = pMatcher->states[fail].fail;
+
+			pMatcher->states[child].fail = find_Child_Matcher(pMatcher, fail, pMatcher->states[child].character);
+			pMatcher->states[child].output |= pMatcher->states[pMatcher->states[child].fail].output;
+			queue[queueTail++] = child;
+		}
+	}
+
+	if(statusCompile == false)
+		pMatcher->nStates = 1;
+
+	return statusCompile;
+}
+
+/**
+ * @brief	Advances the automaton with a received byte.
+ * @note	The state 0 is the root, it is the initial state of each search.
+ * @param	Pointer to the matcher.
+ * @param	Current state.
+ * @param	Received byte.
+ * @param	Pointer to the mask where the bits of the keywords that end with this byte are set.
+ * @retval 	Next state.
+ */
+uint8_t at_Matcher_Step(const atMatcher_t *pMatcher, uint8_t state, uint8_t data, uint32_t *pHits)
+{
+	uint8_t next = find_Child_Matcher(pMatcher, state, data);
+
+	while((next == 0) && (state != 0))
+	{
+		state = pMatcher->states[state].fail;
+		next = find_Child_Matcher(pMatcher, state, data);
+	}
+
+	*pHits |= pMatcher->states[next].output;
+
+	return next;
+}
+
+/**
+ * @brief	Searches the keywords in a block of bytes.
+ * @param	Pointer to the matcher.
+ * @param	Pointer to the bytes.
+ * @param	Number of bytes.
+ * @retval 	Mask with the bits of the keywords found.
+ */
+uint32_t at_Matcher_Scan(const atMatcher_t *pMatcher, const uint8_t *pData, uint16_t length)
+{
+	uint32_t hits = 0;
+	uint8_t state = 0;
+	uint16_t i;
+
+	for(i = 0; i < length; i++)
+		state = at_Matcher_Step(pMatcher, state, pData[i], &hits);
+
+	return hits;
+}
+
+/**
+ * @brief	Gets the child of a state for a character.
+ * @param	Pointer to the matcher.
+ * @param	State.
+ * @param	Character.
+ * @retval 	Child state, or 0 if the state has no child for the character.
+ */
+static uint8_t find_Child_Matcher(const atMatcher_t *pMatcher, uint8_t state, uint8_t data)
+{
+	uint8_t child = pMatcher->states[state].child;
+
+	while((child != 0) && (pMatcher->states[child].character != data))
+		child = pMatcher->states[child].sibling;
+
+	return child;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file 	ring_buffer.c
+ * @brief	This file presents the source code for the implementation of each function prototype
+ * 			described in the ring_buffer.h file.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include "ring_buffer.h"
+
+/**
+ * @brief	Initializes the ring buffer over the storage passed as a parameter.
+ * @param	Pointer to the ring buffer control structure.
+ * @param	Pointer to the storage array.
+ * @param	Size of the storage array, it must be a power of two.
+ * @retval 	Initialization status. If the initialization was successful it returns true, otherwise it returns false.
+ */
+bool_t ring_Buffer_Init(ringBuffer_t *pRing, uint8_t *pStorage, uint16_t size)
+{
+	bool_t initStatusRing = false;
+
+	/* The size must be a power of two so the indexes can be masked instead of divided */
+	if((pRing != NULL) && (pStorage != NULL) && (size != 0) && ((size & (size - 1U)) == 0))
+	{
+		pRing->pStorage = pStorage;
+		pRing->mask = size - 1U;
+		pRing->head = 0;
+		pRing->tail = 0;
+		initStatusRing = true;
+	}
+
+	return initStatusRing;
+}
+
+/**
+ * @brief	Stores a byte in the ring buffer.
+ * @note	This function must only be called by the producer (UART interrupt).
+ * @param	Pointer to the ring buffer control structure.
+ * @param	Byte to store.
+ * @retval 	Returns true if the byte was stored, false if the ring buffer is full.
+ */
+bool_t ring_Buffer_Put(ringBuffer_t *pRing, uint8_t data)
+{
+	uint16_t head = pRing->head;
+	bool_t statusPut = false;
+
+	if((uint16_t)(head - pRing->tail) <= pRing->mask)
+	{
+		pRing->pStorage[head & pRing->mask] = data;
+		RING_BUFFER_BARRIER();
+		pRing->head = head + 1U;
+		statusPut = true;
+	}
+
+	return statusPut;
+}
+
+/**
+ * @brief	Extracts a byte from the ring buffer.
+ * @note	This function must only be called by the consumer (main loop).
+ * @param	Pointer to the ring buffer control structure.
+ * @param	Pointer where the extracted byte is stored.
+ * @retval 	Returns true if a byte was extracted, false if the ring buffer is empty.
+ */
+bool_t ring_Buffer_Get(ringBuffer_t *pRing, uint8_t *pData)
+{
+	uint16_t tail = pRing->tail;
+	bool_t statusGet = false;
+
+	if(pRing->head != tail)
+	{
+		RING_BUFFER_BARRIER();
+		*pData = pRing->pStorage[tail & pRing->mask];
+		RING_BUFFER_BARRIER();
+		pRing->tail = tail + 1U;
+		statusGet = true;
+	}
+
+	return statusGet;
+}
+
+/**
+ * @brief	Extracts up to size bytes from the ring buffer without blocking.
+ * @note	This function must only be called by the consumer (main loop).
+ * @param	Pointer to the ring buffer control structure.
+ * @param	Pointer to the destination buffer.
+ * @param	Maximum number of bytes to extract.
+ * @retval 	Number of bytes extracted.
+ */
+uint16_t ring_Buffer_Read(ringBuffer_t *pRing, uint8_t *pData, uint16_t size)
+{
+	uint16_t tail = pRing->tail;
+	uint16_t count = (uint16_t)(pRing->head - tail);
+	uint16_t i;
+
+	if(count > size)
+		count = size;
+
+	RING_BUFFER_BARRIER();
+	for(i = 0; i < count; i++)
+		pData[i] = pRing->pStorage[(uint16_t)(tail + i) & pRing->mask];
+	RING_BUFFER_BARRIER();
+	pRing->tail = tail + count;
+
+	return count;
+}
+
+/**
+ * @brief	Gets the oldest bytes of the ring buffer without copying or extracting them.
+ * @note	This function must only be called by the consumer (main loop). Only the bytes up to the end of the
+ * 			storage are returned, the ones after the wrap are returned by the next call once these are skipped.
+ * 			The bytes remain valid until they are released with ring_Buffer_Skip().
+ * @param	Pointer to the ring buffer control structure.
+ * @param	Pointer where the address of the oldest byte is stored.
+ * @retval 	Number of contiguous bytes available at that address.
+ */
+uint16_t ring_Buffer_Peek(const ringBuffer_t *pRing, const uint8_t **ppData)
+{
+	uint16_t tail = pRing->tail;
+	uint16_t count = (uint16_t)(pRing->head - tail);
+	uint16_t contiguous = (uint16_t)(pRing->mask + 1U - (tail & pRing->mask));
+
+	RING_BUFFER_BARRIER();
+	if(count > contiguous)
+		count = contiguous;
+	*ppData = &pRing->pStorage[tail & pRing->mask];
+
+	return count;
+}
+
+/**
+ * @brief	Releases bytes obtained with ring_Buffer_Peek(), so the producer can reuse their space.
+ * @note	This function must only be called by the consumer (main loop).
+ * @param	Pointer to the ring buffer control structure.
+ * @param	Number of bytes to release, at most the number returned by ring_Buffer_Peek().
+ * @retval 	None.
+ */
+void ring_Buffer_Skip(ringBuffer_t *pRing, uint16_t count)
+{
+	RING_BUFFER_BARRIER();
+	pRing->tail = pRing->tail + count;
+}
+
+/**
+ * @brief	Gets the number of bytes stored in the ring buffer.
+ * @param	Pointer to the ring buffer control structure.
+ * @retval 	Number of bytes pending to be read.
+ */
+uint16_t ring_Buffer_Count(const ringBuffer_t *pRing)
+{
+	return (uint16_t)(pRing->head - pRing->tail);
+}
+
+/**
+ * @brief	Gets the number of bytes that can still be stored in the ring buffer.
+ * @param	Pointer to the ring buffer control structure.
+ * @retval 	Number of free bytes.
+ */
+uint16_t ring_Buffer_Free(const ringBuffer_t *pRing)
+{
+	return (uint16_t)(pRing->mask + 1U - (uint16_t)(pRing->head - pRing->tail));
+}
+
+/**
+ * @brief	Discards all the bytes stored in the ring buffer.
+ * @note	This function must only be called by the consumer (main loop).
+ * @param	Pointer to the ring buffer control structure.
+ * @retval 	None.
+ */
+void ring_Buffer_Flush(ringBuffer_t *pRing)
+{
+	pRing->tail = pRing->head;
+}
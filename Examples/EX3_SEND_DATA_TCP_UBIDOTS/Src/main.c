@@ -7,19 +7,36 @@
   * 					  1. Hardware configuration for SIM management. You can use the function SIM800_Default_ConfigHW()
   * 					  which uses the default UART1 and pins B0 and B1 for powerKey and reset respectively.
   * 					  Otherwise use the SIM800_ConfigHW() function to define the UART and pins.
+  * 					  In this example the SIM responses are received by DMA with IDLE-line detection and
+  * 					  the commands are sent by DMA, selected with config_RX_Mode_UART() and config_TX_Mode_UART().
   * 					  2. Power up the SIM with the SIM800_On() function.
-  * 					  3. Initialize the SIM with the SIM800_Init() function.
-  * 					  This function configures the SIM in text mode for SMS functions and a baud rate of 9600
-  * 					  for communication with the SIM UART.
+  * 					  3. Initialize the SIM with the SIM800_Init_Baud() function.
+  * 					  This function configures the SIM in text mode for SMS functions and raises the baud rate
+  * 					  of the SIM UART to SIM800_BAUD_RATE, falling back to 9600 if the link cannot be verified.
   * 				  The sequence to send data via TCP is as follows:
   * 				  	1. Verify if the SIM800 is registered on the network. Use the check_Network_Registration() function.
   * 				  	2. Verify if the SIM800 is registered registered in the GPRS service. Use the check_GPRS_Connection() function.
+  * 				  	Steps 1 and 2 are done in a single command line with check_Network_GPRS_Registration().
   * 				  	3. Deactivate GPRS PDP(Packet Data Protocol) context. Use the function disable_GPRS_PDP_Context()
   * 				  	4. Configure the SIM in command mode. Use the function set_Application_Mode_TCPUDP()
   * 				  	5. Configure the APN (Access Point Name) and Bring up wireless connection with GPRS.
   * 				  	Use the functions setAPN() and bring_Up_Wireless_Connection().
   * 				  	6. Get Local IP Address and Start Up TCP/UDP Connection. Use the function start_Up_TCPUDP_Connection().
   * 				  	7. For send data use the function send_Data_TCPUDP().
+  * 				  This example keeps the connection open between readings with the connection manager instead:
+  * 				  SIM800_Link_Config() stores the APN and the server, SIM800_Link_Connect_Async() reads the state
+  * 				  with AT+CIPSTATUS and runs only the steps 3 to 6 that are missing, with TCP keepalive, and
+  * 				  each reading is sent with SIM800_Link_Send(). If the server closes
+  * 				  the connection or the network deactivates the PDP context, the connection is opened again
+  * 				  before the next reading. The main loop calls SIM800_Poll() on every iteration and continues
+  * 				  when the completion callback reports the result, so it never waits for the connection.
+  * 				  The period between readings is measured with a non-blocking delay_t.
+  * 				  Between two readings the SIM sleeps (AT+CSCLK=1), the DTR pin B5 wakes it up before the next
+  * 				  command and the RI pin B4 signals incoming calls, SMS or data through the EXTI4 interrupt.
+  * 				  While there are no commands in progress the MCU also sleeps with __WFI(): the SysTick, the
+  * 				  SIM UART and the RI interrupt wake it up. After each wake-up SIM800_Is_Ring_Indicated() is
+  * 				  checked, the incoming call is rejected and the stored SMS are deleted because this example
+  * 				  does not use them, the closing of the connection is handled by the connection manager.
   * @author	:	Yonatan Aguirre - PCSE CESE18 UBA
   ********************************************************************************************************************************
   * @attention
@@ -40,10 +57,22 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "SIM800x.h"
+#include "API_DelayNB.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
+typedef enum
+{
+  STATE_WAIT_PERIOD,
+  STATE_WAIT_CONNECTION
+}appState_t;
+
+typedef struct
+{
+  bool_t     done;
+  atResult_t result;
+}appCommand_t;
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
@@ -56,6 +85,10 @@
 #define SIZE_HTTP_BODY				100U
 #define SIZE_BUFFER_POST 			200U
 #define DELAY_SEND_DATA				2500LU
+#define SIM800_BAUD_RATE			115200LU
+#define SIM800_DTR_PIN				5U
+#define SIM800_RI_PIN					4U
+#define KEEP_ALIVE_TIME				60U
 #define FACT_CONV_N2T					0.02442F	/*< TEMP_MAX(100°C)/2^n-1 -- n:12 bits ADC*/
 /* USER CODE END PD */
 
@@ -74,6 +107,11 @@ uint8_t apn[10]="ENTER APN";
 uint8_t* buffer[SIZE_BUFFER_POST];
 float 	temperatura;
 /* USER CODE BEGIN PV */
+SIM800_t sim800;
+appState_t appState = STATE_WAIT_PERIOD;
+appCommand_t appCommand;
+delay_t delaySendData;
+linkConfigSIM_t ubidotsLink = {apn, (const uint8_t*)TCP, (const uint8_t*)IP_ADDRESS, (const uint8_t*)PORT, KEEP_ALIVE_TIME};
 
 /* USER CODE END PV */
 
@@ -85,6 +123,9 @@ static void MX_USART1_UART_Init(void);
 static void MX_ADC1_Init(void);
 /* USER CODE BEGIN PFP */
 uint8_t* ubidotsPOST( uint8_t* token,  uint8_t* variable_id, float value);
+void linkCompleted(uint8_t status, void *pContext);
+void sendTemperature(void);
+void handleRingIndication(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -104,6 +145,36 @@ uint8_t* ubidotsPOST( uint8_t* token,  uint8_t* variable_id, float value)
 
 	return buffer;
 }
+
+void linkCompleted(uint8_t status, void *pContext)
+{
+  appCommand_t *pCommand = (appCommand_t *)pContext;
+
+  pCommand->result = (status == OK) ? AT_RESULT_CONNECT_OK : AT_RESULT_CONNECT_FAIL;
+  pCommand->done = true;
+}
+
+void sendTemperature(void)
+{
+  uint8_t *post;
+
+  HAL_ADC_Start(&hadc1);
+  HAL_ADC_PollForConversion(&hadc1,HAL_MAX_DELAY);
+  temperatura = HAL_ADC_GetValue(&hadc1)*FACT_CONV_N2T;
+  post = ubidotsPOST(TOKEN,VARIABLE_ID,temperatura);
+
+  if(SIM800_Link_Send(&sim800, post, strlen((char*)post)) == OK)
+	  HAL_UART_Transmit(&huart2, (const uint8_t*)"DATA SENT\r", strlen("DATA SENT\r"), 1000);
+}
+
+void handleRingIndication(void)
+{
+  HAL_UART_Transmit(&huart2, (const uint8_t*)"RING\r", strlen("RING\r"), 1000);
+
+  /* The commands are queued, SIM800_Poll() completes them and the SIM sleeps again when they end */
+  SIM800_Send_Command(&sim800, SIM_CMD_ATH, NULL, NULL, NULL);
+  SIM800_Send_Command(&sim800, SIM_CMD_CMGD, (const uint8_t*)"1,4", NULL, NULL);
+}
 /* USER CODE END 0 */
 
 /**
@@ -143,52 +214,76 @@ int main(void)
 
   BSP_LED_On(LED_USER);
   /* USER CODE END 2 */
-  if(SIM800_Default_ConfigHW() == OK)
+  if(SIM800_Default_ConfigHW(&sim800) == OK && config_RX_Mode_UART(&sim800.port, RX_MODE_DMA) == SUCCESSFUL && config_TX_Mode_UART(&sim800.port, TX_MODE_DMA) == SUCCESSFUL)
   	  HAL_UART_Transmit(&huart2, (const uint8_t*)"HW SIM OK\r\n", strlen("HW SIM OK\r\n"), 1000);
   else
   	  HAL_UART_Transmit(&huart2, (const uint8_t*)"HW SIM NO CONFIG\r\n", strlen("HW SIM NO CONFIG\r\n"), 1000);
 
-  SIM800_On();
+  SIM800_On(&sim800);
   HAL_UART_Transmit(&huart2, (const uint8_t*)"SIM ACTIVATED\r\n", strlen("SIM ACTIVATED\r\n"), 1000);
 
-  if(SIM800_Init() == OK)
+  if(SIM800_Init_Baud(&sim800, SIM800_BAUD_RATE) == OK)
 	  HAL_UART_Transmit(&huart2, (const uint8_t*)"CONFIGURED\r", strlen("CONFIGURED\r"), 1000);
   else
 	  HAL_UART_Transmit(&huart2, (const uint8_t*)"FAIL\r", strlen("NOK\r"), 1000);
+
+  SIM800_Link_Config(&sim800, &ubidotsLink);
+  SIM800_Config_Sleep_Pins(&sim800, PORTB, SIM800_DTR_PIN, PORTB, SIM800_RI_PIN);
+  if(SIM800_Set_Sleep_Mode(&sim800, SIM_SLEEP_DTR) == OK)
+	  HAL_UART_Transmit(&huart2, (const uint8_t*)"SLEEP MODE\r", strlen("SLEEP MODE\r"), 1000);
+
+  delayInit(&delaySendData, DELAY_SEND_DATA);
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
     /* USER CODE END WHILE */
-	  if(check_Network_Registration()== OK && check_GPRS_Connection() == OK)
+	  SIM800_Poll(&sim800);
+
+	  switch(appState)
 	  {
-		  HAL_UART_Transmit(&huart2, (const uint8_t*)"NETWORK AND GPRS OK\r", strlen("NETWORK AND GPRS OK\r"), 1000);
+	  case STATE_WAIT_PERIOD:
+		  if(SIM800_Is_Ring_Indicated(&sim800) == true)
+			  handleRingIndication();
 
-		  if(disable_GPRS_PDP_Context() == OK)
-			  HAL_UART_Transmit(&huart2, (const uint8_t*)"GPRS CONTEXT DISABLE\r", strlen("GPRS CONTEXT DISABLE\r"), 1000);
+		  if(delayRead(&delaySendData) == true)
+		  {
+			  if(SIM800_Get_Link_State(&sim800) == SIM_LINK_UP)
+				  sendTemperature();
+			  else if(check_Network_GPRS_Registration(&sim800) == OK)
+			  {
+				  HAL_UART_Transmit(&huart2, (const uint8_t*)"NETWORK AND GPRS OK\r", strlen("NETWORK AND GPRS OK\r"), 1000);
 
-		  if(set_Application_Mode_TCPUDP(COMMAND_MODE) == OK)
-			  HAL_UART_Transmit(&huart2, (const uint8_t*)"COMMAND MODE\r", strlen("COMMAND MODE\r"), 1000);
+				  appCommand.done = false;
+				  if(SIM800_Link_Connect_Async(&sim800, linkCompleted, &appCommand) == OK)
+					  appState = STATE_WAIT_CONNECTION;
+			  }
+		  }
 
-		  if(setAPN(&apn) == OK && bring_Up_Wireless_Connection() == OK)
+		  /* Nothing to do until the next interrupt: the SIM and the MCU sleep */
+		  if((appState == STATE_WAIT_PERIOD) && (SIM800_Is_Busy(&sim800) == false))
 		  {
-			  HAL_UART_Transmit(&huart2, (const uint8_t*)"GPRS CONECTED\r", strlen("GPRS CONECTED\r"), 1000);
+			  SIM800_Sleep(&sim800);
+			  HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+		  }
+		  break;
 
-			  if(start_Up_TCPUDP_Connection((uint8_t*)TCP,(uint8_t*)IP_ADDRESS,(uint8_t*)PORT) == OK)
+	  case STATE_WAIT_CONNECTION:
+		  if(appCommand.done == true)
+		  {
+			  if(appCommand.result == AT_RESULT_CONNECT_OK)
 			  {
-				  HAL_UART_Transmit(&huart2, (const uint8_t*)"LOCAL IP OK\r", strlen("LOCAL IP OK\r"), 1000);
-
-				  HAL_ADC_Start(&hadc1);
-				  HAL_ADC_PollForConversion(&hadc1,HAL_MAX_DELAY);
-				  temperatura = HAL_ADC_GetValue(&hadc1)*FACT_CONV_N2T;
-				  send_Data_TCPUDP(ubidotsPOST(TOKEN,VARIABLE_ID,temperatura),COMMAND_MODE);
-
+				  HAL_UART_Transmit(&huart2, (const uint8_t*)"CONNECTED\r", strlen("CONNECTED\r"), 1000);
+				  sendTemperature();
 			  }
-			  close_TCPUDP_Connection();
-			  disable_GPRS_PDP_Context();
+			  appState = STATE_WAIT_PERIOD;
 		  }
+		  break;
+
+	  default:
+		  appState = STATE_WAIT_PERIOD;
+		  break;
 	  }
-	  HAL_Delay(DELAY_SEND_DATA);
     /* USER CODE BEGIN 3 */
   }
   /* USER CODE END 3 */
@@ -372,6 +467,35 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief  EXTI line detection callback, forwards the falling edge of the RI pin to the SIM driver.
+  * @param  GPIO_Pin: Specifies the pins connected EXTI line
+  * @retval None
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  irq_Handler_EXTI_SIM(GPIO_Pin);
+}
+
+/**
+  * @brief  Rx Half Transfer completed callback, forwards the DMA reception of the SIM UART to the driver.
+  * @param  huart: Pointer to the UART_Handle structure.
+  * @retval None
+  */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+  callback_DMA_RX_UART(huart);
+}
+
+/**
+  * @brief  Rx Transfer completed callback, forwards the DMA reception of the SIM UART to the driver.
+  * @param  huart: Pointer to the UART_Handle structure.
+  * @retval None
+  */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  callback_DMA_RX_UART(huart);
+}
 
 /* USER CODE END 4 */
 
@@ -0,0 +1,162 @@
+/**
+ * @file 	bench_at_matcher.c
+ * @brief	Host benchmark of the keyword search: at_Matcher_Step() over each byte of recorded SIM responses,
+ * 			as the tokenizer calls it, against one strstr() per keyword over the whole response.
+ * @note	Build and run with make from this directory. Both methods must find the same keywords.
+ * 			The driver uses the matcher to search the responses as they arrive, also in the bytes that do not fit
+ * 			in the response buffer, not for speed: on an x86 host with glibc it costs more cycles per byte than
+ * 			strstr(). The figures of a Cortex-M4 with newlib have not been measured.
+ * 			On x86 the cycles are read with the time stamp counter, on other hosts nanoseconds are reported.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "at_matcher.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT				"cycle"
+#define BENCH_NOW()				__rdtsc()
+#else
+#define BENCH_UNIT				"ns"
+#define BENCH_NOW()				now_Nanoseconds()
+#endif
+
+/**
+ * @def		N_PASSES
+ * @brief	Defines the number of times all the responses are searched with each method.
+ * */
+#define N_PASSES				50000UL
+
+/* Keywords searched by the driver during the start-up and the registration, in the order of SIM800x.c */
+static const char * const keywords[] = {
+	",1",
+	"CGATT: 1",
+	"RDY",
+	"+CFUN: 1",
+	"+CPIN: READY",
+	"Call Ready",
+	"SMS Ready",
+};
+
+#define N_KEYWORDS				(sizeof(keywords)/sizeof(keywords[0]))
+
+/* Responses recorded from a SIM800L with ATE1 */
+static const char * const responses[] = {
+	"\r\nRDY\r\n\r\n+CFUN: 1\r\n\r\n+CPIN: READY\r\n\r\nCall Ready\r\n\r\nSMS Ready\r\n",
+	"AT+CREG?\r\r\n+CREG: 0,1\r\n\r\nOK\r\n",
+	"AT+CREG?\r\r\n+CREG: 0,2\r\n\r\nOK\r\n",
+	"AT+CGATT?\r\r\n+CGATT: 1\r\n\r\nOK\r\n",
+	"AT+CSQ\r\r\n+CSQ: 18,0\r\n\r\nOK\r\n",
+	"AT+CMGR=3\r\r\n+CMGR: \"REC UNREAD\",\"+59170000000\",\"\",\"22/10/24,10:15:32-16\"\r\n"
+		"Reply to the report of 10:00, the level of tank 2 is 75%\r\n\r\nOK\r\n",
+	"AT+CIPSTART=\"TCP\",\"industrial.api.ubidots.com\",\"80\"\r\r\nOK\r\n\r\nCONNECT OK\r\n",
+};
+
+#define N_RESPONSES				(sizeof(responses)/sizeof(responses[0]))
+
+#if !(defined(__x86_64__) || defined(__i386__))
+/**
+ * @brief	Reads a monotonic clock.
+ * @retval	Nanoseconds.
+ */
+static unsigned long long now_Nanoseconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+}
+#endif
+
+/**
+ * @brief	Searches the keywords with the automaton, one byte at a time.
+ * @param	Pointer to the compiled matcher.
+ * @param	Pointer to the response.
+ * @retval	Mask of the keywords found.
+ */
+static uint32_t search_Matcher(const atMatcher_t *pMatcher, const char *pResponse)
+{
+	uint32_t hits = 0;
+	uint8_t state = 0;
+
+	while(*pResponse != '\0')
+		state = at_Matcher_Step(pMatcher, state, (uint8_t)*pResponse++, &hits);
+
+	return hits;
+}
+
+/**
+ * @brief	Searches the keywords with one strstr() each.
+ * @param	Pointer to the response.
+ * @retval	Mask of the keywords found.
+ */
+static uint32_t search_Strstr(const char *pResponse)
+{
+	uint32_t hits = 0;
+	uint8_t i;
+
+	for(i = 0; i < N_KEYWORDS; i++)
+	{
+		if(strstr(pResponse, keywords[i]) != NULL)
+			hits |= AT_MATCHER_HIT(i);
+	}
+
+	return hits;
+}
+
+int main(void)
+{
+	static atMatcher_t matcher;
+	volatile uint32_t sink = 0;
+	unsigned long long start;
+	unsigned long long matcherTime;
+	unsigned long long strstrTime;
+	unsigned long long bytes = 0;
+	unsigned int mismatches = 0;
+	unsigned long pass;
+	uint8_t i;
+
+	if(at_Matcher_Compile(&matcher, keywords, N_KEYWORDS) == false)
+	{
+		printf("at_matcher: the keywords do not fit in the automaton\n");
+		return 1;
+	}
+
+	for(i = 0; i < N_RESPONSES; i++)
+	{
+		bytes += strlen(responses[i]);
+		if(search_Matcher(&matcher, responses[i]) != search_Strstr(responses[i]))
+			mismatches++;
+	}
+
+	printf("%u keywords, %u states, %u responses, %u bytes, %lu passes\n", (unsigned int)N_KEYWORDS,
+			(unsigned int)matcher.nStates, (unsigned int)N_RESPONSES, (unsigned int)bytes, N_PASSES);
+
+	start = BENCH_NOW();
+	for(pass = 0; pass < N_PASSES; pass++)
+	{
+		for(i = 0; i < N_RESPONSES; i++)
+			sink += search_Matcher(&matcher, responses[i]);
+	}
+	matcherTime = BENCH_NOW() - start;
+
+	start = BENCH_NOW();
+	for(pass = 0; pass < N_PASSES; pass++)
+	{
+		for(i = 0; i < N_RESPONSES; i++)
+			sink += search_Strstr(responses[i]);
+	}
+	strstrTime = BENCH_NOW() - start;
+
+	bytes *= N_PASSES;
+	printf("at_Matcher_Step: %.2f %ss/byte\n", (double)matcherTime / (double)bytes, BENCH_UNIT);
+	printf("strstr x %u:     %.2f %ss/byte\n", (unsigned int)N_KEYWORDS, (double)strstrTime / (double)bytes, BENCH_UNIT);
+	printf("%s\n", (mismatches == 0) ? "same keywords found by both methods" : "the methods found different keywords");
+
+	(void)sink;
+	return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file 	bench_at_tokenizer.c
+ * @brief	Host benchmark of at_Tokenizer_Feed(): recorded SIM responses are fed in chunks of several sizes,
+ * 			as the engine peeks them from the RX ring buffer, and the throughput is reported in bytes per cycle.
+ * @note	Build and run with make from this directory. On x86 the cycles are read with the time stamp counter,
+ * 			on other hosts nanoseconds are reported instead.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "at_tokenizer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT				"cycle"
+#define BENCH_NOW()				__rdtsc()
+#else
+#define BENCH_UNIT				"ns"
+#define BENCH_NOW()				now_Nanoseconds()
+#endif
+
+/**
+ * @def		N_PASSES
+ * @brief	Defines the number of times the whole recording is fed for each chunk size.
+ *
+ * @def		RESPONSE_SIZE
+ * @brief	Defines the size of the response buffer, the same as SERIAL_RESPONSE_BUFFER_SIZE of the driver.
+ *
+ * @def		STREAM_SIZE
+ * @brief	Defines the size of the buffer where the recorded responses are joined.
+ * */
+#define N_PASSES				20000UL
+#define RESPONSE_SIZE			100U
+#define STREAM_SIZE				1024U
+
+/**
+ * @struct	recordedResponse_t
+ * @brief	Response recorded from the SIM and whether its command waits for the "> " prompt.
+ * */
+typedef struct
+{
+	const char	*pText;
+	bool_t		prompt;
+}recordedResponse_t;
+
+/* Responses recorded from a SIM800L with ATE1, in the order they were received */
+static const recordedResponse_t recording[] = {
+	{"AT\r\r\nOK\r\n", false},
+	{"AT+CSQ\r\r\n+CSQ: 18,0\r\n\r\nOK\r\n", false},
+	{"AT+CREG?\r\r\n+CREG: 0,1\r\n\r\nOK\r\n", false},
+	{"AT+CMGF=1\r\r\nOK\r\n", false},
+	{"\r\n+CMTI: \"SM\",3\r\nAT+CMGR=3\r\r\n+CMGR: \"REC UNREAD\",\"+59170000000\",\"\",\"22/10/24,10:15:32-16\"\r\n"
+			"> Reply to the report of 10:00, the level of tank 2 is 75%\r\n\r\nOK\r\n", false},
+	{"AT+CIPSTATUS\r\r\nOK\r\n", false},
+	{"\r\nSTATE: IP INITIAL\r\n", false},
+	{"AT+CSTT=\"internet.tigo.bo\"\r\r\nOK\r\n", false},
+	{"AT+CIICR\r\r\nOK\r\n", false},
+	{"AT+CIFSR\r\r\n10.120.45.8\r\n", false},
+	{"AT+CIPSTART=\"TCP\",\"industrial.api.ubidots.com\",\"80\"\r\r\nOK\r\n\r\nCONNECT OK\r\n", false},
+	{"AT+CIPSEND=120\r\r\n> POST /api/v1.6/devices/sim800 HTTP/1.1\r\nHost: industrial.api.ubidots.com\r\n\r\nSEND OK\r\n", true},
+	{"AT+CMGS=\"+59170000000\"\r\r\n> Tank 2 at 75%\x1A\r\n+CMGS: 12\r\n\r\nOK\r\n", true},
+	{"AT+CIPCLOSE\r\r\nCLOSE OK\r\n", false},
+	{"AT+CIPSHUT\r\r\nSHUT OK\r\n", false},
+};
+
+#define N_RESPONSES				(sizeof(recording)/sizeof(recording[0]))
+
+static const uint16_t chunkSizes[] = {1U, 7U, 64U, 128U};
+
+#if !(defined(__x86_64__) || defined(__i386__))
+/**
+ * @brief	Reads a monotonic clock.
+ * @retval	Nanoseconds.
+ */
+static unsigned long long now_Nanoseconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+}
+#endif
+
+/**
+ * @brief	Line filter with the URC handled by the examples, as the engine dispatches it.
+ * @param	Pointer to the line.
+ * @param	Length of the line.
+ * @param	Not used.
+ * @retval	Returns true if the line is a +CMTI URC.
+ */
+static bool_t filter_URC(const uint8_t *pLine, uint8_t length, void *pContext)
+{
+	(void)pContext;
+
+	return (length >= 6U) && (memcmp(pLine, "+CMTI:", 6U) == 0);
+}
+
+/**
+ * @brief	Joins the recorded responses in a single stream, as they arrive through the UART.
+ * @param	Pointer to the stream buffer.
+ * @param	Size of the stream buffer.
+ * @retval	Length of the stream.
+ */
+static uint16_t build_Stream(uint8_t *pStream, uint16_t size)
+{
+	uint16_t length = 0;
+	uint16_t textLength;
+	uint8_t i;
+
+	for(i = 0; i < N_RESPONSES; i++)
+	{
+		textLength = (uint16_t)strlen(recording[i].pText);
+		if(length + textLength <= size)
+		{
+			memcpy(&pStream[length], recording[i].pText, textLength);
+			length += textLength;
+		}
+	}
+
+	return length;
+}
+
+/**
+ * @brief	Feeds the whole stream in chunks, restarting the response after each final result code.
+ * @note	The prompt is expected during the responses of the commands that send data, as the engine does.
+ * @param	Pointer to the tokenizer.
+ * @param	Pointer to the response buffer.
+ * @param	Pointer to the stream.
+ * @param	Length of the stream.
+ * @param	Size of the chunks.
+ * @retval	Number of result codes recognized, the prompts included.
+ */
+static unsigned int feed_Stream(atTokenizer_t *pTokenizer, uint8_t *pResponse, const uint8_t *pStream, uint16_t length, uint16_t chunkSize)
+{
+	uint16_t position = 0;
+	uint16_t consumed;
+	uint16_t size;
+	unsigned int results = 0;
+	uint8_t index = 0;
+	atResult_t result;
+
+	at_Tokenizer_Set_Buffer(pTokenizer, pResponse, RESPONSE_SIZE);
+	at_Tokenizer_Expect_Prompt(pTokenizer, recording[0].prompt);
+
+	while(position < length)
+	{
+		size = ((length - position) < chunkSize) ? (uint16_t)(length - position) : chunkSize;
+		result = at_Tokenizer_Feed(pTokenizer, &pStream[position], size, &consumed);
+		position += consumed;
+
+		if(result != AT_RESULT_NONE)
+			results++;
+
+		if((result != AT_RESULT_NONE) && (result != AT_RESULT_PROMPT) && (++index < N_RESPONSES))
+		{
+			at_Tokenizer_Set_Buffer(pTokenizer, pResponse, RESPONSE_SIZE);
+			at_Tokenizer_Expect_Prompt(pTokenizer, recording[index].prompt);
+		}
+	}
+
+	return results;
+}
+
+int main(void)
+{
+	atTokenizer_t tokenizer;
+	uint8_t response[RESPONSE_SIZE];
+	uint8_t stream[STREAM_SIZE];
+	uint16_t length = build_Stream(stream, STREAM_SIZE);
+	unsigned long long start;
+	unsigned long long elapsed;
+	unsigned long long bytes = (unsigned long long)length * N_PASSES;
+	unsigned int results = 0;
+	unsigned long pass;
+	uint8_t i;
+
+	printf("recording: %u responses, %u bytes, %lu passes per chunk size\n", (unsigned int)N_RESPONSES,
+			(unsigned int)length, N_PASSES);
+
+	for(i = 0; i < sizeof(chunkSizes)/sizeof(chunkSizes[0]); i++)
+	{
+		at_Tokenizer_Init(&tokenizer, response, RESPONSE_SIZE);
+		at_Tokenizer_Set_Filter(&tokenizer, filter_URC, NULL);
+
+		start = BENCH_NOW();
+		for(pass = 0; pass < N_PASSES; pass++)
+			results = feed_Stream(&tokenizer, response, stream, length, chunkSizes[i]);
+		elapsed = BENCH_NOW() - start;
+
+		printf("chunk %3u: %u results per pass, %.3f bytes/%s, %.2f %ss/byte\n", chunkSizes[i], results,
+				(double)bytes / (double)elapsed, BENCH_UNIT, (double)elapsed / (double)bytes, BENCH_UNIT);
+	}
+
+	return 0;
+}
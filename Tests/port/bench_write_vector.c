@@ -0,0 +1,159 @@
+/**
+ * @file 	bench_write_vector.c
+ * @brief	Host benchmark of the cost of sending an AT command with port.c in TX_MODE_BLOCKING: one write_Data_UART()
+ * 			per piece of the command, as the driver did before write_Vector_UART(), against the single
+ * 			write_Vector_UART() of the command line and the terminator used by the AT engine.
+ * @note	Build and run with make from this directory. The HAL is replaced by hal_stub.c, which keeps the CPU work of
+ * 			HAL_UART_Transmit() but not the time of the bytes on the line nor the DMA mode.
+ * 			On x86 the cycles are read with the time stamp counter, on other hosts nanoseconds are reported.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "port.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT				"cycle"
+#define BENCH_NOW()				__rdtsc()
+#else
+#define BENCH_UNIT				"ns"
+#define BENCH_NOW()				now_Nanoseconds()
+#endif
+
+/**
+ * @def		N_PASSES
+ * @brief	Defines the number of times all the commands are sent with each method.
+ * */
+#define N_PASSES				100000UL
+
+/**
+ * @struct	benchCommand_t
+ * @brief	Command split as the old send_Write_Execution_AT_CMD() sent it, and the command line built by the engine.
+ * */
+typedef struct
+{
+	const char *pCommand;
+	const char *pValue;
+	const char *pLine;
+}benchCommand_t;
+
+static const benchCommand_t commands[] = {
+	{"CMGF", "1", "AT+CMGF=1"},
+	{"CNMI", "2,1,0,0,0", "AT+CNMI=2,1,0,0,0"},
+	{"CMGS", "\"+59170000000\"", "AT+CMGS=\"+59170000000\""},
+	{"CIPSTART", "\"TCP\",\"industrial.api.ubidots.com\",\"80\"", "AT+CIPSTART=\"TCP\",\"industrial.api.ubidots.com\",\"80\""},
+};
+
+#define N_COMMANDS				(sizeof(commands)/sizeof(commands[0]))
+
+extern unsigned long stubTransmitCalls;
+extern unsigned long stubTransmitBytes;
+
+#if !(defined(__x86_64__) || defined(__i386__))
+/**
+ * @brief	Reads a monotonic clock.
+ * @retval	Nanoseconds.
+ */
+static unsigned long long now_Nanoseconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+}
+#endif
+
+/**
+ * @brief	Sends a command with five write_Data_UART(), as send_Write_Execution_AT_CMD() did.
+ * @param	Pointer to the port of the SIM.
+ * @param	Pointer to the command.
+ * @retval	None.
+ */
+static void send_Pieces(portSIM_t *pPort, const benchCommand_t *pCommand)
+{
+	write_Data_UART(pPort, (uint8_t *)"AT+");
+	write_Data_UART(pPort, (uint8_t *)pCommand->pCommand);
+	write_Data_UART(pPort, (uint8_t *)"=");
+	write_Data_UART(pPort, (uint8_t *)pCommand->pValue);
+	write_Data_UART(pPort, (uint8_t *)"\r");
+}
+
+/**
+ * @brief	Sends a command with one write_Vector_UART(), as start_Command_Engine() does.
+ * @param	Pointer to the port of the SIM.
+ * @param	Pointer to the command.
+ * @retval	None.
+ */
+static void send_Vector(portSIM_t *pPort, const benchCommand_t *pCommand)
+{
+	ioVector_t commandLine[] = {
+		{(const uint8_t *)pCommand->pLine, (uint16_t)strlen(pCommand->pLine)},
+		IO_VECTOR_STRING("\r")
+	};
+
+	write_Vector_UART(pPort, commandLine, sizeof(commandLine)/sizeof(commandLine[0]));
+}
+
+/**
+ * @brief	Sends all the commands N_PASSES times with a method.
+ * @param	Pointer to the port of the SIM.
+ * @param	Method used to send each command.
+ * @param	Name of the method.
+ * @retval	Bytes sent per command, used to check that both methods send the same data.
+ */
+static double run_Method(portSIM_t *pPort, void (*send)(portSIM_t *, const benchCommand_t *), const char *pName)
+{
+	unsigned long long start;
+	unsigned long long elapsed;
+	unsigned long sent = N_PASSES * N_COMMANDS;
+	unsigned long pass;
+	uint8_t i;
+
+	stubTransmitCalls = 0;
+	stubTransmitBytes = 0;
+
+	start = BENCH_NOW();
+	for(pass = 0; pass < N_PASSES; pass++)
+	{
+		for(i = 0; i < N_COMMANDS; i++)
+			send(pPort, &commands[i]);
+	}
+	elapsed = BENCH_NOW() - start;
+
+	printf("%-18s %8.1f %ss/command, %.1f HAL_UART_Transmit() calls/command\n", pName,
+			(double)elapsed / (double)sent, BENCH_UNIT, (double)stubTransmitCalls / (double)sent);
+
+	return (double)stubTransmitBytes / (double)sent;
+}
+
+int main(void)
+{
+	static portSIM_t port;
+	static UART_HandleTypeDef uartHandler;
+	double piecesBytes;
+	double vectorBytes;
+
+	uartHandler.Instance = USART1;
+	uartHandler.Init.BaudRate = 9600;
+
+	if(config_UART_SIM(&port, &uartHandler) == UNSUCCESSFUL)
+	{
+		printf("port: the UART could not be configured\n");
+		return 1;
+	}
+
+	printf("%u commands, %lu passes, TX_MODE_BLOCKING\n", (unsigned int)N_COMMANDS, N_PASSES);
+
+	piecesBytes = run_Method(&port, send_Pieces, "write_Data_UART x5");
+	vectorBytes = run_Method(&port, send_Vector, "write_Vector_UART");
+
+	printf("%.1f bytes/command, %s\n", vectorBytes, (piecesBytes == vectorBytes) ? "same data sent by both methods" :
+			"the methods sent different data");
+
+	return (piecesBytes == vectorBytes) ? 0 : 1;
+}
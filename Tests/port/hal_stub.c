@@ -0,0 +1,161 @@
+/**
+ * @file 	hal_stub.c
+ * @brief	Host implementation of the HAL functions used by port.c.
+ * @note	HAL_UART_Transmit() follows the steps of the STM32F4 HAL blocking transmission: state and lock checks,
+ * 			a wait for TXE and a write of DR for each byte, and a final wait for TC. The flags are always set,
+ * 			so the CPU cost of the HAL is kept and the time of the bytes on the line is left out.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include "stm32f4xx_hal.h"
+
+USART_TypeDef stubUSART[3];
+DMA_Stream_TypeDef stubDMAStream[6];
+GPIO_TypeDef stubGPIO[3];
+
+/* Statistics of the transmissions, read by the benchmark */
+unsigned long stubTransmitCalls = 0;
+unsigned long stubTransmitBytes = 0;
+
+static uint32_t stubTick = 0;
+
+static HAL_StatusTypeDef wait_Flag_Stub(UART_HandleTypeDef *huart, uint32_t flag, uint32_t tickStart, uint32_t timeout);
+
+uint32_t HAL_GetTick(void)
+{
+	return stubTick++;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+	return 50000000UL;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+	return 100000000UL;
+}
+
+void HAL_Delay(uint32_t delay)
+{
+	stubTick += delay;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preemptPriority, uint32_t subPriority)
+{
+	(void)irq;
+	(void)preemptPriority;
+	(void)subPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq)
+{
+	(void)irq;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+	(void)GPIOx;
+	(void)GPIO_Init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	if(PinState == GPIO_PIN_SET)
+		GPIOx->ODR |= GPIO_Pin;
+	else
+		GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+	return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+	huart->Instance->SR = USART_SR_TXE | USART_SR_TC;
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	huart->Lock = 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+	HAL_StatusTypeDef status = HAL_BUSY;
+	uint32_t tickStart;
+	uint16_t i;
+
+	if((huart->gState == HAL_UART_STATE_READY) && (huart->Lock == 0))
+	{
+		huart->Lock = 1;
+		huart->ErrorCode = 0;
+		huart->gState = HAL_UART_STATE_BUSY_TX;
+		tickStart = HAL_GetTick();
+		huart->Lock = 0;
+		status = HAL_OK;
+
+		for(i = 0; (i < Size) && (status == HAL_OK); i++)
+		{
+			status = wait_Flag_Stub(huart, USART_SR_TXE, tickStart, Timeout);
+			huart->Instance->DR = pData[i];
+		}
+
+		if(status == HAL_OK)
+			status = wait_Flag_Stub(huart, USART_SR_TC, tickStart, Timeout);
+
+		huart->gState = HAL_UART_STATE_READY;
+		stubTransmitCalls++;
+		stubTransmitBytes += Size;
+	}
+
+	return status;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+	(void)huart;
+	(void)pData;
+	(void)Size;
+	return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+	(void)huart;
+	(void)pData;
+	(void)Size;
+	return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart)
+{
+	(void)huart;
+	return HAL_OK;
+}
+
+/**
+ * @brief	Waits for a flag of the status register, as UART_WaitOnFlagUntilTimeout() of the HAL.
+ * @retval	HAL_OK when the flag is set, HAL_TIMEOUT otherwise.
+ */
+static HAL_StatusTypeDef wait_Flag_Stub(UART_HandleTypeDef *huart, uint32_t flag, uint32_t tickStart, uint32_t timeout)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+
+	while(((huart->Instance->SR & flag) == 0) && (status == HAL_OK))
+	{
+		if((HAL_GetTick() - tickStart) > timeout)
+			status = HAL_TIMEOUT;
+	}
+
+	return status;
+}
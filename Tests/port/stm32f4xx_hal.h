@@ -0,0 +1,236 @@
+/**
+ * @file 	stm32f4xx_hal.h
+ * @brief	Host replacement of the STM32F4 HAL header, with only the types, registers and functions used by
+ * 			port.c, so the port layer can be compiled and measured on a host.
+ * @note	The peripherals are plain structures in memory. The functions are implemented in hal_stub.c.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#ifndef TESTS_PORT_STM32F4XX_HAL_H_
+#define TESTS_PORT_STM32F4XX_HAL_H_
+
+#include <stdint.h>
+
+#define USE_HAL_UART_REGISTER_CALLBACKS				0U
+
+typedef enum
+{
+	HAL_OK = 0,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT
+}HAL_StatusTypeDef;
+
+typedef enum
+{
+	EXTI0_IRQn, EXTI9_5_IRQn, EXTI15_10_IRQn, USART1_IRQn, USART2_IRQn, USART6_IRQn,
+	DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn
+}IRQn_Type;
+
+typedef struct
+{
+	volatile uint32_t SR;
+	volatile uint32_t DR;
+	volatile uint32_t BRR;
+	volatile uint32_t CR1;
+	volatile uint32_t CR2;
+	volatile uint32_t CR3;
+	volatile uint32_t GTPR;
+}USART_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t CR;
+	volatile uint32_t NDTR;
+	volatile uint32_t PAR;
+	volatile uint32_t M0AR;
+}DMA_Stream_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t ODR;
+}GPIO_TypeDef;
+
+typedef struct
+{
+	uint32_t Pin;
+	uint32_t Mode;
+	uint32_t Pull;
+	uint32_t Speed;
+	uint32_t Alternate;
+}GPIO_InitTypeDef;
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+}GPIO_PinState;
+
+typedef struct
+{
+	uint32_t Channel;
+	uint32_t Direction;
+	uint32_t PeriphInc;
+	uint32_t MemInc;
+	uint32_t PeriphDataAlignment;
+	uint32_t MemDataAlignment;
+	uint32_t Mode;
+	uint32_t Priority;
+	uint32_t FIFOMode;
+}DMA_InitTypeDef;
+
+typedef struct
+{
+	DMA_Stream_TypeDef	*Instance;
+	DMA_InitTypeDef		Init;
+	void				*Parent;
+}DMA_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t BaudRate;
+	uint32_t WordLength;
+	uint32_t StopBits;
+	uint32_t Parity;
+	uint32_t Mode;
+	uint32_t HwFlowCtl;
+	uint32_t OverSampling;
+}UART_InitTypeDef;
+
+typedef enum
+{
+	HAL_UART_STATE_RESET = 0,
+	HAL_UART_STATE_READY,
+	HAL_UART_STATE_BUSY_TX
+}HAL_UART_StateTypeDef;
+
+typedef struct
+{
+	USART_TypeDef			*Instance;
+	UART_InitTypeDef		Init;
+	DMA_HandleTypeDef		*hdmatx;
+	DMA_HandleTypeDef		*hdmarx;
+	volatile uint32_t		Lock;
+	volatile HAL_UART_StateTypeDef gState;
+	volatile HAL_UART_StateTypeDef RxState;
+	volatile uint32_t		ErrorCode;
+}UART_HandleTypeDef;
+
+extern USART_TypeDef stubUSART[3];
+extern DMA_Stream_TypeDef stubDMAStream[6];
+extern GPIO_TypeDef stubGPIO[3];
+
+#define USART1										(&stubUSART[0])
+#define USART2										(&stubUSART[1])
+#define USART6										(&stubUSART[2])
+#define DMA1_Stream5								(&stubDMAStream[0])
+#define DMA1_Stream6								(&stubDMAStream[1])
+#define DMA2_Stream1								(&stubDMAStream[2])
+#define DMA2_Stream2								(&stubDMAStream[3])
+#define DMA2_Stream6								(&stubDMAStream[4])
+#define DMA2_Stream7								(&stubDMAStream[5])
+#define GPIOA										(&stubGPIO[0])
+#define GPIOB										(&stubGPIO[1])
+#define GPIOC										(&stubGPIO[2])
+
+#define USART_SR_PE									0x0001U
+#define USART_SR_FE									0x0002U
+#define USART_SR_NE									0x0004U
+#define USART_SR_ORE								0x0008U
+#define USART_SR_IDLE								0x0010U
+#define USART_SR_RXNE								0x0020U
+#define USART_SR_TC									0x0040U
+#define USART_SR_TXE								0x0080U
+#define USART_CR1_TCIE								0x0040U
+#define USART_CR3_DMAR								0x0040U
+
+#define UART_IT_PE									0x0100U
+#define UART_IT_TC									0x0040U
+#define UART_IT_RXNE								0x0020U
+#define UART_IT_IDLE								0x0010U
+#define UART_IT_ERR									0x0001U
+#define UART_WORDLENGTH_8B							0U
+#define UART_STOPBITS_1								0U
+#define UART_PARITY_NONE							0U
+#define UART_MODE_TX_RX								0x000CU
+#define UART_HWCONTROL_NONE							0U
+#define UART_HWCONTROL_RTS_CTS						0x0300U
+#define UART_OVERSAMPLING_16						0U
+#define UART_OVERSAMPLING_8							0x8000U
+
+#define HAL_UART_RX_HALFCOMPLETE_CB_ID				2U
+#define HAL_UART_RX_COMPLETE_CB_ID					3U
+
+#define DMA_CHANNEL_4								0x08000000U
+#define DMA_CHANNEL_5								0x0A000000U
+#define DMA_PERIPH_TO_MEMORY						0U
+#define DMA_MEMORY_TO_PERIPH						0x40U
+#define DMA_PINC_DISABLE							0U
+#define DMA_MINC_ENABLE								0x400U
+#define DMA_PDATAALIGN_BYTE							0U
+#define DMA_MDATAALIGN_BYTE							0U
+#define DMA_NORMAL									0U
+#define DMA_CIRCULAR								0x100U
+#define DMA_PRIORITY_MEDIUM							0x10000U
+#define DMA_PRIORITY_HIGH							0x20000U
+#define DMA_FIFOMODE_DISABLE						0U
+
+#define GPIO_PIN_0									0x0001U
+#define GPIO_PIN_1									0x0002U
+#define GPIO_PIN_2									0x0004U
+#define GPIO_PIN_3									0x0008U
+#define GPIO_PIN_4									0x0010U
+#define GPIO_PIN_5									0x0020U
+#define GPIO_PIN_6									0x0040U
+#define GPIO_PIN_7									0x0080U
+#define GPIO_PIN_8									0x0100U
+#define GPIO_PIN_9									0x0200U
+#define GPIO_PIN_10									0x0400U
+#define GPIO_PIN_11									0x0800U
+#define GPIO_PIN_12									0x1000U
+#define GPIO_PIN_13									0x2000U
+#define GPIO_PIN_14									0x4000U
+#define GPIO_PIN_15									0x8000U
+#define GPIO_MODE_OUTPUT_PP							1U
+#define GPIO_MODE_AF_PP								2U
+#define GPIO_MODE_IT_FALLING						0x10210000U
+#define GPIO_NOPULL									0U
+#define GPIO_PULLUP									1U
+#define GPIO_SPEED_FREQ_LOW							0U
+#define GPIO_SPEED_FREQ_VERY_HIGH					3U
+#define GPIO_AF7_USART1								7U
+#define GPIO_AF7_USART2								7U
+
+#define ATOMIC_SET_BIT(reg, bit)					((reg) |= (bit))
+#define ATOMIC_CLEAR_BIT(reg, bit)					((reg) &= ~(bit))
+#define __HAL_UART_ENABLE_IT(handle, it)			((handle)->Instance->CR1 |= (it))
+#define __HAL_UART_DISABLE_IT(handle, it)			((handle)->Instance->CR1 &= ~(it))
+#define __HAL_UART_CLEAR_PEFLAG(handle)				((void)(handle)->Instance->SR, (void)(handle)->Instance->DR)
+#define __HAL_UART_CLEAR_IDLEFLAG(handle)			__HAL_UART_CLEAR_PEFLAG(handle)
+#define __HAL_DMA_GET_COUNTER(handle)				((handle)->Instance->NDTR)
+#define __HAL_LINKDMA(parent, field, dma)			do{ (parent)->field = &(dma); (dma).Parent = (parent); }while(0)
+#define __HAL_RCC_GPIOA_CLK_ENABLE()				((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()				((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()				((void)0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()					((void)0)
+#define __HAL_RCC_DMA2_CLK_ENABLE()					((void)0)
+
+uint32_t			HAL_GetTick(void);
+uint32_t			HAL_RCC_GetPCLK1Freq(void);
+uint32_t			HAL_RCC_GetPCLK2Freq(void);
+void				HAL_Delay(uint32_t delay);
+void				HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preemptPriority, uint32_t subPriority);
+void				HAL_NVIC_EnableIRQ(IRQn_Type irq);
+void				HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void				HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+HAL_StatusTypeDef	HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+void				HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef	HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef	HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef	HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef	HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef	HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+
+#endif /* TESTS_PORT_STM32F4XX_HAL_H_ */
@@ -0,0 +1,299 @@
+/**
+ * @file 	test_ring_buffer.c
+ * @brief	Host test of the ring buffer: full and empty rings, wrap-around of the storage and of the
+ * 			16-bit indexes, and a producer thread racing the consumer as the UART interrupt does.
+ * @note	Build and run with make from this directory. It returns 0 if all the checks pass.
+ * @version 1.0
+ * @date	24/10/2022
+ * @author	Yonatan Aguirre
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "ring_buffer.h"
+
+/**
+ * @def		RING_SIZE
+ * @brief	Defines a small storage, so the tests wrap around it many times.
+ *
+ * @def		N_RACE_BYTES
+ * @brief	Defines the number of bytes sent by the producer thread, more than the range of the 16-bit indexes.
+ * */
+#define RING_SIZE				16U
+#define N_RACE_BYTES			300000UL
+
+/**
+ * @def		CHECK
+ * @brief	Counts and reports a failed condition without stopping the test.
+ * */
+#define CHECK(condition)		check_Condition((condition), #condition, __LINE__)
+
+static unsigned int failures = 0;
+static ringBuffer_t raceRing;
+static uint8_t raceStorage[RING_SIZE];
+
+static void check_Condition(bool_t condition, const char *pText, int line);
+static void test_Init(void);
+static void test_Empty_And_Full(void);
+static void test_Wrap_Around(void);
+static void test_Peek_Skip(void);
+static void test_Index_Overflow(void);
+static void test_Producer_Consumer(void);
+static void *producer_Thread(void *pArgument);
+
+int main(void)
+{
+	test_Init();
+	test_Empty_And_Full();
+	test_Wrap_Around();
+	test_Peek_Skip();
+	test_Index_Overflow();
+	test_Producer_Consumer();
+
+	if(failures == 0)
+		printf("ring_buffer: all tests passed\n");
+	else
+		printf("ring_buffer: %u checks failed\n", failures);
+
+	return (failures == 0) ? 0 : 1;
+}
+
+/**
+ * @brief	Reports a failed condition.
+ * @param	Result of the condition.
+ * @param	Text of the condition.
+ * @param	Line of the check.
+ * @retval	None.
+ */
+static void check_Condition(bool_t condition, const char *pText, int line)
+{
+	if(condition == false)
+	{
+		printf("line %d: %s\n", line, pText);
+		failures++;
+	}
+}
+
+/**
+ * @brief	Only storages with a size power of two are accepted.
+ * @retval	None.
+ */
+static void test_Init(void)
+{
+	ringBuffer_t ring;
+	uint8_t storage[RING_SIZE];
+
+	CHECK(ring_Buffer_Init(&ring, storage, RING_SIZE) == true);
+	CHECK(ring_Buffer_Init(&ring, storage, 12U) == false);
+	CHECK(ring_Buffer_Init(&ring, storage, 0U) == false);
+	CHECK(ring_Buffer_Init(&ring, NULL, RING_SIZE) == false);
+}
+
+/**
+ * @brief	An empty ring returns nothing and a full ring refuses new bytes without losing the stored ones.
+ * @retval	None.
+ */
+static void test_Empty_And_Full(void)
+{
+	ringBuffer_t ring;
+	uint8_t storage[RING_SIZE];
+	uint8_t data[RING_SIZE];
+	const uint8_t *pData;
+	uint8_t byte;
+	uint16_t i;
+
+	ring_Buffer_Init(&ring, storage, RING_SIZE);
+	CHECK(ring_Buffer_Count(&ring) == 0);
+	CHECK(ring_Buffer_Free(&ring) == RING_SIZE);
+	CHECK(ring_Buffer_Get(&ring, &byte) == false);
+	CHECK(ring_Buffer_Read(&ring, data, sizeof(data)) == 0);
+	CHECK(ring_Buffer_Peek(&ring, &pData) == 0);
+
+	for(i = 0; i < RING_SIZE; i++)
+		CHECK(ring_Buffer_Put(&ring, (uint8_t)i) == true);
+
+	CHECK(ring_Buffer_Put(&ring, 0xFFU) == false);
+	CHECK(ring_Buffer_Count(&ring) == RING_SIZE);
+	CHECK(ring_Buffer_Free(&ring) == 0);
+
+	CHECK(ring_Buffer_Read(&ring, data, sizeof(data)) == RING_SIZE);
+	for(i = 0; i < RING_SIZE; i++)
+		CHECK(data[i] == i);
+
+	CHECK(ring_Buffer_Count(&ring) == 0);
+
+	ring_Buffer_Put(&ring, 1U);
+	ring_Buffer_Flush(&ring);
+	CHECK(ring_Buffer_Get(&ring, &byte) == false);
+}
+
+/**
+ * @brief	The bytes are returned in order when they wrap around the end of the storage.
+ * @retval	None.
+ */
+static void test_Wrap_Around(void)
+{
+	ringBuffer_t ring;
+	uint8_t storage[RING_SIZE];
+	uint8_t data[RING_SIZE];
+	uint8_t byte;
+	uint16_t i;
+	uint16_t count;
+
+	ring_Buffer_Init(&ring, storage, RING_SIZE);
+
+	for(i = 0; i < RING_SIZE - 4U; i++)
+		ring_Buffer_Put(&ring, 0U);
+	for(i = 0; i < RING_SIZE - 4U; i++)
+		ring_Buffer_Get(&ring, &byte);
+
+	/* The next 10 bytes start 4 bytes before the end of the storage */
+	for(i = 0; i < 10U; i++)
+		CHECK(ring_Buffer_Put(&ring, (uint8_t)(100U + i)) == true);
+
+	count = ring_Buffer_Read(&ring, data, 6U);
+	CHECK(count == 6U);
+	for(i = 0; i < count; i++)
+		CHECK(data[i] == 100U + i);
+
+	for(i = 6U; i < 10U; i++)
+		CHECK((ring_Buffer_Get(&ring, &byte) == true) && (byte == 100U + i));
+}
+
+/**
+ * @brief	Peek only returns the contiguous bytes up to the end of the storage, the rest after Skip.
+ * @retval	None.
+ */
+static void test_Peek_Skip(void)
+{
+	ringBuffer_t ring;
+	uint8_t storage[RING_SIZE];
+	const uint8_t *pData;
+	uint8_t byte;
+	uint16_t i;
+
+	ring_Buffer_Init(&ring, storage, RING_SIZE);
+
+	for(i = 0; i < RING_SIZE - 3U; i++)
+		ring_Buffer_Put(&ring, 0U);
+	for(i = 0; i < RING_SIZE - 3U; i++)
+		ring_Buffer_Get(&ring, &byte);
+	for(i = 0; i < 8U; i++)
+		ring_Buffer_Put(&ring, (uint8_t)(50U + i));
+
+	CHECK(ring_Buffer_Peek(&ring, &pData) == 3U);
+	CHECK((pData[0] == 50U) && (pData[2] == 52U));
+	ring_Buffer_Skip(&ring, 3U);
+
+	CHECK(ring_Buffer_Peek(&ring, &pData) == 5U);
+	CHECK((pData == storage) && (pData[0] == 53U) && (pData[4] == 57U));
+	ring_Buffer_Skip(&ring, 2U);
+	CHECK(ring_Buffer_Count(&ring) == 3U);
+	CHECK(ring_Buffer_Free(&ring) == RING_SIZE - 3U);
+}
+
+/**
+ * @brief	Count, Free and the full ring detection keep working when the 16-bit indexes overflow.
+ * @retval	None.
+ */
+static void test_Index_Overflow(void)
+{
+	ringBuffer_t ring;
+	uint8_t storage[RING_SIZE];
+	uint8_t byte;
+	uint16_t i;
+
+	ring_Buffer_Init(&ring, storage, RING_SIZE);
+	ring.head = 0xFFF8U;
+	ring.tail = 0xFFF8U;
+
+	for(i = 0; i < RING_SIZE; i++)
+		CHECK(ring_Buffer_Put(&ring, (uint8_t)i) == true);
+
+	CHECK(ring.head == (uint16_t)(0xFFF8U + RING_SIZE));
+	CHECK(ring_Buffer_Put(&ring, 0xFFU) == false);
+	CHECK(ring_Buffer_Count(&ring) == RING_SIZE);
+	CHECK(ring_Buffer_Free(&ring) == 0);
+
+	for(i = 0; i < RING_SIZE; i++)
+		CHECK((ring_Buffer_Get(&ring, &byte) == true) && (byte == i));
+}
+
+/**
+ * @brief	A producer thread stores a known sequence while the consumer extracts it with Get, Read and
+ * 			Peek/Skip in turn. Every byte must arrive once and in order.
+ * @retval	None.
+ */
+static void test_Producer_Consumer(void)
+{
+	pthread_t producer;
+	uint8_t data[RING_SIZE];
+	const uint8_t *pData;
+	unsigned long received = 0;
+	unsigned long errors = 0;
+	unsigned int turn = 0;
+	uint16_t count;
+	uint16_t i;
+
+	ring_Buffer_Init(&raceRing, raceStorage, RING_SIZE);
+	CHECK(pthread_create(&producer, NULL, producer_Thread, NULL) == 0);
+
+	while(received < N_RACE_BYTES)
+	{
+		switch(turn++ % 3U)
+		{
+			case 0:
+				count = (ring_Buffer_Get(&raceRing, &data[0]) == true) ? 1U : 0U;
+				break;
+
+			case 1:
+				count = ring_Buffer_Read(&raceRing, data, (uint16_t)(1U + (turn % RING_SIZE)));
+				break;
+
+			default:
+				count = ring_Buffer_Peek(&raceRing, &pData);
+				for(i = 0; i < count; i++)
+					data[i] = pData[i];
+				ring_Buffer_Skip(&raceRing, count);
+				break;
+		}
+
+		/* On a single core the producer only runs if the consumer gives up the processor */
+		if(count == 0)
+			sched_yield();
+
+		for(i = 0; i < count; i++)
+		{
+			if(data[i] != (uint8_t)(received * 7UL))
+				errors++;
+			received++;
+		}
+	}
+
+	pthread_join(producer, NULL);
+	CHECK(errors == 0);
+	CHECK(ring_Buffer_Count(&raceRing) == 0);
+}
+
+/**
+ * @brief	Producer of the race test, it plays the role of the UART interrupt.
+ * @param	Not used.
+ * @retval	NULL.
+ */
+static void *producer_Thread(void *pArgument)
+{
+	unsigned long sent = 0;
+
+	(void)pArgument;
+
+	while(sent < N_RACE_BYTES)
+	{
+		if(ring_Buffer_Put(&raceRing, (uint8_t)(sent * 7UL)) == true)
+			sent++;
+		else
+			sched_yield();
+	}
+
+	return NULL;
+}